@@ -32,7 +32,7 @@
  * compatible, thus CINDEX_VERSION_MAJOR is expected to remain stable.
  */
 #define CINDEX_VERSION_MAJOR 0
-#define CINDEX_VERSION_MINOR 43
+#define CINDEX_VERSION_MINOR 44
 
 #define CINDEX_VERSION_ENCODE(major, minor) ( \
       ((major) * 10000)                       \
@@ -1292,7 +1292,17 @@ enum CXTranslationUnit_Flags {
   /**
    * \brief Sets the preprocessor in a mode for parsing a single file only.
    */
-  CXTranslationUnit_SingleFileParse = 0x400
+  CXTranslationUnit_SingleFileParse = 0x400,
+
+  /**
+   * \brief Used to indicate that function/method bodies outside the main file
+   * should be skipped while parsing.
+   *
+   * Unlike \c CXTranslationUnit_SkipFunctionBodies, the skipped bodies are not
+   * lost: they are parsed on demand, e.g. when a cursor visitor descends into
+   * the function or when a function template is instantiated.
+   */
+  CXTranslationUnit_SkipHeaderFunctionBodies = 0x800
 };
 
 /**
@@ -0,0 +1,103 @@
+//===--- ASTAllocationStats.h - Memory used by AST nodes --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the ASTAllocationStats class, which charges the memory
+//  allocated for declarations and statements in an ASTContext to their kind
+//  and to the source file they come from, for -print-stats.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_AST_ASTALLOCATIONSTATS_H
+#define LLVM_CLANG_AST_ASTALLOCATIONSTATS_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Allocator.h"
+#include <cstdint>
+
+namespace clang {
+
+class SourceManager;
+class Type;
+
+/// \brief Accounts for the memory allocated for AST nodes, by node kind and
+/// by source file.
+///
+/// Like the Decl and Stmt statistics it extends, tagging is process-wide: at
+/// most one instance is active at a time, and it is only enabled for
+/// -print-stats. Decl::operator new and Stmt::operator new note each
+/// allocation, which the node's constructor then charges to its kind and
+/// file. Nodes allocated some other way are charged their static size.
+///
+/// Nodes without a valid location, such as statements and implicit
+/// declarations, are charged to the file of the last node that had one.
+/// Types are shared by the whole translation unit and are only accounted
+/// for by kind.
+class ASTAllocationStats {
+public:
+  enum NodeCategory { NC_Decl, NC_Stmt, NC_NumCategories };
+
+  explicit ASTAllocationStats(const SourceManager &SM);
+  ~ASTAllocationStats();
+
+  ASTAllocationStats(const ASTAllocationStats &) = delete;
+  ASTAllocationStats &operator=(const ASTAllocationStats &) = delete;
+
+  /// \brief Get the active instance, or null if allocations are not being
+  /// tagged.
+  static ASTAllocationStats *getActive() { return Active; }
+
+  /// \brief Make this the active instance.
+  void activate() { Active = this; }
+
+  /// \brief Note that \p Size bytes at \p Ptr were allocated for a node that
+  /// is about to be constructed.
+  void noteAllocation(const void *Ptr, size_t Size) {
+    LastAllocation = static_cast<const char *>(Ptr);
+    LastAllocationSize = Size;
+  }
+
+  /// \brief Charge a newly constructed node to its kind and file.
+  ///
+  /// \param Kind The name of the node's kind, which must outlive this object.
+  /// \param StaticSize The size of the node's class, which is charged if the
+  /// node's allocation was not noted.
+  void addNode(NodeCategory Category, const char *Kind, const void *Node,
+               size_t StaticSize, SourceLocation Loc);
+
+  /// \brief Print a report of the memory used by the nodes in a context, and
+  /// of its allocator's slabs, as a JSON object.
+  void printJSON(raw_ostream &OS, const llvm::BumpPtrAllocator &Alloc,
+                 ArrayRef<Type *> Types) const;
+
+private:
+  struct Usage {
+    uint64_t Count = 0;
+    uint64_t Bytes = 0;
+  };
+
+  static ASTAllocationStats *Active;
+
+  const SourceManager &SM;
+
+  const char *LastAllocation = nullptr;
+  size_t LastAllocationSize = 0;
+
+  /// The file of the last node that had a valid location.
+  FileID CurrentFile;
+
+  llvm::DenseMap<const char *, Usage> Kinds[NC_NumCategories];
+  llvm::DenseMap<FileID, Usage> Files;
+};
+
+} // end namespace clang
+
+#endif
@@ -79,6 +79,7 @@ struct fltSemantics;
 
 namespace clang {
 
+class ASTAllocationStats;
 class ASTMutationListener;
 class ASTRecordLayout;
 class AtomicExpr;
@@ -226,6 +227,22 @@ class ASTContext : public RefCountedBase<ASTContext> {
   llvm::DenseMap<const MaterializeTemporaryExpr *, APValue *>
     MaterializedTemporaryValues;
 
+public:
+  /// \brief The value of a constexpr function call, with the number of
+  /// evaluation steps and the call depth its evaluation took.
+  struct ConstexprCallResult {
+    APValue Value;
+    unsigned Steps;
+    unsigned Depth;
+  };
+
+private:
+  /// \brief Values of constexpr function calls that were evaluated without
+  /// side-effects from literal argument values, keyed by an encoding of the
+  /// callee, evaluation mode and arguments built by the constant evaluator.
+  llvm::StringMap<ConstexprCallResult> ConstexprCallResults;
+  enum { MaxConstexprCallResults = 1 << 16 };
+
   /// \brief Representation of a "canonical" template template parameter that
   /// is used in canonical template names.
   class CanonicalTemplateTemplateParm : public llvm::FoldingSetNode {
@@ -489,6 +506,14 @@ private:
   /// \brief Allocator for partial diagnostics.
   PartialDiagnostic::StorageAllocator DiagAllocator;
 
+  /// \brief The accounting of the memory allocated for AST nodes, if it has
+  /// been enabled.
+  std::unique_ptr<ASTAllocationStats> AllocationStats;
+
+  /// \brief The memory of the statements released by discardFunctionBody,
+  /// by size. Each free block holds a pointer to the next one of its size.
+  mutable llvm::DenseMap<size_t, void *> RecycledStmts;
+
   /// \brief The current C++ ABI.
   std::unique_ptr<CXXABI> ABI;
   CXXABI *createCXXABI(const TargetInfo &T);
@@ -628,11 +653,43 @@ public:
   }
   void Deallocate(void *Ptr) const { }
 
+  /// \brief Get memory for a new statement from the statements released by
+  /// discardFunctionBody, or null if none of them has the requested size.
+  void *allocateRecycledStmt(size_t Size, unsigned Align) const {
+    if (RecycledStmts.empty())
+      return nullptr;
+    return allocateRecycledStmtSlow(Size, Align);
+  }
+
+  /// \brief Replace the body of a function definition with an empty compound
+  /// statement, and release the memory of its statements for reuse by new
+  /// statements.
+  ///
+  /// This is only safe once nothing will look at the body again: the function
+  /// must have been emitted, and must not be a template, an instantiation, or
+  /// inline or constexpr. Bodies that contain lambdas, blocks or captured
+  /// statements are left alone. The initializers of the variables declared
+  /// in the body are kept, since their declarations still refer to them;
+  /// the labels declared in the body lose their statements, and the parent
+  /// map is dropped.
+  ///
+  /// \returns true if the body was discarded.
+  bool discardFunctionBody(FunctionDecl *FD);
+
   /// Return the total amount of physical memory allocated for representing
   /// AST nodes and type information.
   size_t getASTAllocatedMemory() const {
     return BumpAlloc.getTotalMemory();
   }
+  /// Return the number of bytes allocated so far for representing AST nodes
+  /// and type information, not counting the slack in the allocator's slabs.
+  size_t getASTAllocatedBytes() const {
+    return BumpAlloc.getBytesAllocated();
+  }
+
+  /// \brief Start charging the memory allocated for declarations and
+  /// statements to their kind and source file. PrintStats will report it.
+  void enableAllocationStats();
   /// Return the total memory used for various side tables.
   size_t getSideTableAllocatedMemory() const;
 
@@ -2559,6 +2616,23 @@ public:
   APValue *getMaterializedTemporaryValue(const MaterializeTemporaryExpr *E,
                                          bool MayCreate);
 
+  /// \brief Get the memoized result of the constexpr function call with the
+  /// given key, or null if there is none.
+  const ConstexprCallResult *getConstexprCallResult(StringRef Key) const {
+    auto It = ConstexprCallResults.find(Key);
+    return It == ConstexprCallResults.end() ? nullptr : &It->second;
+  }
+
+  /// \brief Memoize the result of the constexpr function call with the given
+  /// key. The memoized results are dropped once there are
+  /// MaxConstexprCallResults of them, so that the table stays bounded.
+  void setConstexprCallResult(StringRef Key, const APValue &Value,
+                              unsigned Steps, unsigned Depth) {
+    if (ConstexprCallResults.size() >= MaxConstexprCallResults)
+      ConstexprCallResults.clear();
+    ConstexprCallResults[Key] = ConstexprCallResult{Value, Steps, Depth};
+  }
+
   //===--------------------------------------------------------------------===//
   //                    Statistics
   //===--------------------------------------------------------------------===//
@@ -2605,6 +2679,35 @@ public:
   /// declarations were built.
   static unsigned NumImplicitDestructorsDeclared;
 
+  /// \brief The number of constexpr function calls whose value was taken
+  /// from, or could not be found in, the memoized results.
+  static unsigned NumConstexprCallCacheHits;
+  static unsigned NumConstexprCallCacheMisses;
+
+  /// \brief The number of evaluation steps saved by memoized constexpr
+  /// function calls.
+  static uint64_t NumConstexprStepsSaved;
+
+  /// \brief The number of function bodies released by discardFunctionBody,
+  /// the bytes of statements they held, and how many of those bytes were
+  /// reused for new statements.
+  static unsigned NumDiscardedFunctionBodies;
+  static uint64_t NumDiscardedStmtBytes;
+  static uint64_t NumRecycledStmtBytes;
+
+  /// \brief The number of lookup tables that were large enough for further
+  /// declarations to only be added to them when their name is looked up.
+  static unsigned NumLargeLookupTables;
+
+  /// \brief The bytes of heap memory currently used to hold the declarations
+  /// that have not been added to large lookup tables yet.
+  static uint64_t NumPendingLookupBytes;
+
+  /// \brief The number of declarations whose addition to a large lookup table
+  /// was deferred, and the number of those that were added to it later.
+  static unsigned NumDeferredLookupDecls;
+  static unsigned NumLoadedDeferredLookupDecls;
+
 public:
   /// \brief Initialize built-in types.
   ///
@@ -2618,6 +2721,8 @@ public:
 private:
   void InitBuiltinType(CanQualType &R, BuiltinType::Kind K);
 
+  void *allocateRecycledStmtSlow(size_t Size, unsigned Align) const;
+
   // Return the Objective-C type encoding for a given type.
   void getObjCEncodingForTypeImpl(QualType t, std::string &S,
                                   bool ExpandPointedToStructures,
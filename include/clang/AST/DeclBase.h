@@ -958,7 +958,7 @@ public:
   SourceLocation getBodyRBrace() const;
 
   // global temp stats (until we have a per-module visitor)
-  static void add(Kind k);
+  void add(Kind k);
   static void EnableStatistics();
   static void PrintStats();
 
@@ -1897,7 +1897,10 @@ private:
   friend class DependentDiagnostic;
   StoredDeclsMap *CreateStoredDeclsMap(ASTContext &C) const;
 
+  StoredDeclsMap *buildPartialLookup();
   void buildLookupImpl(DeclContext *DCtx, bool Internal);
+  void loadPendingLookupDecls(DeclarationName Name) const;
+  void loadAllPendingLookupDecls() const;
   void makeDeclVisibleInContextWithFlags(NamedDecl *D, bool Internal,
                                          bool Rediscoverable);
   void makeDeclVisibleInContextImpl(NamedDecl *D, bool Internal);
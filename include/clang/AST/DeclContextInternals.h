@@ -22,6 +22,8 @@
 #include "llvm/ADT/PointerUnion.h"
 #include "llvm/ADT/SmallVector.h"
 #include <algorithm>
+#include <memory>
+#include <vector>
 
 namespace clang {
 
@@ -236,6 +238,46 @@ public:
   }
 };
 
+/// \brief Declarations that have been made visible in a very large
+/// DeclContext but not yet added to its lookup table.
+///
+/// The declarations are kept in buckets by the hash of their name, in the
+/// order in which they were made visible, so that the declarations with a
+/// given name can be found without adding an entry for every name to the
+/// lookup table.
+class PendingLookupDecls {
+public:
+  PendingLookupDecls();
+  ~PendingLookupDecls();
+
+  bool empty() const { return Size == 0; }
+  unsigned size() const { return Size; }
+
+  /// \brief Add a declaration, which must be newer than all of the other
+  /// declarations with its name.
+  void add(NamedDecl *D);
+
+  /// \brief Remove the declarations with the given name and append them to
+  /// \p Decls, oldest first.
+  void take(DeclarationName Name, SmallVectorImpl<NamedDecl *> &Decls);
+
+  /// \brief Remove all of the declarations and append them to \p Decls. The
+  /// declarations with any one name are appended oldest first.
+  void takeAll(SmallVectorImpl<NamedDecl *> &Decls);
+
+private:
+  typedef SmallVector<NamedDecl *, 8> BucketTy;
+
+  BucketTy &getBucket(DeclarationName Name);
+  void grow();
+
+  /// \brief The bytes of heap memory used by the buckets.
+  size_t getMemorySize() const;
+
+  std::vector<BucketTy> Buckets;
+  unsigned Size;
+};
+
 class StoredDeclsMap
   : public llvm::SmallDenseMap<DeclarationName, StoredDeclsList, 4> {
 
@@ -246,6 +288,11 @@ private:
   friend class ASTContext; // walks the chain deleting these
   friend class DeclContext;
   llvm::PointerIntPair<StoredDeclsMap*, 1> Previous;
+
+  /// \brief The declarations that have not been added to the map yet, or
+  /// null if all of the declarations in the context have been. See
+  /// DeclContext::makeDeclVisibleInContextImpl.
+  std::unique_ptr<PendingLookupDecls> Pending;
 };
 
 class DependentStoredDeclsMap : public StoredDeclsMap {
@@ -91,6 +91,7 @@ inline DeclContext::all_lookups_iterator DeclContext::lookups_end() const {
 
 inline DeclContext::lookups_range DeclContext::noload_lookups() const {
   DeclContext *Primary = const_cast<DeclContext*>(this)->getPrimaryContext();
+  Primary->loadAllPendingLookupDecls();
   if (StoredDeclsMap *Map = Primary->getLookupPtr())
     return lookups_range(all_lookups_iterator(Map->begin(), Map->end()),
                          all_lookups_iterator(Map->end(), Map->end()));
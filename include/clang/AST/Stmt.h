@@ -371,7 +371,7 @@ public:
   SourceLocation getLocEnd() const LLVM_READONLY;
 
   // global temp stats (until we have a per-module visitor)
-  static void addStmtClass(const StmtClass s);
+  void addStmtClass(const StmtClass s);
   static void EnableStatistics();
   static void PrintStats();
 
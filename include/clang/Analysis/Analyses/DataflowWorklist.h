@@ -0,0 +1,80 @@
+//===- DataflowWorklist.h - Worklists for CFG dataflow analyses --*- C++ --*-//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the worklists shared by the dataflow analyses that run on
+// source-level CFGs, which hand out the blocks in reverse post order for
+// forward analyses and in post order for backward analyses.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_ANALYSIS_ANALYSES_DATAFLOWWORKLIST_H
+#define LLVM_CLANG_ANALYSIS_ANALYSES_DATAFLOWWORKLIST_H
+
+#include "clang/Analysis/CFG.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include <utility>
+#include <vector>
+
+namespace clang {
+
+class AnalysisDeclContext;
+class PostOrderCFGView;
+
+/// \brief A worklist of CFG blocks that always hands out the enqueued block
+/// that comes first in the order of the analysis.
+///
+/// Visiting the blocks in that order lets the values of a block be computed
+/// from the final values of all its inputs, except along back edges, so that
+/// each block is visited once for every iteration of the loops around it
+/// rather than once for every change of one of its inputs. The priority of
+/// each block is looked up by block ID, so the ordering costs no map lookups.
+class DataflowWorklistBase {
+  typedef std::pair<unsigned, const CFGBlock *> Entry;
+
+  /// The priority of each block, indexed by block ID. Lower comes first.
+  std::vector<unsigned> Priorities;
+  llvm::BitVector EnqueuedBlocks;
+  /// A binary min-heap of the enqueued blocks, keyed by priority.
+  SmallVector<Entry, 20> Heap;
+
+protected:
+  DataflowWorklistBase(const CFG &cfg, const PostOrderCFGView &POV,
+                       bool IsForward);
+
+public:
+  /// Add a block to the worklist, unless it is null or already enqueued.
+  void enqueueBlock(const CFGBlock *Block);
+
+  /// Remove the block that comes first from the worklist, or return null if
+  /// the worklist is empty.
+  const CFGBlock *dequeue();
+};
+
+/// A worklist that hands out blocks in reverse post order, for analyses that
+/// propagate values from the predecessors of a block to its successors.
+class ForwardDataflowWorklist : public DataflowWorklistBase {
+public:
+  ForwardDataflowWorklist(const CFG &cfg, AnalysisDeclContext &Ctx);
+
+  void enqueueSuccessors(const CFGBlock *Block);
+};
+
+/// A worklist that hands out blocks in post order, for analyses that
+/// propagate values from the successors of a block to its predecessors.
+class BackwardDataflowWorklist : public DataflowWorklistBase {
+public:
+  BackwardDataflowWorklist(const CFG &cfg, AnalysisDeclContext &Ctx);
+
+  void enqueuePredecessors(const CFGBlock *Block);
+};
+
+} // end namespace clang
+
+#endif
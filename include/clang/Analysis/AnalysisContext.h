@@ -406,10 +406,15 @@ private:
 };
 
 class AnalysisDeclContextManager {
-  typedef llvm::DenseMap<const Decl *, std::unique_ptr<AnalysisDeclContext>>
-      ContextMap;
+  struct CachedContext {
+    std::unique_ptr<AnalysisDeclContext> Context;
+    /// The value of UseCount when the context was last requested.
+    unsigned LastUse = 0;
+  };
+  typedef llvm::DenseMap<const Decl *, CachedContext> ContextMap;
 
   ContextMap Contexts;
+  unsigned UseCount = 0;
   LocationContextManager LocContexts;
   CFG::BuildOptions cfgBuildOptions;
 
@@ -475,6 +480,12 @@ public:
   /// Discard all previously created AnalysisDeclContexts.
   void clear();
 
+  /// Discard the AnalysisDeclContexts that were requested least recently,
+  /// until at most \p MaxContexts of them remain. The CFGs and the managed
+  /// analyses of the others are then reused when their declarations are
+  /// analyzed or inlined again.
+  void trim(unsigned MaxContexts);
+
 private:
   friend class AnalysisDeclContext;
 
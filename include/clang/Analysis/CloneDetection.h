@@ -16,7 +16,9 @@
 #define LLVM_CLANG_AST_CLONEDETECTION_H
 
 #include "clang/AST/StmtVisitor.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Regex.h"
+#include <cstdint>
 #include <vector>
 
 namespace clang {
@@ -348,6 +350,60 @@ struct FilenamePatternConstraint {
   }
 };
 
+/// The type II hash and the source range of a StmtSequence, which outlive the
+/// AST of the sequence.
+struct CloneFingerprint {
+  /// The type II hash of the sequence. It is computed from the same data as
+  /// the hashes of RecursiveCloneTypeIIHashConstraint, but in a way that does
+  /// not depend on the host.
+  uint64_t Hash;
+  /// A second, independent hash of the sequence. Clones with the same hash
+  /// but different profiles are the result of a hash collision.
+  uint64_t Profile;
+  /// The index of the file of the sequence in CloneFingerprintSet::Files.
+  unsigned File;
+  unsigned BeginLine, BeginColumn, EndLine, EndColumn;
+};
+
+/// The fingerprints of the clone candidates of one or more translation units.
+///
+/// The CloneDetector needs the ASTs of all clones at once, so it can only
+/// find clones within a translation unit. To find clones across a whole
+/// project, the fingerprints of each translation unit are written to disk and
+/// merged by clang-clone-merge, which groups them by hash. As the ASTs are gone
+/// by then, such groups are not verified like the ones found by
+/// RecursiveCloneTypeIIVerifyConstraint; the profiles of the fingerprints are
+/// compared instead, to split groups formed by hash collisions.
+class CloneFingerprintSet {
+public:
+  /// The files of the fingerprints.
+  std::vector<std::string> Files;
+  std::vector<CloneFingerprint> Fingerprints;
+
+  /// The number of translation units the fingerprints were taken from.
+  unsigned NumTranslationUnits = 0;
+  /// The number of lines in the main files of the translation units.
+  uint64_t NumLines = 0;
+
+  /// Adds the fingerprints of the given sequences and all of their
+  /// sub-sequences whose complexity is at least \p MinComplexity, as one
+  /// translation unit whose main file has \p NumMainFileLines lines.
+  void addTranslationUnit(const CloneDetector::CloneGroup &Sequences,
+                          unsigned MinComplexity, unsigned NumMainFileLines);
+
+  /// Writes the fingerprints in a line-based text format.
+  void write(raw_ostream &OS) const;
+
+  /// Adds the fingerprints written by write() to this set.
+  /// \returns false if \p Buffer is malformed.
+  bool read(StringRef Buffer);
+
+private:
+  unsigned getFileIndex(StringRef File);
+
+  llvm::StringMap<unsigned> FileIndexes;
+};
+
 /// Analyzes the pattern of the referenced variables in a statement.
 class VariablePattern {
 
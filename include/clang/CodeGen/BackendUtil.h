@@ -17,6 +17,7 @@
 namespace llvm {
   class BitcodeModule;
   template <typename T> class Expected;
+  class Function;
   class Module;
   class MemoryBufferRef;
 }
@@ -47,6 +48,35 @@ namespace clang {
   void EmbedBitcode(llvm::Module *M, const CodeGenOptions &CGOpts,
                     llvm::MemoryBufferRef Buf);
 
+  /// Whether CodeGen runs the passes that EmitBackendOutput would run on each
+  /// function before the passes on the whole module, with an
+  /// EarlyFunctionPassRunner, in which case EmitBackendOutput skips them.
+  bool ShouldPipelineFunctionPasses(const CodeGenOptions &CGOpts,
+                                    const LangOptions &LOpts);
+
+  /// Runs the passes that EmitBackendOutput runs on each function before the
+  /// passes on the whole module, so that they can run on a function as soon
+  /// as its IR is complete (-fpipelined-codegen).
+  class EarlyFunctionPassRunner {
+  public:
+    EarlyFunctionPassRunner(DiagnosticsEngine &Diags,
+                            const HeaderSearchOptions &HeaderOpts,
+                            const CodeGenOptions &CGOpts,
+                            const TargetOptions &TOpts,
+                            const LangOptions &LOpts, llvm::Module *M);
+    ~EarlyFunctionPassRunner();
+
+    /// Run the passes on \p F.
+    void run(llvm::Function &F);
+
+    /// Finish running the passes once they have run on every function.
+    void finish();
+
+  private:
+    class Impl;
+    std::unique_ptr<Impl> TheImpl;
+  };
+
   llvm::Expected<llvm::BitcodeModule>
   FindThinLTOModule(llvm::MemoryBufferRef MBRef);
 }
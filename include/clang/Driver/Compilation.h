@@ -108,6 +108,26 @@ class Compilation {
   /// Whether an error during the parsing of the input args.
   bool ContainsError;
 
+  /// The maximum number of jobs to run at the same time.
+  unsigned NumParallelJobs;
+
+  /// Print \p C if -v or CC_PRINT_OPTIONS ask for it.
+  ///
+  /// \return Whether the command could be logged.
+  bool LogCommand(const Command &C) const;
+
+  /// Execute the jobs in \p Jobs on up to NumParallelJobs threads, starting
+  /// each job once the jobs producing its inputs have succeeded.
+  ///
+  /// The output of each job is captured and replayed in job order, and the
+  /// jobs after the first failing one are treated as if they never ran, so
+  /// the result is the same as running the jobs one after the other.
+  ///
+  /// \return false if the jobs could not be set up for parallel execution.
+  bool ExecuteJobsInParallel(
+      const JobList &Jobs,
+      SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const;
+
 public:
   Compilation(const Driver &D, const ToolChain &DefaultToolChain,
               llvm::opt::InputArgList *Args,
@@ -264,6 +284,9 @@ public:
 
   /// ExecuteJob - Execute a single job.
   ///
+  /// Independent jobs run in parallel when getNumParallelJobs() is greater
+  /// than one.
+  ///
   /// \param FailingCommands - For non-zero results, this will be a vector of
   /// failing commands and their associated result code.
   void ExecuteJobs(
@@ -281,6 +304,12 @@ public:
   /// Return whether an error during the parsing of the input args.
   bool containsError() const { return ContainsError; }
 
+  /// Return the maximum number of jobs to run at the same time.
+  unsigned getNumParallelJobs() const { return NumParallelJobs; }
+
+  /// Set the maximum number of jobs to run at the same time.
+  void setNumParallelJobs(unsigned N) { NumParallelJobs = N; }
+
   /// Redirect - Redirect output of this compilation. Can only be done once.
   ///
   /// \param Redirects - array of pointers to paths. The array
@@ -201,6 +201,12 @@ public:
   /// Whether the driver is generating diagnostics for debugging purposes.
   unsigned CCGenDiagnostics : 1;
 
+  /// Entry point of the integrated cc1 tool, used to run -cc1 jobs in the
+  /// driver process instead of re-executing the driver; see CC1Command.
+  /// \p ArgV holds the executable followed by the arguments of the job.
+  typedef int (*CC1ToolFunc)(ArrayRef<const char *> ArgV);
+  CC1ToolFunc CC1Main = nullptr;
+
 private:
   /// Default target triple.
   std::string DefaultTargetTriple;
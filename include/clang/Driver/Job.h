@@ -58,6 +58,10 @@ class Command {
   /// The list of program arguments which are inputs.
   llvm::opt::ArgStringList InputFilenames;
 
+  /// The files written by the action that created the command, as recorded
+  /// by the driver.
+  llvm::opt::ArgStringList OutputFilenames;
+
   /// Response file name, if this command is set to use one, or nullptr
   /// otherwise
   const char *ResponseFile;
@@ -125,8 +129,50 @@ public:
 
   const llvm::opt::ArgStringList &getArguments() const { return Arguments; }
 
+  const llvm::opt::ArgStringList &getInputFilenames() const {
+    return InputFilenames;
+  }
+
+  const llvm::opt::ArgStringList &getOutputFilenames() const {
+    return OutputFilenames;
+  }
+
+  void addOutputFilename(const char *Filename) {
+    OutputFilenames.push_back(Filename);
+  }
+
   /// Print a command argument, and optionally quote it.
   static void printArg(llvm::raw_ostream &OS, StringRef Arg, bool Quote);
+
+  /// Whether the command runs in the driver process rather than in a process
+  /// of its own. Only a CC1Command can run in the driver process.
+  bool isInProcess() const { return InProcess; }
+  void setInProcess(bool V) { InProcess = V; }
+
+protected:
+  /// See Command::isInProcess.
+  bool InProcess = false;
+};
+
+/// Like Command, but runs the integrated cc1 tool in the driver process
+/// instead of creating a new process, when the driver provides it.
+class CC1Command : public Command {
+public:
+  CC1Command(const Action &Source, const Tool &Creator,
+             const char *Executable, const ArgStringList &Arguments,
+             ArrayRef<InputInfo> Inputs);
+
+  void Print(llvm::raw_ostream &OS, const char *Terminator, bool Quote,
+             CrashReportInfo *CrashInfo = nullptr) const override;
+
+  int Execute(const StringRef **Redirects, std::string *ErrMsg,
+              bool *ExecutionFailed) const override;
+
+  /// Abandon the job that runs in process on the current thread, if any,
+  /// making its Execute return \p ExitStatus as a cc1 process would. This is
+  /// how cc1 reports fatal errors, which must not exit the driver. Returns
+  /// only if no job runs in process on the current thread.
+  static void exitInProcessJob(int ExitStatus);
 };
 
 /// Like Command, but with a fallback which is executed in case
@@ -204,6 +204,10 @@ public:
   /// the summary and module symbol table (and not, e.g. any debug metadata).
   std::string ThinLinkBitcodeFile;
 
+  /// With -fparallel-codegen, the object file the first partition is written
+  /// to. Partition I is written to "<file>.I".
+  std::string ParallelCodeGenOutputFile;
+
   /// A list of file names passed with -fcuda-include-gpubinary options to
   /// forward to CUDA runtime back-end for incorporating them into host-side
   /// object file.
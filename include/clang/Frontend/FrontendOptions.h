@@ -186,6 +186,10 @@ public:
                                            /// speed up parsing in cases you do
                                            /// not need them (e.g. with code
                                            /// completion).
+  unsigned SkipHeaderFunctionBodies : 1;   ///< Skip over function bodies
+                                           /// outside the main file, keeping
+                                           /// their tokens so that they can
+                                           /// be parsed on demand.
   unsigned UseGlobalModuleIndex : 1;       ///< Whether we can use the
                                            ///< global module index if available.
   unsigned GenerateGlobalModuleIndex : 1;  ///< Whether we can generate the
@@ -324,13 +328,17 @@ public:
   /// Filename to write statistics to.
   std::string StatsFile;
 
+  /// Filename to write the template instantiation profile to.
+  std::string TemplateProfileFile;
+
 public:
   FrontendOptions() :
     DisableFree(false), RelocatablePCH(false), ShowHelp(false),
     ShowStats(false), ShowTimers(false), ShowVersion(false),
     FixWhatYouCan(false), FixOnlyWarnings(false), FixAndRecompile(false),
     FixToTemporaries(false), ARCMTMigrateEmitARCErrors(false),
-    SkipFunctionBodies(false), UseGlobalModuleIndex(true),
+    SkipFunctionBodies(false), SkipHeaderFunctionBodies(false),
+    UseGlobalModuleIndex(true),
     GenerateGlobalModuleIndex(true), ASTDumpDecls(false), ASTDumpLookups(false),
     BuildingImplicitModule(false), ModulesEmbedAllFiles(false),
     IncludeTimestamps(true), ARCMTAction(ARCMT_None),
@@ -44,8 +44,13 @@ namespace clang {
 
   /// \brief Parse the main file known to the preprocessor, producing an 
   /// abstract syntax tree.
+  ///
+  /// \param SkipHeaderFunctionBodies Whether to skip parsing of function
+  /// bodies outside the main file. Their tokens are kept so that they can be
+  /// parsed on demand through Sema::LateParseFunctionBody().
   void ParseAST(Sema &S, bool PrintStats = false,
-                bool SkipFunctionBodies = false);
+                bool SkipFunctionBodies = false,
+                bool SkipHeaderFunctionBodies = false);
 
 }  // end namespace clang
 
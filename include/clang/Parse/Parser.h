@@ -259,15 +259,25 @@ class Parser : public CodeCompletionHandler {
   /// declarations/definitions when indexing.
   bool SkipFunctionBodies;
 
+  /// Whether to skip parsing of function bodies outside the main file.
+  ///
+  /// The tokens of skipped bodies are kept, the same way delayed templates
+  /// are, so that they can be parsed on demand.
+  bool SkipHeaderFunctionBodies;
+
   /// The location of the expression statement that is being parsed right now.
   /// Used to determine if an expression that is being parsed is a statement or
   /// just a regular sub-expression.
   SourceLocation ExprStatementTokLoc;
 
 public:
-  Parser(Preprocessor &PP, Sema &Actions, bool SkipFunctionBodies);
+  Parser(Preprocessor &PP, Sema &Actions, bool SkipFunctionBodies,
+         bool SkipHeaderFunctionBodies = false);
   ~Parser() override;
 
+  /// \brief Destroys a parser owned by Sema; see Sema::SetLateParserDeleter.
+  static void LateParserDeleterCallback(void *P);
+
   const LangOptions &getLangOpts() const { return PP.getLangOpts(); }
   const TargetInfo &getTargetInfo() const { return PP.getTargetInfo(); }
   Preprocessor &getPreprocessor() const { return PP; }
@@ -1249,6 +1259,17 @@ private:
   static void LateTemplateParserCallback(void *P, LateParsedTemplate &LPT);
   static void LateTemplateParserCleanupCallback(void *P);
 
+  /// \brief Whether the body of the function definition starting at the
+  /// current token should be skipped and stored for parsing on demand.
+  ///
+  /// Members of local classes are left alone: their bodies can refer to the
+  /// enclosing function's scope, which is gone by the time we get to them.
+  bool isLazyFunctionBodyCandidate() const {
+    return SkipHeaderFunctionBodies && !SkipFunctionBodies &&
+           !cast<Decl>(Actions.CurContext)->getParentFunctionOrMethod() &&
+           !PP.getSourceManager().isInMainFile(Tok.getLocation());
+  }
+
   Sema::ParsingClassState
   PushParsingClass(Decl *TagOrTemplate, bool TopLevelClass, bool IsInterface);
   void DeallocateParsedClasses(ParsingClass *Class);
@@ -16,7 +16,9 @@
 #define LLVM_CLANG_REWRITE_CORE_HTMLREWRITE_H
 
 #include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/DenseMap.h"
 #include <string>
+#include <vector>
 
 namespace clang {
 
@@ -26,6 +28,23 @@ class Preprocessor;
 
 namespace html {
 
+  /// RelexRewriteCache - The highlighting that SyntaxHighlight and
+  /// HighlightMacros computed for each file.  Relexing a file, and above all
+  /// re-preprocessing it to find the macro expansions, dominates the cost of
+  /// rendering it, so clients that render the same file many times keep one
+  /// of these to only do it once per file.
+  struct RelexRewriteCache {
+    struct RawHighlight {
+      unsigned B, E;
+      std::string StartTag, EndTag;
+    };
+    typedef std::vector<RawHighlight> HighlightList;
+    typedef llvm::DenseMap<FileID, HighlightList> HighlightMap;
+
+    HighlightMap SyntaxHighlights;
+    HighlightMap MacroHighlights;
+  };
+
   /// HighlightRange - Highlight a range in the source code with the specified
   /// start/end tags.  B/E must be in the same file.  This ensures that
   /// start/end tags are placed at the start/end of each line if the range is
@@ -66,14 +85,18 @@ namespace html {
                                          StringRef title);
 
   /// SyntaxHighlight - Relex the specified FileID and annotate the HTML with
-  /// information about keywords, comments, etc.
-  void SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP);
+  /// information about keywords, comments, etc.  If a cache is given, the
+  /// file is only relexed the first time it is highlighted.
+  void SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP,
+                       RelexRewriteCache *Cache = nullptr);
 
   /// HighlightMacros - This uses the macro table state from the end of the
   /// file, to reexpand macros and insert (into the HTML) information about the
   /// macro expansions.  This won't be perfectly perfect, but it will be
-  /// reasonably close.
-  void HighlightMacros(Rewriter &R, FileID FID, const Preprocessor &PP);
+  /// reasonably close.  If a cache is given, the macros are only reexpanded
+  /// the first time the file is highlighted.
+  void HighlightMacros(Rewriter &R, FileID FID, const Preprocessor &PP,
+                       RelexRewriteCache *Cache = nullptr);
 
 } // end html namespace
 } // end clang namespace
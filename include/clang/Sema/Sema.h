@@ -174,6 +174,7 @@ namespace clang {
   class TemplateDecl;
   class TemplateParameterList;
   class TemplatePartialOrderingContext;
+  class TemplateProfile;
   class TemplateTemplateParmDecl;
   class Token;
   class TypeAliasDecl;
@@ -629,6 +630,25 @@ public:
     OpaqueParser = P;
   }
 
+  /// \brief Callback used to destroy the parser once Sema owns it.
+  ///
+  /// Sema takes ownership of the parser when function bodies were skipped
+  /// and their tokens kept, so that they can still be parsed on demand after
+  /// the end of the translation unit.
+  typedef void LateParserDeleterCB(void *P);
+  LateParserDeleterCB *LateParserDeleter;
+
+  void SetLateParserDeleter(LateParserDeleterCB *Deleter) {
+    LateParserDeleter = Deleter;
+  }
+
+  /// \brief Parse the body of a function whose tokens were stored for late
+  /// parsing, either because it is a delayed template or because its body
+  /// was skipped outside the main file.
+  ///
+  /// \returns true if \p FD has a body afterwards.
+  bool LateParseFunctionBody(FunctionDecl *FD);
+
   class DelayedDiagnostics;
 
   class DelayedDiagnosticsState {
@@ -2487,6 +2507,19 @@ public:
   /// an available function, false otherwise.
   bool isFunctionConsideredUnavailable(FunctionDecl *FD);
 
+  /// \brief The key of a cached implicit conversion sequence: the source and
+  /// target types, the context the sequence was formed in if it depends on
+  /// it, and the value kind of the source and the conversion flags.
+  typedef std::pair<std::pair<void *, void *>,
+                    std::pair<const DeclContext *, unsigned>>
+      ConversionSequenceCacheKey;
+
+  /// \brief The implicit conversion sequences formed during overload
+  /// resolution for arguments of complete class type. Those only depend on
+  /// the types involved, and are reused by later overload resolutions.
+  llvm::DenseMap<ConversionSequenceCacheKey, ImplicitConversionSequence>
+      ConversionSequenceCache;
+
   ImplicitConversionSequence
   TryImplicitConversion(Expr *From, QualType ToType,
                         bool SuppressUserConversions,
@@ -7116,6 +7149,10 @@ public:
   /// synthesis of another, additional contexts are pushed onto the stack.
   SmallVector<CodeSynthesisContext, 16> CodeSynthesisContexts;
 
+  /// \brief The cost of template instantiation and deduction, if it is being
+  /// profiled.
+  std::unique_ptr<TemplateProfile> TemplateProfiler;
+
   /// Specializations whose definitions are currently being instantiated.
   llvm::DenseSet<std::pair<Decl *, unsigned>> InstantiatingSpecializations;
 
@@ -7562,7 +7599,8 @@ public:
     }
   };
 
-  void PerformPendingInstantiations(bool LocalOnly = false);
+  void PerformPendingInstantiations(bool LocalOnly = false,
+                                    bool AtEndOfTU = true);
 
   TypeSourceInfo *SubstType(TypeSourceInfo *T,
                             const MultiLevelTemplateArgumentList &TemplateArgs,
@@ -0,0 +1,118 @@
+//===--- TemplateProfile.h - Cost of template instantiation -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the TemplateProfile class, which records the time and
+//  AST memory Sema spends instantiating and deducing each template, for
+//  -ftemplate-profile.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SEMA_TEMPLATEPROFILE_H
+#define LLVM_CLANG_SEMA_TEMPLATEPROFILE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include <chrono>
+#include <cstdint>
+
+namespace clang {
+
+class ASTContext;
+class Decl;
+
+/// \brief Accumulates the cost of template instantiation and deduction for
+/// each template.
+///
+/// Costs are exclusive: the time and memory spent in an activity that is
+/// nested within another one, such as the instantiation of a class template
+/// while instantiating a function template, are only charged to the nested
+/// activity. The costs in a profile therefore add up to the total cost of
+/// the profiled activities.
+class TemplateProfile {
+public:
+  /// \brief The activities that are profiled.
+  enum Activity {
+    /// Sema::InstantiateClass.
+    TPA_InstantiateClass,
+    /// Sema::InstantiateFunctionDefinition.
+    TPA_InstantiateFunction,
+    /// Sema::SubstType.
+    TPA_SubstType,
+    /// Sema::DeduceTemplateArguments.
+    TPA_Deduction,
+    TPA_NumActivities
+  };
+
+  /// \brief Charges the cost of an activity on a template to a profile, for
+  /// the lifetime of the scope. Does nothing if the profile is null; the
+  /// template is then not even looked up, since \p GetTemplate is only
+  /// called when profiling.
+  class Scope {
+    TemplateProfile *Profile;
+
+  public:
+    Scope(TemplateProfile *Profile, Activity A,
+          llvm::function_ref<const Decl *()> GetTemplate)
+        : Profile(Profile) {
+      if (Profile)
+        Profile->enter(A, GetTemplate());
+    }
+    ~Scope() {
+      if (Profile)
+        Profile->exit();
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+  };
+
+  explicit TemplateProfile(const ASTContext &Context) : Context(Context) {}
+
+  /// \brief Print the profile, one line per template and activity, most
+  /// expensive first.
+  ///
+  /// Each line holds the activity, the number of times it was performed, the
+  /// time it took in microseconds, the number of bytes it allocated in the
+  /// ASTContext and the qualified name of the template, separated by tabs.
+  /// Profiles of several translation units can be merged by adding up the
+  /// lines with the same activity and name.
+  void print(raw_ostream &OS) const;
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Cost {
+    uint64_t Count = 0;
+    Clock::duration Time = Clock::duration::zero();
+    uint64_t Bytes = 0;
+  };
+
+  struct ActiveScope {
+    Activity Kind;
+    const Decl *Template;
+    Clock::time_point StartTime;
+    size_t StartBytes;
+    /// The cost of the activities nested within this one.
+    Clock::duration NestedTime;
+    size_t NestedBytes;
+  };
+
+  void enter(Activity A, const Decl *Template);
+  void exit();
+
+  const ASTContext &Context;
+  llvm::DenseMap<std::pair<const Decl *, unsigned>, Cost> Costs;
+  SmallVector<ActiveScope, 8> Stack;
+};
+
+} // end namespace clang
+
+#endif
@@ -272,6 +272,9 @@ private:
   /// \sa getMaxNodesPerTopLevelFunction
   Optional<unsigned> MaxNodesPerTopLevelFunction;
 
+  /// \sa getMaxCachedDeclContexts
+  Optional<unsigned> MaxCachedDeclContexts;
+
   /// \sa shouldInlineLambdas
   Optional<bool> InlineLambdas;
 
@@ -281,6 +284,9 @@ private:
   /// \sa shouldUnrollLoops
   Optional<bool> UnrollLoops;
 
+  /// \sa shouldSummarizePureFunctions
+  Optional<bool> SummarizePureFunctions;
+
   /// \sa shouldDisplayNotesAsEvents
   Optional<bool> DisplayNotesAsEvents;
 
@@ -565,6 +571,15 @@ public:
   /// This is controlled by the 'max-nodes' config option.
   unsigned getMaxNodesPerTopLevelFunction();
 
+  /// Returns the number of declarations whose CFGs and liveness analyses are
+  /// kept from one top-level function to the next, so that the functions
+  /// analyzed both syntactically and path-sensitively, and the functions
+  /// inlined into several callers, do not have them computed again.
+  ///
+  /// This is controlled by the 'max-cached-decl-contexts' config option. To
+  /// recompute them for every top-level function, set the option to "0".
+  unsigned getMaxCachedDeclContexts();
+
   /// Returns true if lambdas should be inlined. Otherwise a sink node will be
   /// generated each time a LambdaExpr is visited.
   bool shouldInlineLambdas();
@@ -577,6 +592,18 @@ public:
   /// This is controlled by the 'unroll-loops' config option.
   bool shouldUnrollLoops();
 
+  /// Returns true if the results of inlining functions that only compute on
+  /// their scalar arguments should be reused at later calls with the same
+  /// concrete arguments, instead of inlining the function again.
+  /// This is controlled by the 'summarize-pure-functions' config option.
+  bool shouldSummarizePureFunctions();
+
+  /// Returns the directory in which the functions analyzed without finding
+  /// bugs are recorded, so that later runs can skip them while they and the
+  /// functions they call stay unchanged. Empty, the default, disables this.
+  /// This is controlled by the 'analysis-cache-dir' config option.
+  StringRef getAnalysisCacheDir();
+
   /// Returns true if the bug reporter should transparently treat extra note
   /// diagnostic pieces as event diagnostic pieces. Useful when the diagnostic
   /// consumer doesn't support the extra note pieces.
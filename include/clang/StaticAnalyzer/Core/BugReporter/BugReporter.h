@@ -21,6 +21,7 @@
 #include "clang/StaticAnalyzer/Core/BugReporter/PathDiagnostic.h"
 #include "clang/StaticAnalyzer/Core/CheckerManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/ImmutableSet.h"
@@ -502,7 +503,21 @@ private:
 
 // FIXME: Get rid of GRBugReporter.  It's the wrong abstraction.
 class GRBugReporter : public BugReporter {
+public:
+  typedef llvm::DenseMap<const ExplodedNode *, unsigned> NodeOrderMap;
+
+private:
   ExprEngine& Eng;
+
+  /// The order in which a breadth-first search from the roots of the
+  /// exploded graph visits its nodes. It is shared by the paths of all
+  /// reports, and is rebuilt when the graph changes.
+  NodeOrderMap ShortestPathOrder;
+  /// The graph that ShortestPathOrder was computed for, and its generation
+  /// at the time.
+  const ExplodedGraph *OrderedGraph = nullptr;
+  unsigned OrderedGeneration = 0;
+
 public:
   GRBugReporter(BugReporterData& d, ExprEngine& eng)
     : BugReporter(d, GRBugReporterKind), Eng(eng) {}
@@ -521,6 +536,12 @@ public:
   ///  engine.
   ProgramStateManager &getStateManager();
 
+  /// Get the order in which a breadth-first search from the roots of the
+  /// exploded graph visits its nodes. Walking back from a node through the
+  /// predecessors that come first in this order yields a shortest path from
+  /// a root to the node.
+  const NodeOrderMap &getShortestPathOrder();
+
   /// Generates a path corresponding to one of the given bug reports.
   ///
   /// Which report is used for path generation is not specified. The
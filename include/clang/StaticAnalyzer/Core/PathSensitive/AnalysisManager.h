@@ -60,6 +60,12 @@ public:
   void ClearContexts() {
     AnaCtxMgr.clear();
   }
+
+  /// Discard the least recently used AnalysisDeclContexts, keeping as many
+  /// of the others as the 'max-cached-decl-contexts' option allows.
+  void TrimContexts() {
+    AnaCtxMgr.trim(options.getMaxCachedDeclContexts());
+  }
   
   AnalysisDeclContextManager& getAnalysisDeclContextManager() {
     return AnaCtxMgr;
@@ -246,6 +246,7 @@ typedef llvm::DenseMap<const ExplodedNode *, const ExplodedNode *>
 class ExplodedGraph {
 protected:
   friend class CoreEngine;
+  friend class ExplodedNode;
 
   // Type definitions.
   typedef std::vector<ExplodedNode *> NodeVector;
@@ -269,6 +270,10 @@ protected:
 
   /// NumNodes - The number of nodes in the graph.
   unsigned NumNodes;
+
+  /// The number of times nodes, roots or edges were added to or removed from
+  /// the graph.
+  unsigned Generation;
   
   /// A list of recently allocated nodes that can potentially be recycled.
   NodeVector ChangedNodes;
@@ -309,6 +314,7 @@ public:
   /// addRoot - Add an untyped node to the set of roots.
   ExplodedNode *addRoot(ExplodedNode *V) {
     Roots.push_back(V);
+    ++Generation;
     return V;
   }
 
@@ -328,6 +334,11 @@ public:
   bool empty() const { return NumNodes == 0; }
   unsigned size() const { return NumNodes; }
 
+  /// Returns a number that changes whenever the nodes, roots or edges of the
+  /// graph change, so that information computed from the graph can tell
+  /// whether it is still up to date.
+  unsigned getGeneration() const { return Generation; }
+
   void reserve(unsigned NodeCount) { Nodes.reserve(NodeCount); }
 
   // Iterators.
@@ -605,6 +605,16 @@ private:
   bool inlineCall(const CallEvent &Call, const Decl *D, NodeBuilder &Bldr,
                   ExplodedNode *Pred, ProgramStateRef State);
 
+  /// Checks whether the result of inlining the callee only depends on the
+  /// values of its scalar arguments, so that it may be summarized.
+  bool maySummarizeCall(const CallEvent &Call, const Decl *D);
+
+  /// Evaluates the call with the result that an earlier inlining of the
+  /// callee had for the same concrete arguments, if there was one.
+  bool applyCallSummary(const CallEvent &Call, const Decl *D,
+                        NodeBuilder &Bldr, ExplodedNode *Pred,
+                        ProgramStateRef State);
+
   /// \brief Conservatively evaluate call by invalidating regions and binding
   /// a conjured return value.
   void conservativeEvalCall(const CallEvent &Call, NodeBuilder &Bldr,
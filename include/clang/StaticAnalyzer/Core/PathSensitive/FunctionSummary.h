@@ -16,10 +16,13 @@
 
 #include "clang/AST/Decl.h"
 #include "clang/Basic/LLVM.h"
+#include "llvm/ADT/APSInt.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallBitVector.h"
+#include "llvm/ADT/SmallVector.h"
 #include <deque>
 
 namespace clang {
@@ -29,6 +32,17 @@ typedef std::deque<Decl*> SetOfDecls;
 typedef llvm::DenseSet<const Decl*> SetOfConstDecls;
 
 class FunctionSummariesTy {
+public:
+  /// The maximum number of call summaries that are kept for a function.
+  enum { MaxCallSummaries = 64 };
+
+private:
+  /// The concrete value that an inlined call returned for concrete arguments.
+  struct CallSummary {
+    SmallVector<llvm::APSInt, 4> Args;
+    llvm::APSInt Result;
+  };
+
   class FunctionSummary {
   public:
     /// Marks the IDs of the basic blocks visited during the analyzes.
@@ -47,12 +61,40 @@ class FunctionSummariesTy {
     /// The number of times the function has been inlined.
     unsigned TimesInlined : 32;
 
+    /// True if this function has been checked against the rules for which
+    /// functions may be summarized.
+    unsigned SummaryChecked : 1;
+
+    /// True if the result of inlining this function only depends on its
+    /// arguments, so that calls to it may be summarized.
+    unsigned MaySummarize : 1;
+
+    /// The results of earlier calls to the function.
+    SmallVector<CallSummary, 4> CallSummaries;
+
     FunctionSummary() :
       TotalBasicBlocks(0),
       InlineChecked(0),
-      TimesInlined(0) {}
+      TimesInlined(0),
+      SummaryChecked(0),
+      MaySummarize(0) {}
   };
 
+  static bool isSameValue(const llvm::APSInt &LHS, const llvm::APSInt &RHS) {
+    return LHS.getBitWidth() == RHS.getBitWidth() &&
+           LHS.isUnsigned() == RHS.isUnsigned() && LHS == RHS;
+  }
+
+  static bool isSameArgs(ArrayRef<llvm::APSInt> LHS,
+                         ArrayRef<llvm::APSInt> RHS) {
+    if (LHS.size() != RHS.size())
+      return false;
+    for (unsigned I = 0, E = LHS.size(); I != E; ++I)
+      if (!isSameValue(LHS[I], RHS[I]))
+        return false;
+    return true;
+  }
+
   typedef llvm::DenseMap<const Decl *, FunctionSummary> MapTy;
   MapTy Map;
 
@@ -121,6 +163,56 @@ public:
     I->second.TimesInlined++;
   }
 
+  void markMaySummarize(const Decl *D, bool MaySummarize) {
+    MapTy::iterator I = findOrInsertSummary(D);
+    I->second.SummaryChecked = 1;
+    I->second.MaySummarize = MaySummarize;
+    if (!MaySummarize)
+      I->second.CallSummaries.clear();
+  }
+
+  Optional<bool> maySummarize(const Decl *D) {
+    MapTy::const_iterator I = Map.find(D);
+    if (I != Map.end() && I->second.SummaryChecked)
+      return I->second.MaySummarize;
+    return None;
+  }
+
+  /// Get the result of an earlier call to \p D with the same arguments, if
+  /// any.
+  const llvm::APSInt *findCallSummary(const Decl *D,
+                                      ArrayRef<llvm::APSInt> Args) {
+    MapTy::const_iterator I = Map.find(D);
+    if (I == Map.end())
+      return nullptr;
+    for (const CallSummary &S : I->second.CallSummaries)
+      if (isSameArgs(S.Args, Args))
+        return &S.Result;
+    return nullptr;
+  }
+
+  /// Record the result of a call to \p D. If an earlier call with the same
+  /// arguments had a different result, the function is no longer summarized.
+  void addCallSummary(const Decl *D, ArrayRef<llvm::APSInt> Args,
+                      const llvm::APSInt &Result) {
+    MapTy::iterator I = findOrInsertSummary(D);
+    FunctionSummary &FS = I->second;
+    if (!FS.MaySummarize)
+      return;
+    for (const CallSummary &S : FS.CallSummaries) {
+      if (isSameArgs(S.Args, Args)) {
+        if (!isSameValue(S.Result, Result))
+          markMaySummarize(D, false);
+        return;
+      }
+    }
+    if (FS.CallSummaries.size() < MaxCallSummaries) {
+      FS.CallSummaries.emplace_back();
+      FS.CallSummaries.back().Args.append(Args.begin(), Args.end());
+      FS.CallSummaries.back().Result = Result;
+    }
+  }
+
   /// Get the percentage of the reachable blocks.
   unsigned getPercentBlocksReachable(const Decl *D) {
     MapTy::const_iterator I = Map.find(D);
@@ -307,6 +307,8 @@ std::unique_ptr<StoreManager>
 CreateRegionStoreManager(ProgramStateManager &StMgr);
 std::unique_ptr<StoreManager>
 CreateFieldsOnlyRegionStoreManager(ProgramStateManager &StMgr);
+std::unique_ptr<StoreManager>
+CreateHashedRegionStoreManager(ProgramStateManager &StMgr);
 
 } // end GR namespace
 
@@ -20,6 +20,7 @@
 #include "clang/Tooling/FileMatchTrie.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/YAMLParser.h"
@@ -55,16 +56,27 @@ namespace tooling {
 ///
 /// JSON compilation databases can for example be generated in CMake projects
 /// by setting the flag -DCMAKE_EXPORT_COMPILE_COMMANDS.
+///
+/// Loading a database only locates the JSON object of each compile command
+/// and decodes its 'file' and 'directory'; the commands themselves are
+/// decoded when they are requested. Databases that are not plain JSON (the
+/// format is read as YAML) are parsed up front instead.
 enum class JSONCommandLineSyntax { Windows, Gnu, AutoDetect };
 class JSONCompilationDatabase : public CompilationDatabase {
 public:
   /// \brief Loads a JSON compilation database from the specified file.
   ///
+  /// If \p CacheIndex is true, the locations of the compile commands are
+  /// cached in the file '<FilePath>.index', and read back from it on later
+  /// loads as long as the database file keeps its size and modification time.
+  /// Databases found by CompilationDatabase::loadFromDirectory() are never
+  /// cached, so only callers that ask for it write files next to a database.
+  ///
   /// Returns NULL and sets ErrorMessage if the database could not be
   /// loaded from the given file.
   static std::unique_ptr<JSONCompilationDatabase>
   loadFromFile(StringRef FilePath, std::string &ErrorMessage,
-               JSONCommandLineSyntax Syntax);
+               JSONCommandLineSyntax Syntax, bool CacheIndex = false);
 
   /// \brief Loads a JSON compilation database from a data buffer.
   ///
@@ -97,30 +109,56 @@ private:
       : Database(std::move(Database)), Syntax(Syntax),
         YAMLStream(this->Database->getBuffer(), SM) {}
 
-  /// \brief Parses the database file and creates the index.
-  ///
-  /// Returns whether parsing succeeded. Sets ErrorMessage if parsing
-  /// failed.
-  bool parse(std::string &ErrorMessage);
-
-  // Tuple (directory, filename, commandline, output) where 'commandline'
-  // points to the corresponding scalar nodes in the YAML stream.
+  // A compile command of the database. Commands located by scan() only hold
+  // the text of their JSON object, which is parsed when they are requested;
+  // commands read by parse() point to scalar nodes in the YAML stream.
   // If the command line contains a single argument, it is a shell-escaped
   // command line.
   // Otherwise, each entry in the command line vector is a literal
   // argument to the compiler.
   // The output field may be a nullptr.
-  typedef std::tuple<llvm::yaml::ScalarNode *,
-                     llvm::yaml::ScalarNode *,
-                     std::vector<llvm::yaml::ScalarNode *>,
-                     llvm::yaml::ScalarNode *> CompileCommandRef;
+  struct CompileCommandRef {
+    StringRef Text;
+    llvm::yaml::ScalarNode *Directory = nullptr;
+    llvm::yaml::ScalarNode *File = nullptr;
+    std::vector<llvm::yaml::ScalarNode *> CommandLine;
+    llvm::yaml::ScalarNode *Output = nullptr;
+  };
 
-  /// \brief Converts the given array of CompileCommandRefs to CompileCommands.
-  void getCommands(ArrayRef<CompileCommandRef> CommandsRef,
+  /// \brief Parses the database file and creates the index.
+  ///
+  /// Returns whether parsing succeeded. Sets ErrorMessage if parsing
+  /// failed.
+  bool parse(std::string &ErrorMessage);
+
+  /// \brief Locates the compile commands of a database in plain JSON without
+  /// decoding them, and creates the index.
+  ///
+  /// Returns false, leaving the database empty, if the file is not plain JSON
+  /// or not a valid database; parse() then handles it.
+  bool scan();
+
+  /// \brief Reads and writes the locations found by scan() from and to an
+  /// index cache file that belongs to a database file with \p Status.
+  bool readIndexCache(StringRef CachePath,
+                      const llvm::sys::fs::file_status &Status);
+  void writeIndexCache(StringRef CachePath,
+                       const llvm::sys::fs::file_status &Status) const;
+
+  /// \brief Adds a compile command for \p NativeFilePath to the index.
+  void addCommand(StringRef NativeFilePath, CompileCommandRef Cmd);
+
+  /// \brief Inserts the indexed file paths into MatchTrie.
+  void buildMatchTrie();
+
+  /// \brief Converts the compile commands with the given indices into
+  /// AllCommands to CompileCommands.
+  void getCommands(ArrayRef<unsigned> CommandIndices,
                    std::vector<CompileCommand> &Commands) const;
 
-  // Maps file paths to the compile command lines for that file.
-  llvm::StringMap<std::vector<CompileCommandRef>> IndexByFile;
+  // Maps file paths to the indices into AllCommands of the compile command
+  // lines for that file.
+  llvm::StringMap<std::vector<unsigned>> IndexByFile;
 
   /// All the compile commands in the order that they were provided in the
   /// JSON stream.
@@ -0,0 +1,163 @@
+//===--- ASTAllocationStats.cpp - Memory used by AST nodes ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the ASTAllocationStats class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ASTAllocationStats.h"
+#include "clang/AST/Type.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+
+ASTAllocationStats *ASTAllocationStats::Active = nullptr;
+
+ASTAllocationStats::ASTAllocationStats(const SourceManager &SM) : SM(SM) {}
+
+ASTAllocationStats::~ASTAllocationStats() {
+  if (Active == this)
+    Active = nullptr;
+}
+
+void ASTAllocationStats::addNode(NodeCategory Category, const char *Kind,
+                                 const void *Node, size_t StaticSize,
+                                 SourceLocation Loc) {
+  // The node may have been allocated after a prefix, such as the owning
+  // module of a declaration, and may be followed by trailing objects.
+  size_t Size = StaticSize;
+  const char *Ptr = static_cast<const char *>(Node);
+  if (LastAllocation && Ptr >= LastAllocation &&
+      Ptr < LastAllocation + LastAllocationSize)
+    Size = LastAllocationSize;
+  LastAllocation = nullptr;
+
+  if (Loc.isValid())
+    CurrentFile = SM.getFileID(SM.getExpansionLoc(Loc));
+
+  Usage &KindUsage = Kinds[Category][Kind];
+  ++KindUsage.Count;
+  KindUsage.Bytes += Size;
+
+  Usage &FileUsage = Files[CurrentFile];
+  ++FileUsage.Count;
+  FileUsage.Bytes += Size;
+}
+
+static size_t getTypeSize(const Type *T) {
+  switch (T->getTypeClass()) {
+#define TYPE(Class, Base)                                                      \
+  case Type::Class:                                                            \
+    return sizeof(Class##Type);
+#define ABSTRACT_TYPE(Class, Base)
+#include "clang/AST/TypeNodes.def"
+  }
+  llvm_unreachable("unknown type class");
+}
+
+static void printJSONString(raw_ostream &OS, StringRef S) {
+  OS << '"';
+  for (unsigned char C : S) {
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << llvm::format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+namespace {
+struct NamedUsage {
+  StringRef Name;
+  uint64_t Count;
+  uint64_t Bytes;
+
+  bool operator<(const NamedUsage &Other) const {
+    if (Bytes != Other.Bytes)
+      return Bytes > Other.Bytes;
+    return Name < Other.Name;
+  }
+};
+} // end anonymous namespace
+
+/// Print a JSON array of usages, most expensive first.
+static void printUsages(raw_ostream &OS, StringRef Key, StringRef NameKey,
+                        std::vector<NamedUsage> Usages, bool Last = false) {
+  std::sort(Usages.begin(), Usages.end());
+
+  OS << "  \"" << Key << "\": [";
+  for (unsigned I = 0, N = Usages.size(); I != N; ++I) {
+    OS << (I ? ",\n    {\"" : "\n    {\"") << NameKey << "\": ";
+    printJSONString(OS, Usages[I].Name);
+    OS << ", \"count\": " << Usages[I].Count
+       << ", \"bytes\": " << Usages[I].Bytes << "}";
+  }
+  OS << (Usages.empty() ? "]" : "\n  ]") << (Last ? "\n" : ",\n");
+}
+
+void ASTAllocationStats::printJSON(raw_ostream &OS,
+                                   const llvm::BumpPtrAllocator &Alloc,
+                                   ArrayRef<Type *> Types) const {
+  uint64_t TaggedBytes = 0;
+
+  std::vector<NamedUsage> NodeUsages[NC_NumCategories];
+  for (unsigned C = 0; C != NC_NumCategories; ++C) {
+    for (auto &K : Kinds[C]) {
+      NodeUsages[C].push_back({K.first, K.second.Count, K.second.Bytes});
+      TaggedBytes += K.second.Bytes;
+    }
+  }
+
+  llvm::StringMap<Usage> TypeKinds;
+  for (const Type *T : Types) {
+    Usage &U = TypeKinds[T->getTypeClassName()];
+    ++U.Count;
+    U.Bytes += getTypeSize(T);
+  }
+  std::vector<NamedUsage> TypeUsages;
+  for (auto &K : TypeKinds) {
+    TypeUsages.push_back({K.getKey(), K.getValue().Count, K.getValue().Bytes});
+    TaggedBytes += K.getValue().Bytes;
+  }
+
+  // A header that is included more than once has a FileID per inclusion.
+  llvm::StringMap<Usage> FileNames;
+  for (auto &F : Files) {
+    StringRef Name = "<unknown>";
+    if (F.first.isValid())
+      Name = SM.getBufferName(SM.getLocForStartOfFile(F.first));
+    Usage &U = FileNames[Name];
+    U.Count += F.second.Count;
+    U.Bytes += F.second.Bytes;
+  }
+  std::vector<NamedUsage> FileUsages;
+  for (auto &F : FileNames)
+    FileUsages.push_back({F.getKey(), F.getValue().Count, F.getValue().Bytes});
+
+  uint64_t Allocated = Alloc.getBytesAllocated();
+  uint64_t Total = Alloc.getTotalMemory();
+  OS << "{\n"
+     << "  \"allocator\": {\"slabs\": " << Alloc.GetNumSlabs()
+     << ", \"total_bytes\": " << Total
+     << ", \"allocated_bytes\": " << Allocated
+     << ", \"slack_bytes\": " << (Total > Allocated ? Total - Allocated : 0)
+     << ", \"untagged_bytes\": "
+     << (Allocated > TaggedBytes ? Allocated - TaggedBytes : 0) << "},\n";
+  printUsages(OS, "decls", "kind", std::move(NodeUsages[NC_Decl]));
+  printUsages(OS, "stmts", "kind", std::move(NodeUsages[NC_Stmt]));
+  printUsages(OS, "types", "kind", std::move(TypeUsages));
+  printUsages(OS, "files", "file", std::move(FileUsages), /*Last=*/true);
+  OS << "}\n";
+}
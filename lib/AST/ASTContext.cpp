@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/AST/ASTContext.h"
+#include "clang/AST/ASTAllocationStats.h"
 #include "CXXABI.h"
 #include "clang/AST/ASTMutationListener.h"
 #include "clang/AST/Attr.h"
@@ -24,11 +25,16 @@
 #include "clang/AST/DeclTemplate.h"
 #include "clang/AST/Expr.h"
 #include "clang/AST/ExprCXX.h"
+#include "clang/AST/ExprObjC.h"
+#include "clang/AST/ExprOpenMP.h"
 #include "clang/AST/ExternalASTSource.h"
 #include "clang/AST/Mangle.h"
 #include "clang/AST/MangleNumberingContext.h"
 #include "clang/AST/RecordLayout.h"
 #include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/AST/StmtCXX.h"
+#include "clang/AST/StmtObjC.h"
+#include "clang/AST/StmtOpenMP.h"
 #include "clang/AST/TypeLoc.h"
 #include "clang/AST/VTableBuilder.h"
 #include "clang/Basic/Builtins.h"
@@ -55,6 +61,16 @@ unsigned ASTContext::NumImplicitMoveAssignmentOperators;
 unsigned ASTContext::NumImplicitMoveAssignmentOperatorsDeclared;
 unsigned ASTContext::NumImplicitDestructors;
 unsigned ASTContext::NumImplicitDestructorsDeclared;
+unsigned ASTContext::NumConstexprCallCacheHits;
+unsigned ASTContext::NumConstexprCallCacheMisses;
+uint64_t ASTContext::NumConstexprStepsSaved;
+unsigned ASTContext::NumLargeLookupTables;
+uint64_t ASTContext::NumPendingLookupBytes;
+unsigned ASTContext::NumDiscardedFunctionBodies;
+uint64_t ASTContext::NumDiscardedStmtBytes;
+uint64_t ASTContext::NumRecycledStmtBytes;
+unsigned ASTContext::NumDeferredLookupDecls;
+unsigned ASTContext::NumLoadedDeferredLookupDecls;
 
 enum FloatingRank {
   HalfRank, FloatRank, DoubleRank, LongDoubleRank, Float128Rank
@@ -877,12 +893,140 @@ void ASTContext::PrintStats() const {
                << NumImplicitDestructors
                << " implicit destructors created\n";
 
+  if (getLangOpts().CPlusPlus11)
+    llvm::errs() << NumConstexprCallCacheHits << " hits, "
+                 << NumConstexprCallCacheMisses << " misses in the "
+                 << ConstexprCallResults.size()
+                 << " memoized constexpr calls, saving "
+                 << NumConstexprStepsSaved << " evaluation steps\n";
+
+  if (NumLargeLookupTables) {
+    // The lookup table entries that were never added are only a saving once
+    // the memory holding the pending declarations is paid for.
+    uint64_t SavedBytes =
+        uint64_t(NumDeferredLookupDecls - NumLoadedDeferredLookupDecls) *
+        sizeof(StoredDeclsMap::value_type);
+    llvm::errs() << NumLoadedDeferredLookupDecls << "/"
+                 << NumDeferredLookupDecls << " declarations in "
+                 << NumLargeLookupTables
+                 << " large lookup tables added on demand, ";
+    if (SavedBytes >= NumPendingLookupBytes)
+      llvm::errs() << "saving up to " << SavedBytes - NumPendingLookupBytes;
+    else
+      llvm::errs() << "costing " << NumPendingLookupBytes - SavedBytes;
+    llvm::errs() << " bytes net of " << NumPendingLookupBytes
+                 << " bytes of pending declarations\n";
+  }
+
+  if (NumDiscardedFunctionBodies)
+    llvm::errs() << NumDiscardedFunctionBodies
+                 << " function bodies discarded after code generation, "
+                 << NumRecycledStmtBytes << "/" << NumDiscardedStmtBytes
+                 << " bytes of their statements reused\n";
+
   if (ExternalSource) {
     llvm::errs() << "\n";
     ExternalSource->PrintStats();
   }
 
   BumpAlloc.PrintStats();
+
+  if (AllocationStats) {
+    llvm::errs() << "\n*** AST Allocation Stats:\n";
+    AllocationStats->printJSON(llvm::errs(), BumpAlloc, Types);
+  }
+}
+
+static size_t getStmtClassSize(Stmt::StmtClass SC) {
+  switch (SC) {
+  case Stmt::NoStmtClass:
+    break;
+#define ABSTRACT_STMT(STMT)
+#define STMT(CLASS, PARENT)                                                    \
+  case Stmt::CLASS##Class:                                                     \
+    return sizeof(CLASS);
+#include "clang/AST/StmtNodes.inc"
+  }
+  llvm_unreachable("unknown statement class");
+}
+
+bool ASTContext::discardFunctionBody(FunctionDecl *FD) {
+  if (!FD->doesThisDeclarationHaveABody())
+    return false;
+  auto *Body = dyn_cast_or_null<CompoundStmt>(FD->getBody());
+  if (!Body)
+    return false;
+
+  // Find the statements in the body. Statements can be shared, for example
+  // between the syntactic and semantic forms of an expression, so each one
+  // must only be released once.
+  llvm::SmallPtrSet<Stmt *, 64> Stmts;
+  SmallVector<Stmt *, 32> Worklist(1, Body);
+  while (!Worklist.empty()) {
+    Stmt *S = Worklist.pop_back_val();
+    if (!S || !Stmts.insert(S).second)
+      continue;
+
+    // Other functions refer to the statements in these.
+    if (isa<LambdaExpr>(S) || isa<BlockExpr>(S) || isa<CapturedStmt>(S))
+      return false;
+
+    // The initializers of local variables are still reachable from their
+    // declarations.
+    if (isa<DeclStmt>(S))
+      continue;
+
+    // The declaration of a label outlives its statement.
+    if (auto *LS = dyn_cast<LabelStmt>(S))
+      LS->getDecl()->setStmt(nullptr);
+
+    for (Stmt *Child : S->children())
+      Worklist.push_back(Child);
+  }
+
+  FD->setBody(new (*this) CompoundStmt(*this, None, Body->getLBracLoc(),
+                                       Body->getRBracLoc()));
+
+  // The parent map may refer to the released statements; it is rebuilt on
+  // the next call to getParents.
+  if (PointerParents) {
+    ReleaseParentMapEntries();
+    PointerParents.reset();
+    OtherParents.reset();
+  }
+
+  // A statement may have been allocated with trailing objects, so it is only
+  // known to occupy the size of its class.
+  for (Stmt *S : Stmts) {
+    size_t Size = getStmtClassSize(S->getStmtClass());
+    void *&Head = RecycledStmts[Size];
+    *static_cast<void **>(static_cast<void *>(S)) = Head;
+    Head = S;
+    NumDiscardedStmtBytes += Size;
+  }
+  ++NumDiscardedFunctionBodies;
+  return true;
+}
+
+void *ASTContext::allocateRecycledStmtSlow(size_t Size, unsigned Align) const {
+  auto It = RecycledStmts.find(Size);
+  if (It == RecycledStmts.end() ||
+      reinterpret_cast<uintptr_t>(It->second) % Align)
+    return nullptr;
+
+  void *Block = It->second;
+  if (void *Next = *static_cast<void **>(Block))
+    It->second = Next;
+  else
+    RecycledStmts.erase(It);
+  NumRecycledStmtBytes += Size;
+  return Block;
+}
+
+void ASTContext::enableAllocationStats() {
+  if (!AllocationStats)
+    AllocationStats.reset(new ASTAllocationStats(SourceMgr));
+  AllocationStats->activate();
 }
 
 void ASTContext::mergeDefinitionIntoModule(NamedDecl *ND, Module *M,
@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/AST/DeclBase.h"
+#include "clang/AST/ASTAllocationStats.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ASTMutationListener.h"
 #include "clang/AST/Attr.h"
@@ -58,6 +59,8 @@ void *Decl::operator new(std::size_t Size, const ASTContext &Context,
                 "Decl won't be misaligned");
   void *Start = Context.Allocate(Size + Extra + 8);
   void *Result = (char*)Start + 8;
+  if (ASTAllocationStats *Stats = ASTAllocationStats::getActive())
+    Stats->noteAllocation(Start, Size + Extra + 8);
 
   unsigned *PrefixPtr = (unsigned *)Result - 2;
 
@@ -82,12 +85,18 @@ void *Decl::operator new(std::size_t Size, const ASTContext &Ctx,
         llvm::OffsetToAlignment(sizeof(Module *), alignof(Decl));
     char *Buffer = reinterpret_cast<char *>(
         ::operator new(ExtraAlign + sizeof(Module *) + Size + Extra, Ctx));
+    if (ASTAllocationStats *Stats = ASTAllocationStats::getActive())
+      Stats->noteAllocation(Buffer, ExtraAlign + sizeof(Module *) + Size +
+                                        Extra);
     Buffer += ExtraAlign;
     auto *ParentModule =
         Parent ? cast<Decl>(Parent)->getOwningModule() : nullptr;
     return new (Buffer) Module*(ParentModule) + 1;
   }
-  return ::operator new(Size + Extra, Ctx);
+  void *Result = ::operator new(Size + Extra, Ctx);
+  if (ASTAllocationStats *Stats = ASTAllocationStats::getActive())
+    Stats->noteAllocation(Result, Size + Extra);
+  return Result;
 }
 
 Module *Decl::getOwningModuleSlow() const {
@@ -170,11 +179,20 @@ void Decl::PrintStats() {
 }
 
 void Decl::add(Kind k) {
+  size_t Size = 0;
   switch (k) {
-#define DECL(DERIVED, BASE) case DERIVED: ++n##DERIVED##s; break;
+#define DECL(DERIVED, BASE)                                             \
+  case DERIVED:                                                         \
+    ++n##DERIVED##s;                                                    \
+    Size = sizeof(DERIVED##Decl);                                       \
+    break;
 #define ABSTRACT_DECL(DECL)
 #include "clang/AST/DeclNodes.inc"
   }
+
+  if (ASTAllocationStats *Stats = ASTAllocationStats::getActive())
+    Stats->addNode(ASTAllocationStats::NC_Decl, getDeclKindName(), this, Size,
+                   getLocation());
 }
 
 bool Decl::isTemplateParameterPack() const {
@@ -1198,6 +1216,10 @@ void DeclContext::reconcileExternalVisibleStorage() const {
   assert(NeedToReconcileExternalVisibleStorage && LookupPtr);
   NeedToReconcileExternalVisibleStorage = false;
 
+  // Declarations are not deferred in contexts with external visible storage.
+  loadAllPendingLookupDecls();
+  LookupPtr->Pending.reset();
+
   for (auto &Lookup : *LookupPtr)
     Lookup.second.setHasExternalDecls();
 }
@@ -1356,8 +1378,10 @@ void DeclContext::removeDecl(Decl *D) {
 
     auto *DC = D->getDeclContext();
     do {
-      StoredDeclsMap *Map = DC->getPrimaryContext()->LookupPtr;
+      DeclContext *Primary = DC->getPrimaryContext();
+      StoredDeclsMap *Map = Primary->LookupPtr;
       if (Map) {
+        Primary->loadPendingLookupDecls(ND->getDeclName());
         StoredDeclsMap::iterator Pos = Map->find(ND->getDeclName());
         assert(Pos != Map->end() && "no lookup entry for decl");
         if (Pos->second.getAsVector() || Pos->second.getAsDecl() == ND)
@@ -1445,6 +1469,19 @@ static bool shouldBeHidden(NamedDecl *D) {
 StoredDeclsMap *DeclContext::buildLookup() {
   assert(this == getPrimaryContext() && "buildLookup called on non-primary DC");
 
+  buildPartialLookup();
+  loadAllPendingLookupDecls();
+  return LookupPtr;
+}
+
+/// buildPartialLookup - Build the lookup data structure as buildLookup
+/// does, but leave out the declarations that are pending in the lookup
+/// table of a very large context. Lookups of a name must call
+/// loadPendingLookupDecls first.
+StoredDeclsMap *DeclContext::buildPartialLookup() {
+  assert(this == getPrimaryContext() &&
+         "buildPartialLookup called on non-primary DC");
+
   if (!HasLazyLocalLexicalLookups && !HasLazyExternalLexicalLookups)
     return LookupPtr;
 
@@ -1529,7 +1566,7 @@ DeclContext::lookup(DeclarationName Name) const {
 
     if (HasLazyLocalLexicalLookups || HasLazyExternalLexicalLookups)
       // FIXME: Make buildLookup const?
-      Map = const_cast<DeclContext*>(this)->buildLookup();
+      Map = const_cast<DeclContext*>(this)->buildPartialLookup();
 
     if (!Map)
       Map = CreateStoredDeclsMap(getParentASTContext());
@@ -1553,11 +1590,14 @@ DeclContext::lookup(DeclarationName Name) const {
 
   StoredDeclsMap *Map = LookupPtr;
   if (HasLazyLocalLexicalLookups || HasLazyExternalLexicalLookups)
-    Map = const_cast<DeclContext*>(this)->buildLookup();
+    Map = const_cast<DeclContext*>(this)->buildPartialLookup();
 
   if (!Map)
     return lookup_result();
 
+  if (Map->Pending)
+    loadPendingLookupDecls(Name);
+
   StoredDeclsMap::iterator I = Map->find(Name);
   if (I == Map->end())
     return lookup_result();
@@ -1589,6 +1629,9 @@ DeclContext::noload_lookup(DeclarationName Name) {
   if (!Map)
     return lookup_result();
 
+  if (Map->Pending)
+    loadPendingLookupDecls(Name);
+
   StoredDeclsMap::iterator I = Map->find(Name);
   return I != Map->end() ? I->second.getLookupResult()
                          : lookup_result();
@@ -1610,6 +1653,7 @@ void DeclContext::localUncachedLookup(DeclarationName Name,
   // FIXME: Should we be checking these flags on the primary context?
   if (Name && !HasLazyLocalLexicalLookups && !HasLazyExternalLexicalLookups) {
     if (StoredDeclsMap *Map = LookupPtr) {
+      loadPendingLookupDecls(Name);
       StoredDeclsMap::iterator Pos = Map->find(Name);
       if (Pos != Map->end()) {
         Results.insert(Results.end(),
@@ -1713,8 +1757,9 @@ void DeclContext::makeDeclVisibleInContextWithFlags(NamedDecl *D, bool Internal,
         !isTranslationUnit()))) {
     // If we have lazily omitted any decls, they might have the same name as
     // the decl which we are adding, so build a full lookup table before adding
-    // this decl.
-    buildLookup();
+    // this decl. Declarations that are pending in the table stay pending; D
+    // will be added after them.
+    buildPartialLookup();
     makeDeclVisibleInContextImpl(D, Internal);
   } else {
     HasLazyLocalLexicalLookups = true;
@@ -1733,6 +1778,55 @@ void DeclContext::makeDeclVisibleInContextWithFlags(NamedDecl *D, bool Internal,
       L->AddedVisibleDecl(this, D);
 }
 
+/// The number of names in the lookup table of a namespace or translation unit
+/// from which on further declarations are only added to it when their name is
+/// looked up.
+static const unsigned LargeLookupTableSize = 4096;
+
+/// Insert a local declaration into a lookup table, replacing any declaration
+/// it redeclares.
+static void addToLookupTable(StoredDeclsMap &Map, NamedDecl *D) {
+  StoredDeclsList &DeclNameEntries = Map[D->getDeclName()];
+
+  if (DeclNameEntries.isNull()) {
+    DeclNameEntries.setOnlyValue(D);
+    return;
+  }
+
+  if (DeclNameEntries.HandleRedeclaration(D, /*IsKnownNewer*/true)) {
+    // This declaration has replaced an existing one for which
+    // declarationReplaces returns true.
+    return;
+  }
+
+  // Put this declaration into the appropriate slot.
+  DeclNameEntries.AddSubsequentDecl(D);
+}
+
+void DeclContext::loadPendingLookupDecls(DeclarationName Name) const {
+  StoredDeclsMap *Map = LookupPtr;
+  if (!Map || !Map->Pending || Map->Pending->empty())
+    return;
+
+  SmallVector<NamedDecl *, 4> Decls;
+  Map->Pending->take(Name, Decls);
+  for (NamedDecl *D : Decls)
+    addToLookupTable(*Map, D);
+  ASTContext::NumLoadedDeferredLookupDecls += Decls.size();
+}
+
+void DeclContext::loadAllPendingLookupDecls() const {
+  StoredDeclsMap *Map = LookupPtr;
+  if (!Map || !Map->Pending || Map->Pending->empty())
+    return;
+
+  SmallVector<NamedDecl *, 64> Decls;
+  Map->Pending->takeAll(Decls);
+  for (NamedDecl *D : Decls)
+    addToLookupTable(*Map, D);
+  ASTContext::NumLoadedDeferredLookupDecls += Decls.size();
+}
+
 void DeclContext::makeDeclVisibleInContextImpl(NamedDecl *D, bool Internal) {
   // Find or create the stored declaration map.
   StoredDeclsMap *Map = LookupPtr;
@@ -1741,6 +1835,26 @@ void DeclContext::makeDeclVisibleInContextImpl(NamedDecl *D, bool Internal) {
     Map = CreateStoredDeclsMap(*C);
   }
 
+  // Most of the names declared in a very large namespace, such as one
+  // produced by a code generator, are never looked up. Once its lookup table
+  // is large, only keep track of further declarations, and add them to the
+  // table when their name is first looked up.
+  if (!Map->Pending && !Internal && Map->size() >= LargeLookupTableSize &&
+      isFileContext() && !hasExternalVisibleStorage() &&
+      !hasExternalLexicalStorage()) {
+    Map->Pending.reset(new PendingLookupDecls);
+    ++ASTContext::NumLargeLookupTables;
+  }
+
+  if (Map->Pending) {
+    if (!Internal) {
+      Map->Pending->add(D);
+      ++ASTContext::NumDeferredLookupDecls;
+      return;
+    }
+    loadPendingLookupDecls(D->getDeclName());
+  }
+
   // If there is an external AST source, load any declarations it knows about
   // with this declaration's name.
   // If the lookup table contains an entry about this name it means that we
@@ -1751,32 +1865,19 @@ void DeclContext::makeDeclVisibleInContextImpl(NamedDecl *D, bool Internal) {
           Map->find(D->getDeclName()) == Map->end())
         Source->FindExternalVisibleDeclsByName(this, D->getDeclName());
 
-  // Insert this declaration into the map.
-  StoredDeclsList &DeclNameEntries = (*Map)[D->getDeclName()];
-
   if (Internal) {
     // If this is being added as part of loading an external declaration,
     // this may not be the only external declaration with this name.
     // In this case, we never try to replace an existing declaration; we'll
     // handle that when we finalize the list of declarations for this name.
+    StoredDeclsList &DeclNameEntries = (*Map)[D->getDeclName()];
     DeclNameEntries.setHasExternalDecls();
     DeclNameEntries.AddSubsequentDecl(D);
     return;
   }
 
-  if (DeclNameEntries.isNull()) {
-    DeclNameEntries.setOnlyValue(D);
-    return;
-  }
-
-  if (DeclNameEntries.HandleRedeclaration(D, /*IsKnownNewer*/!Internal)) {
-    // This declaration has replaced an existing one for which
-    // declarationReplaces returns true.
-    return;
-  }
-
-  // Put this declaration into the appropriate slot.
-  DeclNameEntries.AddSubsequentDecl(D);
+  // Insert this declaration into the map.
+  addToLookupTable(*Map, D);
 }
 
 UsingDirectiveDecl *DeclContext::udir_iterator::operator*() const {
@@ -1820,6 +1921,77 @@ void ASTContext::ReleaseDeclContextMaps() {
   StoredDeclsMap::DestroyAll(LastSDM.getPointer(), LastSDM.getInt());
 }
 
+PendingLookupDecls::PendingLookupDecls() : Buckets(64), Size(0) {
+  ASTContext::NumPendingLookupBytes += getMemorySize();
+}
+
+PendingLookupDecls::~PendingLookupDecls() {
+  ASTContext::NumPendingLookupBytes -= getMemorySize();
+}
+
+size_t PendingLookupDecls::getMemorySize() const {
+  size_t Bytes = Buckets.capacity() * sizeof(BucketTy);
+  for (const BucketTy &Bucket : Buckets)
+    if (!Bucket.isSmall())
+      Bytes += Bucket.capacity() * sizeof(NamedDecl *);
+  return Bytes;
+}
+
+PendingLookupDecls::BucketTy &
+PendingLookupDecls::getBucket(DeclarationName Name) {
+  unsigned Hash = llvm::DenseMapInfo<DeclarationName>::getHashValue(Name);
+  return Buckets[Hash & (Buckets.size() - 1)];
+}
+
+void PendingLookupDecls::grow() {
+  // The declarations with any one name are in the same bucket, and are
+  // visited in order.
+  size_t OldBytes = getMemorySize();
+  std::vector<BucketTy> OldBuckets(Buckets.size() * 2);
+  OldBuckets.swap(Buckets);
+  for (BucketTy &Bucket : OldBuckets)
+    for (NamedDecl *D : Bucket)
+      getBucket(D->getDeclName()).push_back(D);
+  ASTContext::NumPendingLookupBytes += getMemorySize();
+  ASTContext::NumPendingLookupBytes -= OldBytes;
+}
+
+void PendingLookupDecls::add(NamedDecl *D) {
+  // Keep the buckets short, so that looking up a name that is not pending is
+  // cheap.
+  if (Size >= Buckets.size() * 8)
+    grow();
+  BucketTy &Bucket = getBucket(D->getDeclName());
+  size_t OldCapacity = Bucket.isSmall() ? 0 : Bucket.capacity();
+  Bucket.push_back(D);
+  if (!Bucket.isSmall())
+    ASTContext::NumPendingLookupBytes +=
+        (Bucket.capacity() - OldCapacity) * sizeof(NamedDecl *);
+  ++Size;
+}
+
+void PendingLookupDecls::take(DeclarationName Name,
+                              SmallVectorImpl<NamedDecl *> &Decls) {
+  BucketTy &Bucket = getBucket(Name);
+  unsigned Kept = 0;
+  for (unsigned I = 0, N = Bucket.size(); I != N; ++I) {
+    if (Bucket[I]->getDeclName() == Name)
+      Decls.push_back(Bucket[I]);
+    else
+      Bucket[Kept++] = Bucket[I];
+  }
+  Size -= Bucket.size() - Kept;
+  Bucket.resize(Kept);
+}
+
+void PendingLookupDecls::takeAll(SmallVectorImpl<NamedDecl *> &Decls) {
+  for (BucketTy &Bucket : Buckets) {
+    Decls.append(Bucket.begin(), Bucket.end());
+    Bucket.clear();
+  }
+  Size = 0;
+}
+
 void StoredDeclsMap::DestroyAll(StoredDeclsMap *Map, bool Dependent) {
   while (Map) {
     // Advance the iteration before we invalidate memory.
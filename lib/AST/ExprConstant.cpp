@@ -549,6 +549,9 @@ namespace {
     /// CallStackDepth - The number of calls in the call stack right now.
     unsigned CallStackDepth;
 
+    /// MaxCallStackDepth - The largest CallStackDepth reached so far.
+    unsigned MaxCallStackDepth = 0;
+
     /// NextCallIndex - The next call index to assign.
     unsigned NextCallIndex;
 
@@ -588,6 +591,11 @@ namespace {
     /// \brief Whether or not we're currently speculatively evaluating.
     bool IsSpeculativelyEvaluating;
 
+    /// NumIssues - The number of diagnostics, side-effects, undefined
+    /// behaviors and failures noted so far, whether or not they were recorded.
+    /// A constexpr call that notes none of these can be memoized.
+    unsigned NumIssues = 0;
+
     enum EvaluationMode {
       /// Evaluate as a constant expression. Stop if we find that the expression
       /// is not a constant expression.
@@ -720,7 +728,7 @@ namespace {
   private:
     OptionalDiagnostic Diag(SourceLocation Loc, diag::kind DiagId,
                             unsigned ExtraNotes, bool IsCCEDiag) {
-    
+      ++NumIssues;
       if (EvalStatus.Diag) {
         // If we have a prior diagnostic, it will be noting that the expression
         // isn't a constant expression. This diagnostic is more important,
@@ -780,6 +788,7 @@ namespace {
                             unsigned ExtraNotes = 0) {
       if (EvalStatus.Diag)
         return Diag(E->getExprLoc(), DiagId, ExtraNotes, /*IsCCEDiag*/false);
+      ++NumIssues;
       HasActiveDiagnostic = false;
       return OptionalDiagnostic();
     }
@@ -795,6 +804,7 @@ namespace {
       // Don't override a previous diagnostic. Don't bother collecting
       // diagnostics if we're evaluating for overflow.
       if (!EvalStatus.Diag || !EvalStatus.Diag->empty()) {
+        ++NumIssues;
         HasActiveDiagnostic = false;
         return OptionalDiagnostic();
       }
@@ -842,6 +852,7 @@ namespace {
     /// Note that we have had a side-effect, and determine whether we should
     /// keep evaluating.
     bool noteSideEffect() {
+      ++NumIssues;
       EvalStatus.HasSideEffects = true;
       return keepEvaluatingAfterSideEffect();
     }
@@ -868,6 +879,7 @@ namespace {
     /// that we can evaluate past it (such as signed overflow or floating-point
     /// division by zero.)
     bool noteUndefinedBehavior() {
+      ++NumIssues;
       EvalStatus.HasUndefinedBehavior = true;
       return keepEvaluatingAfterUndefinedBehavior();
     }
@@ -912,6 +924,7 @@ namespace {
       // subexpression implies that a side-effect has potentially happened. We
       // skip setting the HasSideEffects flag to true until we decide to
       // continue evaluating after that point, which happens here.
+      ++NumIssues;
       bool KeepGoing = keepEvaluatingAfterFailure();
       EvalStatus.HasSideEffects |= KeepGoing;
       return KeepGoing;
@@ -1093,6 +1106,8 @@ CallStackFrame::CallStackFrame(EvalInfo &Info, SourceLocation CallLoc,
       Arguments(Arguments), CallLoc(CallLoc), Index(Info.NextCallIndex++) {
   Info.CurrentCall = this;
   ++Info.CallStackDepth;
+  Info.MaxCallStackDepth =
+      std::max(Info.MaxCallStackDepth, Info.CallStackDepth);
 }
 
 CallStackFrame::~CallStackFrame() {
@@ -4185,19 +4200,13 @@ static bool EvaluateArgs(ArrayRef<const Expr*> Args, ArgVector &ArgValues,
   return Success;
 }
 
-/// Evaluate a function call.
-static bool HandleFunctionCall(SourceLocation CallLoc,
+/// Evaluate the body of a function call whose arguments have been evaluated.
+static bool HandleFunctionBody(SourceLocation CallLoc,
                                const FunctionDecl *Callee, const LValue *This,
-                               ArrayRef<const Expr*> Args, const Stmt *Body,
+                               ArrayRef<const Expr*> Args,
+                               ArgVector &ArgValues, const Stmt *Body,
                                EvalInfo &Info, APValue &Result,
                                const LValue *ResultSlot) {
-  ArgVector ArgValues(Args.size());
-  if (!EvaluateArgs(Args, ArgValues, Info))
-    return false;
-
-  if (!Info.CheckCallLimit(CallLoc))
-    return false;
-
   CallStackFrame Frame(Info, CallLoc, Callee, This, ArgValues.data());
 
   // For a trivial copy or move assignment, perform an APValue copy. This is
@@ -4239,6 +4248,169 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   return ESR == ESR_Returned;
 }
 
+/// Append an encoding of the value \p V, which identifies it among the values
+/// of its type, to \p Out. Returns false if \p V refers to an object, a
+/// declaration or an expression, as the meaning of such a value depends on
+/// the evaluation it was computed in.
+static bool encodeLiteralValue(const APValue &V, SmallVectorImpl<char> &Out) {
+  auto AppendRaw = [&](const void *Data, size_t Size) {
+    Out.append((const char *)Data, (const char *)Data + Size);
+  };
+  auto AppendInt = [&](const llvm::APInt &I) {
+    unsigned BitWidth = I.getBitWidth();
+    AppendRaw(&BitWidth, sizeof(BitWidth));
+    AppendRaw(I.getRawData(), I.getNumWords() * sizeof(uint64_t));
+  };
+  auto AppendFloat = [&](const llvm::APFloat &F) {
+    const llvm::fltSemantics *Sem = &F.getSemantics();
+    AppendRaw(&Sem, sizeof(Sem));
+    AppendInt(F.bitcastToAPInt());
+  };
+
+  Out.push_back((char)V.getKind());
+  switch (V.getKind()) {
+  case APValue::Int:
+    Out.push_back(V.getInt().isSigned());
+    AppendInt(V.getInt());
+    return true;
+  case APValue::Float:
+    AppendFloat(V.getFloat());
+    return true;
+  case APValue::ComplexInt:
+    AppendInt(V.getComplexIntReal());
+    AppendInt(V.getComplexIntImag());
+    return true;
+  case APValue::ComplexFloat:
+    AppendFloat(V.getComplexFloatReal());
+    AppendFloat(V.getComplexFloatImag());
+    return true;
+  case APValue::Vector: {
+    unsigned N = V.getVectorLength();
+    AppendRaw(&N, sizeof(N));
+    for (unsigned I = 0; I != N; ++I)
+      if (!encodeLiteralValue(V.getVectorElt(I), Out))
+        return false;
+    return true;
+  }
+  case APValue::Array: {
+    unsigned Size = V.getArraySize();
+    unsigned N = V.getArrayInitializedElts();
+    AppendRaw(&Size, sizeof(Size));
+    AppendRaw(&N, sizeof(N));
+    for (unsigned I = 0; I != N; ++I)
+      if (!encodeLiteralValue(V.getArrayInitializedElt(I), Out))
+        return false;
+    return !V.hasArrayFiller() || encodeLiteralValue(V.getArrayFiller(), Out);
+  }
+  case APValue::Struct: {
+    unsigned NumBases = V.getStructNumBases();
+    unsigned NumFields = V.getStructNumFields();
+    AppendRaw(&NumBases, sizeof(NumBases));
+    AppendRaw(&NumFields, sizeof(NumFields));
+    for (unsigned I = 0; I != NumBases; ++I)
+      if (!encodeLiteralValue(V.getStructBase(I), Out))
+        return false;
+    for (unsigned I = 0; I != NumFields; ++I)
+      if (!encodeLiteralValue(V.getStructField(I), Out))
+        return false;
+    return true;
+  }
+  case APValue::Union: {
+    const FieldDecl *FD = V.getUnionField();
+    AppendRaw(&FD, sizeof(FD));
+    return !FD || encodeLiteralValue(V.getUnionValue(), Out);
+  }
+  case APValue::Uninitialized:
+  case APValue::LValue:
+  case APValue::MemberPointer:
+  case APValue::AddrLabelDiff:
+    return false;
+  }
+  llvm_unreachable("unknown APValue kind");
+}
+
+/// Build the key under which the value of a call to \p Callee with the
+/// arguments \p ArgValues is memoized in the ASTContext. Returns false if
+/// the call cannot be memoized.
+static bool getConstexprCallKey(const FunctionDecl *Callee,
+                                ArrayRef<APValue> ArgValues, EvalInfo &Info,
+                                SmallVectorImpl<char> &Key) {
+  // Potential constant expressions are checked without argument values.
+  if (Info.checkingPotentialConstantExpression())
+    return false;
+  // While a variable is being initialized, a call can read and, in C++14,
+  // modify the parts of it that are already initialized, so its value may
+  // differ from that of the same call elsewhere.
+  if (Info.EvaluatingDecl)
+    return false;
+  Callee = Callee->getCanonicalDecl();
+  Key.append((const char *)&Callee, (const char *)&Callee + sizeof(Callee));
+  Key.push_back((char)Info.EvalMode);
+  for (const APValue &Arg : ArgValues)
+    if (!encodeLiteralValue(Arg, Key))
+      return false;
+  return true;
+}
+
+/// Evaluate a function call.
+static bool HandleFunctionCall(SourceLocation CallLoc,
+                               const FunctionDecl *Callee, const LValue *This,
+                               ArrayRef<const Expr*> Args, const Stmt *Body,
+                               EvalInfo &Info, APValue &Result,
+                               const LValue *ResultSlot) {
+  ArgVector ArgValues(Args.size());
+  if (!EvaluateArgs(Args, ArgValues, Info))
+    return false;
+
+  if (!Info.CheckCallLimit(CallLoc))
+    return false;
+
+  // A call without an object argument, whose arguments are all literal
+  // values, made outside the initializer of a variable, can only observe its
+  // arguments and constants. If evaluating it noted no issues, its value can
+  // be reused for identical calls, as long as they fit within the remaining
+  // step and depth limits; otherwise they are evaluated, so that the limits
+  // are diagnosed as before.
+  SmallString<64> MemoKey;
+  if (!This && getConstexprCallKey(Callee, ArgValues, Info, MemoKey)) {
+    if (const ASTContext::ConstexprCallResult *Memo =
+            Info.Ctx.getConstexprCallResult(MemoKey)) {
+      if (Memo->Steps <= Info.StepsLeft &&
+          Info.CallStackDepth + Memo->Depth <=
+              Info.getLangOpts().ConstexprCallDepth) {
+        ++ASTContext::NumConstexprCallCacheHits;
+        ASTContext::NumConstexprStepsSaved += Memo->Steps;
+        Info.StepsLeft -= Memo->Steps;
+        Info.MaxCallStackDepth = std::max(Info.MaxCallStackDepth,
+                                          Info.CallStackDepth + Memo->Depth);
+        Result = Memo->Value;
+        return true;
+      }
+    } else {
+      ++ASTContext::NumConstexprCallCacheMisses;
+    }
+  } else {
+    MemoKey.clear();
+  }
+
+  unsigned StepsBefore = Info.StepsLeft;
+  unsigned IssuesBefore = Info.NumIssues;
+  unsigned OuterMaxDepth = Info.MaxCallStackDepth;
+  Info.MaxCallStackDepth = Info.CallStackDepth;
+  bool Success = HandleFunctionBody(CallLoc, Callee, This, Args, ArgValues,
+                                    Body, Info, Result, ResultSlot);
+  unsigned Depth = Info.MaxCallStackDepth - Info.CallStackDepth;
+  Info.MaxCallStackDepth = std::max(OuterMaxDepth, Info.MaxCallStackDepth);
+
+  SmallString<64> ResultEncoding;
+  if (Success && !MemoKey.empty() && Info.NumIssues == IssuesBefore &&
+      !Callee->getReturnType()->isVoidType() &&
+      encodeLiteralValue(Result, ResultEncoding))
+    Info.Ctx.setConstexprCallResult(MemoKey, Result,
+                                    StepsBefore - Info.StepsLeft, Depth);
+  return Success;
+}
+
 /// Evaluate a constructor call.
 static bool HandleConstructorCall(const Expr *E, const LValue &This,
                                   APValue *ArgValues,
@@ -11,6 +11,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "clang/AST/ASTAllocationStats.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ASTDiagnostic.h"
 #include "clang/AST/ExprCXX.h"
@@ -52,7 +53,12 @@ static StmtClassNameTable &getStmtInfoTableEntry(Stmt::StmtClass E) {
 
 void *Stmt::operator new(size_t bytes, const ASTContext& C,
                          unsigned alignment) {
-  return ::operator new(bytes, C, alignment);
+  void *Mem = C.allocateRecycledStmt(bytes, alignment);
+  if (!Mem)
+    Mem = ::operator new(bytes, C, alignment);
+  if (ASTAllocationStats *Stats = ASTAllocationStats::getActive())
+    Stats->noteAllocation(Mem, bytes);
+  return Mem;
 }
 
 const char *Stmt::getStmtClassName() const {
@@ -85,7 +91,12 @@ void Stmt::PrintStats() {
 }
 
 void Stmt::addStmtClass(StmtClass s) {
-  ++getStmtInfoTableEntry(s).Counter;
+  StmtClassNameTable &Entry = getStmtInfoTableEntry(s);
+  ++Entry.Counter;
+
+  if (ASTAllocationStats *Stats = ASTAllocationStats::getActive())
+    Stats->addNode(ASTAllocationStats::NC_Stmt, Entry.Name, this, Entry.Size,
+                   SourceLocation());
 }
 
 bool Stmt::StatisticsEnabled = false;
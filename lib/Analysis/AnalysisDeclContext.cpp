@@ -30,6 +30,8 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/SaveAndRestore.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <vector>
 
 using namespace clang;
 
@@ -87,6 +89,28 @@ AnalysisDeclContextManager::AnalysisDeclContextManager(bool useUnoptimizedCFG,
 
 void AnalysisDeclContextManager::clear() { Contexts.clear(); }
 
+void AnalysisDeclContextManager::trim(unsigned MaxContexts) {
+  if (Contexts.size() <= MaxContexts)
+    return;
+  if (MaxContexts == 0) {
+    clear();
+    return;
+  }
+
+  // Find the oldest use that is still recent enough to be kept.
+  std::vector<unsigned> LastUses;
+  LastUses.reserve(Contexts.size());
+  for (const auto &I : Contexts)
+    LastUses.push_back(I.second.LastUse);
+  auto Threshold = LastUses.end() - MaxContexts;
+  std::nth_element(LastUses.begin(), Threshold, LastUses.end());
+
+  // Every request bumps UseCount, so the last uses are all distinct.
+  for (auto I = Contexts.begin(), E = Contexts.end(); I != E; ++I)
+    if (I->second.LastUse < *Threshold)
+      Contexts.erase(I);
+}
+
 static BodyFarm &getBodyFarm(ASTContext &C, CodeInjector *injector = nullptr) {
   static BodyFarm *BF = new BodyFarm(C, injector);
   return *BF;
@@ -311,10 +335,12 @@ AnalysisDeclContext *AnalysisDeclContextManager::getContext(const Decl *D) {
     D = FD;
   }
 
-  std::unique_ptr<AnalysisDeclContext> &AC = Contexts[D];
-  if (!AC)
-    AC = llvm::make_unique<AnalysisDeclContext>(this, D, cfgBuildOptions);
-  return AC.get();
+  CachedContext &AC = Contexts[D];
+  if (!AC.Context)
+    AC.Context =
+        llvm::make_unique<AnalysisDeclContext>(this, D, cfgBuildOptions);
+  AC.LastUse = ++UseCount;
+  return AC.Context.get();
 }
 
 const StackFrameContext *
@@ -15,8 +15,12 @@
 
 #include "clang/AST/DataCollection.h"
 #include "clang/AST/DeclTemplate.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/MD5.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace clang;
 
@@ -300,6 +304,84 @@ saveHash(const Stmt *S, const Decl *D,
   return HashCode;
 }
 
+namespace {
+/// The hashes of a statement or sequence in a clone fingerprint. They only
+/// depend on the statements, not on the host or the run, so that the hashes
+/// of different translation units can be compared.
+struct FingerprintHashes {
+  /// The hash that clones are grouped by.
+  uint64_t Hash;
+  /// A second hash of the same statements, computed independently, which
+  /// is compared to detect collisions of the first one.
+  uint64_t Profile;
+};
+} // end anonymous namespace
+
+/// Combines the hash of a sequence of statements with the hash of the
+/// statement that follows it, in constant time.
+static uint64_t combineHashes(uint64_t SequenceHash, uint64_t StmtHash) {
+  // This is the 128 to 64 bit reduction of CityHash, which llvm::hash_combine
+  // uses as well.
+  const uint64_t Mul = 0x9ddfea08eb382d69ULL;
+  uint64_t A = (SequenceHash ^ StmtHash) * Mul;
+  A ^= (A >> 47);
+  uint64_t B = (StmtHash ^ A) * Mul;
+  B ^= (B >> 47);
+  B *= Mul;
+  return B;
+}
+
+/// Like saveHash, but computes the hashes of clone fingerprints. Child
+/// hashes are added to the MD5 state as little-endian 64-bit integers, and the
+/// two halves of the digest are read as little-endian integers.
+static FingerprintHashes saveFingerprintHashes(
+    const Stmt *S, const Decl *D,
+    std::vector<std::pair<FingerprintHashes, StmtSequence>> &StmtsByHash) {
+  llvm::MD5 Hash;
+  ASTContext &Context = D->getASTContext();
+
+  CloneTypeIIStmtDataCollector<llvm::MD5>(S, Context, Hash);
+
+  auto CS = dyn_cast<CompoundStmt>(S);
+  SmallVector<FingerprintHashes, 8> ChildHashes;
+
+  for (const Stmt *Child : S->children()) {
+    if (Child == nullptr) {
+      ChildHashes.push_back({0, 0});
+      continue;
+    }
+    FingerprintHashes ChildHash = saveFingerprintHashes(Child, D, StmtsByHash);
+    uint8_t Bytes[16];
+    llvm::support::endian::write64le(Bytes, ChildHash.Hash);
+    llvm::support::endian::write64le(Bytes + 8, ChildHash.Profile);
+    Hash.update(Bytes);
+    ChildHashes.push_back(ChildHash);
+  }
+
+  if (CS) {
+    // Each sub-sequence extends the hashes of the one that is one statement
+    // shorter, so that every child hash is combined exactly once per
+    // starting position.
+    for (unsigned Pos = 0; Pos < CS->size(); ++Pos) {
+      FingerprintHashes SubHash = {0, 0};
+      for (unsigned Length = 1; Length <= CS->size() - Pos; ++Length) {
+        const FingerprintHashes &ChildHash = ChildHashes[Pos + Length - 1];
+        SubHash.Hash = combineHashes(SubHash.Hash, ChildHash.Hash);
+        SubHash.Profile = combineHashes(SubHash.Profile, ChildHash.Profile);
+        if (Length > 1)
+          StmtsByHash.push_back(
+              std::make_pair(SubHash, StmtSequence(CS, D, Pos, Pos + Length)));
+      }
+    }
+  }
+
+  llvm::MD5::MD5Result HashResult;
+  Hash.final(HashResult);
+  FingerprintHashes Result = {HashResult.low(), HashResult.high()};
+  StmtsByHash.push_back(std::make_pair(Result, StmtSequence(S, D)));
+  return Result;
+}
+
 namespace {
 /// Wrapper around FoldingSetNodeID that it can be used as the template
 /// argument of the StmtDataCollector.
@@ -421,6 +503,133 @@ void RecursiveCloneTypeIIVerifyConstraint::constrain(
       });
 }
 
+unsigned CloneFingerprintSet::getFileIndex(StringRef File) {
+  auto Entry = FileIndexes.insert(std::make_pair(File, Files.size()));
+  if (Entry.second)
+    Files.push_back(File.str());
+  return Entry.first->second;
+}
+
+void CloneFingerprintSet::addTranslationUnit(
+    const CloneDetector::CloneGroup &Sequences, unsigned MinComplexity,
+    unsigned NumMainFileLines) {
+  ++NumTranslationUnits;
+  NumLines += NumMainFileLines;
+
+  std::vector<std::pair<FingerprintHashes, StmtSequence>> StmtsByHash;
+  for (const StmtSequence &S : Sequences)
+    saveFingerprintHashes(S.front(), S.getContainingDecl(), StmtsByHash);
+
+  MinComplexityConstraint Complexity(MinComplexity);
+  llvm::DenseMap<FileID, unsigned> FileIndexesByID;
+  for (const auto &HashAndSeq : StmtsByHash) {
+    const StmtSequence &Seq = HashAndSeq.second;
+    if (Complexity.calculateStmtComplexity(Seq, MinComplexity) < MinComplexity)
+      continue;
+
+    const SourceManager &SM = Seq.getASTContext().getSourceManager();
+    SourceLocation Begin = SM.getExpansionLoc(Seq.getStartLoc());
+    SourceLocation End = SM.getExpansionLoc(Seq.getEndLoc());
+    FileID FID = SM.getFileID(Begin);
+    const FileEntry *Entry = SM.getFileEntryForID(FID);
+    if (!Entry || SM.getFileID(End) != FID)
+      continue;
+
+    // Make the paths absolute, so that the fingerprints of translation units
+    // compiled in different directories can be merged.
+    auto FileIndex = FileIndexesByID.find(FID);
+    if (FileIndex == FileIndexesByID.end()) {
+      SmallString<128> Path(Entry->getName());
+      llvm::sys::fs::make_absolute(Path);
+      llvm::sys::path::remove_dots(Path, /*remove_dot_dot=*/true);
+      FileIndex =
+          FileIndexesByID.insert(std::make_pair(FID, getFileIndex(Path)))
+              .first;
+    }
+
+    CloneFingerprint FP;
+    FP.Hash = HashAndSeq.first.Hash;
+    FP.Profile = HashAndSeq.first.Profile;
+    FP.File = FileIndex->second;
+    FP.BeginLine = SM.getExpansionLineNumber(Begin);
+    FP.BeginColumn = SM.getExpansionColumnNumber(Begin);
+    FP.EndLine = SM.getExpansionLineNumber(End);
+    FP.EndColumn = SM.getExpansionColumnNumber(End);
+    Fingerprints.push_back(FP);
+  }
+}
+
+// The fingerprints are written as a header line, followed by a line for each
+// file, and then a line for each fingerprint:
+//
+//   clone-fingerprints <translation units> <lines>
+//   file <path>
+//   <hash> <profile> <file index> <begin line> <begin column> <end line>
+//     <end column>
+//
+// The file indexes refer to the order of the file lines in the same buffer.
+
+void CloneFingerprintSet::write(raw_ostream &OS) const {
+  OS << "clone-fingerprints " << NumTranslationUnits << ' ' << NumLines
+     << '\n';
+  for (const std::string &File : Files)
+    OS << "file " << File << '\n';
+  for (const CloneFingerprint &FP : Fingerprints)
+    OS << llvm::format_hex_no_prefix(FP.Hash, 16) << ' '
+       << llvm::format_hex_no_prefix(FP.Profile, 16) << ' ' << FP.File << ' '
+       << FP.BeginLine << ' ' << FP.BeginColumn << ' ' << FP.EndLine << ' '
+       << FP.EndColumn << '\n';
+}
+
+bool CloneFingerprintSet::read(StringRef Buffer) {
+  StringRef Line;
+  std::tie(Line, Buffer) = Buffer.split('\n');
+
+  SmallVector<StringRef, 6> Fields;
+  Line.rtrim().split(Fields, ' ');
+  unsigned ReadTranslationUnits;
+  uint64_t ReadLines;
+  if (Fields.size() != 3 || Fields[0] != "clone-fingerprints" ||
+      Fields[1].getAsInteger(10, ReadTranslationUnits) ||
+      Fields[2].getAsInteger(10, ReadLines))
+    return false;
+
+  // Map the file indexes of the buffer to the ones of this set.
+  std::vector<unsigned> ReadFiles;
+  std::vector<CloneFingerprint> ReadFingerprints;
+  while (!Buffer.empty()) {
+    std::tie(Line, Buffer) = Buffer.split('\n');
+    Line = Line.rtrim();
+    if (Line.empty())
+      continue;
+
+    if (Line.startswith("file ")) {
+      ReadFiles.push_back(getFileIndex(Line.drop_front(5)));
+      continue;
+    }
+
+    Fields.clear();
+    Line.split(Fields, ' ');
+    CloneFingerprint FP;
+    if (Fields.size() != 7 || Fields[0].getAsInteger(16, FP.Hash) ||
+        Fields[1].getAsInteger(16, FP.Profile) ||
+        Fields[2].getAsInteger(10, FP.File) || FP.File >= ReadFiles.size() ||
+        Fields[3].getAsInteger(10, FP.BeginLine) ||
+        Fields[4].getAsInteger(10, FP.BeginColumn) ||
+        Fields[5].getAsInteger(10, FP.EndLine) ||
+        Fields[6].getAsInteger(10, FP.EndColumn))
+      return false;
+    FP.File = ReadFiles[FP.File];
+    ReadFingerprints.push_back(FP);
+  }
+
+  NumTranslationUnits += ReadTranslationUnits;
+  NumLines += ReadLines;
+  Fingerprints.insert(Fingerprints.end(), ReadFingerprints.begin(),
+                      ReadFingerprints.end());
+  return true;
+}
+
 size_t MinComplexityConstraint::calculateStmtComplexity(
     const StmtSequence &Seq, std::size_t Limit,
     const std::string &ParentMacroStack) {
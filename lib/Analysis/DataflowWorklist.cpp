@@ -0,0 +1,79 @@
+//===- DataflowWorklist.cpp - Worklists for CFG dataflow analyses -*- C++ --*-//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the worklists shared by the dataflow analyses that run
+// on source-level CFGs.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Analysis/Analyses/DataflowWorklist.h"
+#include "clang/Analysis/Analyses/PostOrderCFGView.h"
+#include "clang/Analysis/AnalysisContext.h"
+#include <algorithm>
+#include <functional>
+
+using namespace clang;
+
+DataflowWorklistBase::DataflowWorklistBase(const CFG &cfg,
+                                           const PostOrderCFGView &POV,
+                                           bool IsForward)
+    : EnqueuedBlocks(cfg.getNumBlockIDs()) {
+  // Blocks that cannot be reached from the entry are not in the view. They
+  // come last in a forward analysis, which only reaches them through other
+  // unreachable blocks, and first in a backward one, as they have no
+  // successors in the view to wait for.
+  unsigned NumBlocks = std::distance(POV.begin(), POV.end());
+  Priorities.assign(cfg.getNumBlockIDs(), IsForward ? NumBlocks : 0);
+
+  // The view iterates in reverse post order.
+  unsigned Index = 0;
+  for (const CFGBlock *Block : POV) {
+    Priorities[Block->getBlockID()] = IsForward ? Index : NumBlocks - Index;
+    ++Index;
+  }
+}
+
+void DataflowWorklistBase::enqueueBlock(const CFGBlock *Block) {
+  if (!Block || EnqueuedBlocks[Block->getBlockID()])
+    return;
+  EnqueuedBlocks[Block->getBlockID()] = true;
+  Heap.push_back(Entry(Priorities[Block->getBlockID()], Block));
+  std::push_heap(Heap.begin(), Heap.end(), std::greater<Entry>());
+}
+
+const CFGBlock *DataflowWorklistBase::dequeue() {
+  if (Heap.empty())
+    return nullptr;
+  std::pop_heap(Heap.begin(), Heap.end(), std::greater<Entry>());
+  const CFGBlock *Block = Heap.pop_back_val().second;
+  EnqueuedBlocks[Block->getBlockID()] = false;
+  return Block;
+}
+
+ForwardDataflowWorklist::ForwardDataflowWorklist(const CFG &cfg,
+                                                 AnalysisDeclContext &Ctx)
+    : DataflowWorklistBase(cfg, *Ctx.getAnalysis<PostOrderCFGView>(),
+                           /*IsForward=*/true) {}
+
+void ForwardDataflowWorklist::enqueueSuccessors(const CFGBlock *Block) {
+  for (CFGBlock::const_succ_iterator I = Block->succ_begin(),
+       E = Block->succ_end(); I != E; ++I)
+    enqueueBlock(*I);
+}
+
+BackwardDataflowWorklist::BackwardDataflowWorklist(const CFG &cfg,
+                                                   AnalysisDeclContext &Ctx)
+    : DataflowWorklistBase(cfg, *Ctx.getAnalysis<PostOrderCFGView>(),
+                           /*IsForward=*/false) {}
+
+void BackwardDataflowWorklist::enqueuePredecessors(const CFGBlock *Block) {
+  for (CFGBlock::const_pred_iterator I = Block->pred_begin(),
+       E = Block->pred_end(); I != E; ++I)
+    enqueueBlock(*I);
+}
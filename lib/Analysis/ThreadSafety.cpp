@@ -32,6 +32,7 @@
 #include "clang/Basic/OperatorKinds.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/ImmutableMap.h"
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/SmallVector.h"
@@ -81,6 +82,40 @@ public:
   }
 };
 
+/// \brief Return a hash of the parts of a TIL expression that another
+/// expression must share to match it, or zero if it is a wildcard, which may
+/// match anything.  Only the chain of projections that most capabilities are
+/// made of is hashed; other expressions are hashed by opcode alone.
+static size_t getMatchKey(const til::SExpr *E) {
+  if (!E || isa<til::Wildcard>(E))
+    return 0;
+
+  size_t Key;
+  if (const auto *P = dyn_cast<til::Project>(E)) {
+    size_t RecordKey = getMatchKey(P->record());
+    if (!RecordKey)
+      return 0;
+    Key = llvm::hash_combine(E->opcode(), RecordKey, P->clangDecl());
+  } else if (const auto *P = dyn_cast<til::LiteralPtr>(E)) {
+    Key = llvm::hash_combine(E->opcode(), P->clangDecl());
+  } else {
+    Key = llvm::hash_value(E->opcode());
+  }
+  return Key ? Key : 1;
+}
+
+/// \brief Return the match key of a capability, which is zero if it may match
+/// capabilities of any shape.  Two capabilities with different nonzero keys
+/// never match, so lookups can skip most facts without comparing their
+/// expressions.
+static size_t getMatchKey(const CapabilityExpr &CapE) {
+  size_t Key = getMatchKey(CapE.sexpr());
+  if (!Key)
+    return 0;
+  Key = llvm::hash_combine(Key, CapE.negative());
+  return Key ? Key : 1;
+}
+
 class FactManager;
 class FactSet;
 
@@ -98,12 +133,13 @@ private:
   SourceLocation    AcquireLoc;       ///<  where it was acquired.
   bool              Asserted;         ///<  true if the lock was asserted
   bool              Declared;         ///<  true if the lock was declared
+  size_t            MatchKey;         ///<  see getMatchKey
 
 public:
   FactEntry(const CapabilityExpr &CE, LockKind LK, SourceLocation Loc,
             bool Asrt, bool Declrd = false)
       : CapabilityExpr(CE), LKind(LK), AcquireLoc(Loc), Asserted(Asrt),
-        Declared(Declrd) {}
+        Declared(Declrd), MatchKey(getMatchKey(CE)) {}
 
   virtual ~FactEntry() {}
 
@@ -114,6 +150,12 @@ public:
 
   void setDeclared(bool D) { Declared = D; }
 
+  /// Return false if this fact cannot match a capability with the given
+  /// match key.
+  bool mayMatch(size_t Key) const {
+    return !Key || !MatchKey || Key == MatchKey;
+  }
+
   virtual void
   handleRemovalFromIntersection(const FactSet &FSet, FactManager &FactMan,
                                 SourceLocation JoinLoc, LockErrorKind LEK,
@@ -196,14 +238,17 @@ public:
     if (n == 0)
       return false;
 
+    size_t Key = getMatchKey(CapE);
     for (unsigned i = 0; i < n-1; ++i) {
-      if (FM[FactIDs[i]].matches(CapE)) {
+      const FactEntry &Fact = FM[FactIDs[i]];
+      if (Fact.mayMatch(Key) && Fact.matches(CapE)) {
         FactIDs[i] = FactIDs[n-1];
         FactIDs.pop_back();
         return true;
       }
     }
-    if (FM[FactIDs[n-1]].matches(CapE)) {
+    const FactEntry &Fact = FM[FactIDs[n-1]];
+    if (Fact.mayMatch(Key) && Fact.matches(CapE)) {
       FactIDs.pop_back();
       return true;
     }
@@ -211,21 +256,24 @@ public:
   }
 
   iterator findLockIter(FactManager &FM, const CapabilityExpr &CapE) {
+    size_t Key = getMatchKey(CapE);
     return std::find_if(begin(), end(), [&](FactID ID) {
-      return FM[ID].matches(CapE);
+      return FM[ID].mayMatch(Key) && FM[ID].matches(CapE);
     });
   }
 
   FactEntry *findLock(FactManager &FM, const CapabilityExpr &CapE) const {
+    size_t Key = getMatchKey(CapE);
     auto I = std::find_if(begin(), end(), [&](FactID ID) {
-      return FM[ID].matches(CapE);
+      return FM[ID].mayMatch(Key) && FM[ID].matches(CapE);
     });
     return I != end() ? &FM[*I] : nullptr;
   }
 
   FactEntry *findLockUniv(FactManager &FM, const CapabilityExpr &CapE) const {
+    size_t Key = getMatchKey(CapE);
     auto I = std::find_if(begin(), end(), [&](FactID ID) -> bool {
-      return FM[ID].matchesUniv(CapE);
+      return FM[ID].mayMatch(Key) && FM[ID].matchesUniv(CapE);
     });
     return I != end() ? &FM[*I] : nullptr;
   }
@@ -27,7 +27,10 @@
 #include "llvm/CodeGen/RegAllocRegistry.h"
 #include "llvm/CodeGen/SchedulerRegistry.h"
 #include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/IR/IRPrintingPasses.h"
+#include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/ModuleSummaryIndex.h"
@@ -40,6 +43,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
@@ -54,7 +58,9 @@
 #include "llvm/Transforms/ObjCARC.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/NameAnonGlobals.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "llvm/Transforms/Utils/SymbolRewriter.h"
 #include <memory>
 using namespace clang;
@@ -102,6 +108,19 @@ class EmitAssemblyHelper {
   bool AddEmitPasses(legacy::PassManager &CodeGenPasses, BackendAction Action,
                      raw_pwrite_stream &OS);
 
+  /// Whether code generation for \p Action is split across threads
+  /// (-fparallel-codegen).
+  bool usesParallelCodeGen(BackendAction Action) const {
+    return Action == Backend_EmitObj && CodeGenOpts.ParallelCodeGenJobs > 1;
+  }
+
+  /// Split the module into CodeGenOpts.ParallelCodeGenJobs partitions and
+  /// generate an object file for each of them on a thread of its own.
+  ///
+  /// The first partition is written to \p OS, and partition I to
+  /// "<ParallelCodeGenOutputFile>.I", for the driver to link them together.
+  void EmitObjectInParallel(raw_pwrite_stream &OS);
+
 public:
   EmitAssemblyHelper(DiagnosticsEngine &_Diags,
                      const HeaderSearchOptions &HeaderSearchOpts,
@@ -122,6 +141,10 @@ public:
   void EmitAssembly(BackendAction Action,
                     std::unique_ptr<raw_pwrite_stream> OS);
 
+  /// Create the per-function passes that EmitAssembly runs before the
+  /// per-module passes, for an EarlyFunctionPassRunner.
+  void CreateFunctionPasses(legacy::FunctionPassManager &FPM);
+
   void EmitAssemblyWithNewPassManager(BackendAction Action,
                                       std::unique_ptr<raw_pwrite_stream> OS);
 };
@@ -673,27 +696,37 @@ void EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
                                           Options, RM, CM, OptLevel));
 }
 
-bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
-                                       BackendAction Action,
-                                       raw_pwrite_stream &OS) {
+/// Add the passes that generate code for a module with \p TM.
+///
+/// \return True on success.
+static bool addCodeGenPasses(legacy::PassManager &CodeGenPasses,
+                             TargetMachine &TM, const CodeGenOptions &CGOpts,
+                             TargetMachine::CodeGenFileType CGFT,
+                             raw_pwrite_stream &OS) {
   // Add LibraryInfo.
-  llvm::Triple TargetTriple(TheModule->getTargetTriple());
+  llvm::Triple TargetTriple(TM.getTargetTriple());
   std::unique_ptr<TargetLibraryInfoImpl> TLII(
-      createTLII(TargetTriple, CodeGenOpts));
+      createTLII(TargetTriple, CGOpts));
   CodeGenPasses.add(new TargetLibraryInfoWrapperPass(*TLII));
 
-  // Normal mode, emit a .s or .o file by running the code generator. Note,
-  // this also adds codegenerator level optimization passes.
-  TargetMachine::CodeGenFileType CGFT = getCodeGenFileType(Action);
-
   // Add ObjC ARC final-cleanup optimizations. This is done as part of the
   // "codegen" passes so that it isn't run multiple times when there is
   // inlining happening.
-  if (CodeGenOpts.OptimizationLevel > 0)
+  if (CGOpts.OptimizationLevel > 0)
     CodeGenPasses.add(createObjCARCContractPass());
 
-  if (TM->addPassesToEmitFile(CodeGenPasses, OS, CGFT,
-                              /*DisableVerify=*/!CodeGenOpts.VerifyModule)) {
+  return !TM.addPassesToEmitFile(CodeGenPasses, OS, CGFT,
+                                 /*DisableVerify=*/!CGOpts.VerifyModule);
+}
+
+bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
+                                       BackendAction Action,
+                                       raw_pwrite_stream &OS) {
+  // Normal mode, emit a .s or .o file by running the code generator. Note,
+  // this also adds codegenerator level optimization passes.
+  TargetMachine::CodeGenFileType CGFT = getCodeGenFileType(Action);
+
+  if (!addCodeGenPasses(CodeGenPasses, *TM, CodeGenOpts, CGFT, OS)) {
     Diags.Report(diag::err_fe_unable_to_interface_with_target);
     return false;
   }
@@ -701,11 +734,155 @@ bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
   return true;
 }
 
+typedef std::vector<std::pair<DiagnosticSeverity, std::string>>
+    PartitionDiagnostics;
+
+/// Record a diagnostic reported while generating code for a partition, to be
+/// reported on the main thread once all the partitions are done.
+static void handlePartitionDiagnostic(const DiagnosticInfo &DI,
+                                      void *Context) {
+  std::string Message;
+  raw_string_ostream Stream(Message);
+  DiagnosticPrinterRawOStream DP(Stream);
+  DI.print(DP);
+  static_cast<PartitionDiagnostics *>(Context)->emplace_back(DI.getSeverity(),
+                                                             Stream.str());
+}
+
+void EmitAssemblyHelper::EmitObjectInParallel(raw_pwrite_stream &OS) {
+  unsigned Jobs = CodeGenOpts.ParallelCodeGenJobs;
+
+  SmallVector<raw_pwrite_stream *, 8> PartitionOS;
+  std::vector<std::unique_ptr<raw_fd_ostream>> PartitionFiles;
+  PartitionOS.push_back(&OS);
+  for (unsigned I = 1; I != Jobs; ++I) {
+    std::string Name = CodeGenOpts.ParallelCodeGenOutputFile + "." + utostr(I);
+    std::error_code EC;
+    PartitionFiles.push_back(
+        llvm::make_unique<raw_fd_ostream>(Name, EC, sys::fs::F_None));
+    if (EC) {
+      Diags.Report(diag::err_fe_unable_to_open_output) << Name << EC.message();
+      return;
+    }
+    PartitionOS.push_back(PartitionFiles.back().get());
+  }
+
+  // The partitions share the context of the module, so they are serialized
+  // here and each thread loads its partition into a context of its own.
+  // Local symbols are kept in the partition of their users rather than
+  // promoted to hidden globals, which could clash with the locals of other
+  // translation units once the partitions are linked together. Partitioning
+  // only depends on the module, so the output is the same on every run.
+  SmallVector<SmallString<0>, 8> Partitions;
+  auto AddPartition = [&](const Module &MPart) {
+    Partitions.emplace_back();
+    raw_svector_ostream BCOS(Partitions.back());
+    WriteBitcodeToFile(&MPart, BCOS);
+  };
+  if (TheModule->getModuleInlineAsm().empty()) {
+    SplitModule(CloneModule(TheModule), Jobs,
+                [&](std::unique_ptr<Module> MPart) { AddPartition(*MPart); },
+                /*PreserveLocals=*/true);
+  } else {
+    // SplitModule copies the module-level inline assembly into every
+    // partition, which would define its symbols once per partition, and does
+    // not see the local symbols the assembly refers to. Generate the whole
+    // module in the first partition instead, and leave the others empty.
+    AddPartition(*TheModule);
+    for (unsigned I = 1; I != Jobs; ++I) {
+      Module Empty(TheModule->getModuleIdentifier(), TheModule->getContext());
+      Empty.setTargetTriple(TheModule->getTargetTriple());
+      Empty.setDataLayout(TheModule->getDataLayout());
+      AddPartition(Empty);
+    }
+  }
+
+  // Target machines are not thread-safe, so each partition gets its own.
+  std::vector<std::unique_ptr<TargetMachine>> PartitionTMs;
+  for (unsigned I = 0; I != Jobs; ++I)
+    PartitionTMs.emplace_back(TM->getTarget().createTargetMachine(
+        TM->getTargetTriple().str(), TM->getTargetCPU(),
+        TM->getTargetFeatureString(), TM->Options, getRelocModel(CodeGenOpts),
+        getCodeModel(CodeGenOpts), getCGOptLevel(CodeGenOpts)));
+
+  std::vector<PartitionDiagnostics> PartitionDiags(Jobs);
+  {
+    ThreadPool Pool(Jobs);
+    for (unsigned I = 0; I != Jobs; ++I) {
+      Pool.async([&, I] {
+        LLVMContext Context;
+        Context.setDiagnosticHandlerCallBack(handlePartitionDiagnostic,
+                                             &PartitionDiags[I],
+                                             /*RespectFilters=*/true);
+
+        StringRef Bitcode(Partitions[I].data(), Partitions[I].size());
+        Expected<std::unique_ptr<Module>> MPartOrErr =
+            parseBitcodeFile(MemoryBufferRef(Bitcode, "<split-module>"),
+                             Context);
+        if (!MPartOrErr) {
+          PartitionDiags[I].emplace_back(DS_Error,
+                                         toString(MPartOrErr.takeError()));
+          return;
+        }
+
+        TargetMachine &PartTM = *PartitionTMs[I];
+        legacy::PassManager CodeGenPasses;
+        CodeGenPasses.add(
+            createTargetTransformInfoWrapperPass(PartTM.getTargetIRAnalysis()));
+        if (!addCodeGenPasses(CodeGenPasses, PartTM, CodeGenOpts,
+                              TargetMachine::CGFT_ObjectFile,
+                              *PartitionOS[I])) {
+          PartitionDiags[I].emplace_back(
+              DS_Error, "unable to interface with target machine");
+          return;
+        }
+        CodeGenPasses.run(**MPartOrErr);
+      });
+    }
+    Pool.wait();
+  }
+
+  // Report the diagnostics in partition order, so that they do not depend on
+  // the order in which the threads finished.
+  for (const PartitionDiagnostics &PD : PartitionDiags) {
+    for (const auto &D : PD) {
+      switch (D.first) {
+      case DS_Error:
+        Diags.Report(diag::err_fe_backend_plugin) << D.second;
+        break;
+      case DS_Warning:
+        Diags.Report(diag::warn_fe_backend_plugin) << D.second;
+        break;
+      case DS_Remark:
+        Diags.Report(diag::remark_fe_backend_plugin) << D.second;
+        break;
+      case DS_Note:
+        Diags.Report(diag::note_fe_backend_plugin) << D.second;
+        break;
+      }
+    }
+  }
+}
+
+void EmitAssemblyHelper::CreateFunctionPasses(
+    legacy::FunctionPassManager &FPM) {
+  setCommandLineOpts(CodeGenOpts);
+  CreateTargetMachine(/*MustCreateTM=*/false);
+
+  FPM.add(createTargetTransformInfoWrapperPass(getTargetIRAnalysis()));
+  legacy::PassManager MPM;
+  CreatePasses(MPM, FPM);
+}
+
 void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
                                       std::unique_ptr<raw_pwrite_stream> OS) {
   TimeRegion Region(llvm::TimePassesIsEnabled ? &CodeGenerationTime : nullptr);
 
-  setCommandLineOpts(CodeGenOpts);
+  // With -fpipelined-codegen, CodeGen has already parsed the backend options
+  // and run the per-function passes.
+  bool RanFunctionPasses = ShouldPipelineFunctionPasses(CodeGenOpts, LangOpts);
+  if (!RanFunctionPasses)
+    setCommandLineOpts(CodeGenOpts);
 
   bool UsesCodeGen = (Action != Backend_EmitNothing &&
                       Action != Backend_EmitBC &&
@@ -764,6 +941,8 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
     break;
 
   default:
+    if (usesParallelCodeGen(Action))
+      break;
     if (!AddEmitPasses(CodeGenPasses, Action, *OS))
       return;
   }
@@ -774,7 +953,7 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
   // Run passes. For now we do all passes at once, but eventually we
   // would like to have the option of streaming code generation.
 
-  {
+  if (!RanFunctionPasses) {
     PrettyStackTraceString CrashInfo("Per-function optimization");
 
     PerFunctionPasses.doInitialization();
@@ -791,7 +970,10 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
 
   {
     PrettyStackTraceString CrashInfo("Code generation");
-    CodeGenPasses.run(*TheModule);
+    if (usesParallelCodeGen(Action))
+      EmitObjectInParallel(*OS);
+    else
+      CodeGenPasses.run(*TheModule);
   }
 }
 
@@ -960,6 +1142,8 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
   case Backend_EmitMCNull:
   case Backend_EmitObj:
     NeedCodeGen = true;
+    if (usesParallelCodeGen(Action))
+      break;
     CodeGenPasses.add(
         createTargetTransformInfoWrapperPass(getTargetIRAnalysis()));
     if (!AddEmitPasses(CodeGenPasses, Action, *OS))
@@ -980,7 +1164,10 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
   // Now if needed, run the legacy PM for codegen.
   if (NeedCodeGen) {
     PrettyStackTraceString CrashInfo("Code generation");
-    CodeGenPasses.run(*TheModule);
+    if (usesParallelCodeGen(Action))
+      EmitObjectInParallel(*OS);
+    else
+      CodeGenPasses.run(*TheModule);
   }
 }
 
@@ -1157,6 +1344,53 @@ void clang::EmitBackendOutput(DiagnosticsEngine &Diags,
   }
 }
 
+bool clang::ShouldPipelineFunctionPasses(const CodeGenOptions &CGOpts,
+                                         const LangOptions &LOpts) {
+  // The new pass manager has no separate per-function passes, and at -O0
+  // there is nothing worth a thread. Passes that look at the whole module when
+  // they are initialized (ObjC ARC, coroutines, discriminators for sample
+  // profiles) would see it before it is complete. Remarks, pass timers and
+  // bitcode linked into the module are only set up for the backend.
+  return CGOpts.PipelinedCodeGen && CGOpts.OptimizationLevel > 0 &&
+         !CGOpts.DisableLLVMPasses && !CGOpts.ExperimentalNewPassManager &&
+         !LOpts.ObjCAutoRefCount && !LOpts.CoroutinesTS &&
+         !CGOpts.DebugInfoForProfiling && CGOpts.SampleProfileFile.empty() &&
+         !CGOpts.OptimizationRemarkPattern &&
+         !CGOpts.OptimizationRemarkMissedPattern &&
+         !CGOpts.OptimizationRemarkAnalysisPattern &&
+         CGOpts.OptRecordFile.empty() && !CGOpts.TimePasses &&
+         CGOpts.LinkBitcodeFiles.empty();
+}
+
+class EarlyFunctionPassRunner::Impl {
+public:
+  EmitAssemblyHelper Helper;
+  legacy::FunctionPassManager Passes;
+
+  Impl(DiagnosticsEngine &Diags, const HeaderSearchOptions &HeaderOpts,
+       const CodeGenOptions &CGOpts, const clang::TargetOptions &TOpts,
+       const LangOptions &LOpts, Module *M)
+      : Helper(Diags, HeaderOpts, CGOpts, TOpts, LOpts, M), Passes(M) {
+    Helper.CreateFunctionPasses(Passes);
+    Passes.doInitialization();
+  }
+};
+
+EarlyFunctionPassRunner::EarlyFunctionPassRunner(
+    DiagnosticsEngine &Diags, const HeaderSearchOptions &HeaderOpts,
+    const CodeGenOptions &CGOpts, const clang::TargetOptions &TOpts,
+    const LangOptions &LOpts, Module *M)
+    : TheImpl(new Impl(Diags, HeaderOpts, CGOpts, TOpts, LOpts, M)) {}
+
+EarlyFunctionPassRunner::~EarlyFunctionPassRunner() {}
+
+void EarlyFunctionPassRunner::run(Function &F) {
+  PrettyStackTraceString CrashInfo("Per-function optimization");
+  TheImpl->Passes.run(F);
+}
+
+void EarlyFunctionPassRunner::finish() { TheImpl->Passes.doFinalization(); }
+
 static const char* getSectionNameForBitcode(const Triple &T) {
   switch (T.getObjectFormat()) {
   case Triple::MachO:
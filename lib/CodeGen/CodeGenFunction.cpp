@@ -411,6 +411,8 @@ void CodeGenFunction::FinishFunction(SourceLocation EndLoc) {
     I->first->replaceAllUsesWith(I->second);
     I->first->eraseFromParent();
   }
+
+  CGM.noteCompletedFunction(CurFn);
 }
 
 /// ShouldInstrumentFunction - Return true if the current function should be
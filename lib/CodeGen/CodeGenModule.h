@@ -499,6 +499,11 @@ private:
   /// MDNodes.
   llvm::DenseMap<QualType, llvm::Metadata *> MetadataIdMap;
 
+  /// The functions whose IR has been completed since the last call to
+  /// takeCompletedFunctions(), if trackCompletedFunctions() has been called.
+  std::vector<llvm::WeakTrackingVH> CompletedFunctions;
+  bool TrackCompletedFunctions = false;
+
 public:
   CodeGenModule(ASTContext &C, const HeaderSearchOptions &headersearchopts,
                 const PreprocessorOptions &ppopts,
@@ -513,6 +518,23 @@ public:
   /// Finalize LLVM code generation.
   void Release();
 
+  /// Start recording the functions whose IR is completed, for
+  /// -fpipelined-codegen.
+  void trackCompletedFunctions() { TrackCompletedFunctions = true; }
+
+  /// Note that CodeGenFunction has finished emitting the IR of \p F.
+  void noteCompletedFunction(llvm::Function *F) {
+    if (TrackCompletedFunctions)
+      CompletedFunctions.emplace_back(F);
+  }
+
+  /// Take the functions whose IR has been completed since the last call.
+  std::vector<llvm::WeakTrackingVH> takeCompletedFunctions() {
+    std::vector<llvm::WeakTrackingVH> Result;
+    Result.swap(CompletedFunctions);
+    return Result;
+  }
+
   /// Return a reference to the configured Objective-C runtime.
   CGObjCRuntime &getObjCRuntime() {
     if (!ObjCRuntime) createObjCRuntime();
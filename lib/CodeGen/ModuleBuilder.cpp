@@ -15,21 +15,133 @@
 #include "CGDebugInfo.h"
 #include "CodeGenModule.h"
 #include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclCXX.h"
 #include "clang/AST/DeclObjC.h"
 #include "clang/AST/Expr.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/TargetInfo.h"
+#include "clang/CodeGen/BackendUtil.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/ValueMap.h"
+#include "llvm/Support/Threading.h"
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 using namespace clang;
 using namespace CodeGen;
 
 namespace {
+  /// Runs the early LLVM function passes on the functions that CodeGen
+  /// completes on a thread of its own, while the parser goes on with the next
+  /// declarations (-fpipelined-codegen).
+  ///
+  /// The AST is not thread-safe, so IR is still emitted on the parsing
+  /// thread, by the ASTConsumer callbacks. Each callback waits for the passes
+  /// on the functions completed by the previous callbacks to finish before it
+  /// touches the module, and then hands the functions it completed over to
+  /// the thread. The passes therefore only overlap with parsing and semantic
+  /// analysis, and they see the same IR on every run.
+  class FunctionPassPipeline {
+    /// Functions keep their entry when they are replaced: it is the body the
+    /// passes ran on that matters.
+    struct DoneMapConfig : llvm::ValueMapConfig<llvm::Function *> {
+      enum { FollowRAUW = false };
+    };
+
+    std::unique_ptr<EarlyFunctionPassRunner> Passes;
+
+    std::mutex Mutex;
+    std::condition_variable Ready, Idle;
+    std::unique_lock<std::mutex> ModuleLock;
+    /// The functions for the thread to run the passes on.
+    std::vector<llvm::WeakTrackingVH> Queue;
+    /// The functions the passes have run on.
+    llvm::ValueMap<llvm::Function *, bool, DoneMapConfig> Done;
+    bool Stopping = false;
+    std::thread Worker;
+
+    void runPasses(llvm::Value *V) {
+      auto *F = dyn_cast_or_null<llvm::Function>(V);
+      if (F && !F->isDeclaration() && Done.insert({F, true}).second)
+        Passes->run(*F);
+    }
+
+    void work() {
+      std::unique_lock<std::mutex> Lock(Mutex);
+      while (true) {
+        Ready.wait(Lock, [&] { return Stopping || !Queue.empty(); });
+        for (llvm::WeakTrackingVH &V : Queue)
+          runPasses(V);
+        Queue.clear();
+        Idle.notify_all();
+        if (Stopping)
+          return;
+      }
+    }
+
+  public:
+    explicit FunctionPassPipeline(
+        std::unique_ptr<EarlyFunctionPassRunner> Passes)
+        : Passes(std::move(Passes)), ModuleLock(Mutex, std::defer_lock) {
+      // Without threads, the passes run at the end of each callback instead.
+      if (llvm::llvm_is_multithreaded())
+        Worker = std::thread([this] { work(); });
+    }
+
+    ~FunctionPassPipeline() { stop(); }
+
+    /// Wait for the thread to be done with the module, and keep it away
+    /// until release().
+    void acquire() {
+      ModuleLock.lock();
+      Idle.wait(ModuleLock, [&] { return Queue.empty(); });
+    }
+
+    /// Hand the functions that have been completed since acquire() over to
+    /// the thread.
+    void release(std::vector<llvm::WeakTrackingVH> Completed) {
+      if (!Worker.joinable()) {
+        for (llvm::WeakTrackingVH &V : Completed)
+          runPasses(V);
+        ModuleLock.unlock();
+        return;
+      }
+      Queue = std::move(Completed);
+      ModuleLock.unlock();
+      Ready.notify_one();
+    }
+
+    /// Wait for the thread to finish the functions it has been handed, and
+    /// stop it.
+    void stop() {
+      if (!Worker.joinable())
+        return;
+      {
+        std::lock_guard<std::mutex> Guard(Mutex);
+        Stopping = true;
+      }
+      Ready.notify_one();
+      Worker.join();
+    }
+
+    /// Run the passes on the functions of \p M that they have not run on
+    /// yet, such as those emitted at the end of the translation unit, and
+    /// finish them.
+    void finish(llvm::Module &M) {
+      stop();
+      for (llvm::Function &F : M)
+        runPasses(&F);
+      Passes->finish();
+      Done.clear();
+    }
+  };
+
   class CodeGeneratorImpl : public CodeGenerator {
     DiagnosticsEngine &Diags;
     ASTContext *Ctx;
@@ -66,6 +178,24 @@ namespace {
   private:
     SmallVector<CXXMethodDecl *, 8> DeferredInlineMethodDefinitions;
 
+    std::unique_ptr<FunctionPassPipeline> Pipeline;
+    unsigned AccessingModule = 0;
+
+    /// Use this in each entry point that may touch the module, to keep the
+    /// -fpipelined-codegen thread away from it, and to hand the functions it
+    /// completes over to the thread on scope exit.
+    struct ModuleAccessRAII {
+      CodeGeneratorImpl &Self;
+      ModuleAccessRAII(CodeGeneratorImpl &Self) : Self(Self) {
+        if (Self.Pipeline && Self.AccessingModule++ == 0)
+          Self.Pipeline->acquire();
+      }
+      ~ModuleAccessRAII() {
+        if (Self.Pipeline && --Self.AccessingModule == 0)
+          Self.Pipeline->release(Self.Builder->takeCompletedFunctions());
+      }
+    };
+
   public:
     CodeGeneratorImpl(DiagnosticsEngine &diags, llvm::StringRef ModuleName,
                       const HeaderSearchOptions &HSO,
@@ -97,10 +227,12 @@ namespace {
     }
 
     llvm::Module *ReleaseModule() {
+      Pipeline.reset();
       return M.release();
     }
 
     const Decl *GetDeclForMangledName(StringRef MangledName) {
+      ModuleAccessRAII AccessingModule(*this);
       GlobalDecl Result;
       if (!Builder->lookupRepresentativeDecl(MangledName, Result))
         return nullptr;
@@ -116,12 +248,14 @@ namespace {
     }
 
     llvm::Constant *GetAddrOfGlobal(GlobalDecl global, bool isForDefinition) {
+      ModuleAccessRAII AccessingModule(*this);
       return Builder->GetAddrOfGlobal(global, ForDefinition_t(isForDefinition));
     }
 
     llvm::Module *StartModule(llvm::StringRef ModuleName,
                               llvm::LLVMContext &C) {
       assert(!M && "Replacing existing Module?");
+      Pipeline.reset();
       M.reset(new llvm::Module(ModuleName, C));
       Initialize(*Ctx);
       return M.get();
@@ -140,12 +274,22 @@ namespace {
         Builder->AddDependentLib(Lib);
       for (auto &&Opt : CodeGenOpts.LinkerOptions)
         Builder->AppendLinkerOptions(Opt);
+
+      if (ShouldPipelineFunctionPasses(CodeGenOpts, Context.getLangOpts())) {
+        Pipeline = llvm::make_unique<FunctionPassPipeline>(
+            llvm::make_unique<EarlyFunctionPassRunner>(
+                Diags, HeaderSearchOpts, CodeGenOpts,
+                Context.getTargetInfo().getTargetOpts(), Context.getLangOpts(),
+                M.get()));
+        Builder->trackCompletedFunctions();
+      }
     }
 
     void HandleCXXStaticMemberVarInstantiation(VarDecl *VD) override {
       if (Diags.hasErrorOccurred())
         return;
 
+      ModuleAccessRAII AccessingModule(*this);
       Builder->HandleCXXStaticMemberVarInstantiation(VD);
     }
 
@@ -153,15 +297,51 @@ namespace {
       if (Diags.hasErrorOccurred())
         return true;
 
-      HandlingTopLevelDeclRAII HandlingDecl(*this);
+      ModuleAccessRAII AccessingModule(*this);
+      {
+        HandlingTopLevelDeclRAII HandlingDecl(*this);
 
-      // Make sure to emit all elements of a Decl.
-      for (DeclGroupRef::iterator I = DG.begin(), E = DG.end(); I != E; ++I)
-        Builder->EmitTopLevelDecl(*I);
+        // Make sure to emit all elements of a Decl.
+        for (DeclGroupRef::iterator I = DG.begin(), E = DG.end(); I != E; ++I)
+          Builder->EmitTopLevelDecl(*I);
+      }
+
+      if (CodeGenOpts.DiscardFunctionBodies && !Ctx->getLangOpts().ObjC1 &&
+          !Ctx->getLangOpts().OpenMP && !Ctx->getLangOpts().CUDA)
+        for (Decl *D : DG)
+          DiscardEmittedFunctionBodies(D);
 
       return true;
     }
 
+    /// Release the bodies of the functions defined by \p D that have been
+    /// emitted and that nothing will need again.
+    void DiscardEmittedFunctionBodies(Decl *D) {
+      if (isa<NamespaceDecl>(D) || isa<LinkageSpecDecl>(D) ||
+          isa<ExportDecl>(D)) {
+        for (Decl *Member : cast<DeclContext>(D)->decls())
+          DiscardEmittedFunctionBodies(Member);
+        return;
+      }
+
+      // Inline functions and templates may be emitted again, or instantiated,
+      // later; constexpr functions may be evaluated. Constructors and
+      // destructors have variants that may be emitted later.
+      auto *FD = dyn_cast<FunctionDecl>(D);
+      if (!FD || !FD->doesThisDeclarationHaveABody() || FD->isInvalidDecl() ||
+          FD->isInlined() || FD->isConstexpr() || FD->isDependentContext() ||
+          FD->getTemplatedKind() != FunctionDecl::TK_NonTemplate ||
+          isa<CXXConstructorDecl>(FD) || isa<CXXDestructorDecl>(FD))
+        return;
+
+      llvm::GlobalValue *GV =
+          Builder->GetGlobalValue(Builder->getMangledName(FD));
+      if (!GV || GV->isDeclaration())
+        return;
+
+      Ctx->discardFunctionBody(FD);
+    }
+
     void EmitDeferredDecls() {
       if (DeferredInlineMethodDefinitions.empty())
         return;
@@ -181,6 +361,8 @@ namespace {
 
       assert(D->doesThisDeclarationHaveABody());
 
+      ModuleAccessRAII AccessingModule(*this);
+
       // Handle friend functions.
       if (D->isInIdentifierNamespace(Decl::IDNS_OrdinaryFriend)) {
         if (Ctx->getTargetInfo().getCXXABI().isMicrosoft()
@@ -217,6 +399,8 @@ namespace {
       if (Diags.hasErrorOccurred())
         return;
 
+      ModuleAccessRAII AccessingModule(*this);
+
       // Don't allow re-entrant calls to CodeGen triggered by PCH
       // deserialization to emit deferred decls.
       HandlingTopLevelDeclRAII HandlingDecl(*this, /*EmitDeferred=*/false);
@@ -250,6 +434,8 @@ namespace {
       if (Diags.hasErrorOccurred())
         return;
 
+      ModuleAccessRAII AccessingModule(*this);
+
       // Don't allow re-entrant calls to CodeGen triggered by PCH
       // deserialization to emit deferred decls.
       HandlingTopLevelDeclRAII HandlingDecl(*this, /*EmitDeferred=*/false);
@@ -260,24 +446,38 @@ namespace {
     }
 
     void HandleTranslationUnit(ASTContext &Ctx) override {
+      // The passes on the functions emitted from here on run in finish().
+      if (Pipeline)
+        Pipeline->stop();
+
       // Release the Builder when there is no error.
       if (!Diags.hasErrorOccurred() && Builder)
         Builder->Release();
 
+      if (Pipeline)
+        Builder->takeCompletedFunctions();
+
       // If there are errors before or when releasing the Builder, reset
       // the module to stop here before invoking the backend.
       if (Diags.hasErrorOccurred()) {
         if (Builder)
           Builder->clear();
+        Pipeline.reset();
         M.reset();
         return;
       }
+
+      if (Pipeline) {
+        Pipeline->finish(*M);
+        Pipeline.reset();
+      }
     }
 
     void AssignInheritanceModel(CXXRecordDecl *RD) override {
       if (Diags.hasErrorOccurred())
         return;
 
+      ModuleAccessRAII AccessingModule(*this);
       Builder->RefreshTypeCacheForClass(RD);
     }
 
@@ -285,6 +485,7 @@ namespace {
       if (Diags.hasErrorOccurred())
         return;
 
+      ModuleAccessRAII AccessingModule(*this);
       Builder->EmitTentativeDefinition(D);
     }
 
@@ -292,6 +493,7 @@ namespace {
       if (Diags.hasErrorOccurred())
         return;
 
+      ModuleAccessRAII AccessingModule(*this);
       Builder->EmitVTable(RD);
     }
   };
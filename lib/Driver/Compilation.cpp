@@ -14,9 +14,15 @@
 #include "clang/Driver/Options.h"
 #include "clang/Driver/ToolChain.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
+#include <condition_variable>
+#include <mutex>
 
 using namespace clang::driver;
 using namespace clang;
@@ -27,7 +33,8 @@ Compilation::Compilation(const Driver &D, const ToolChain &_DefaultToolChain,
                          bool ContainsError)
     : TheDriver(D), DefaultToolChain(_DefaultToolChain), ActiveOffloadMask(0u),
       Args(_Args), TranslatedArgs(_TranslatedArgs), Redirects(nullptr),
-      ForDiagnostics(false), ContainsError(ContainsError) {
+      ForDiagnostics(false), ContainsError(ContainsError),
+      NumParallelJobs(1) {
   // The offloading host toolchain is the default tool chain.
   OrderedOffloadingToolchains.insert(
       std::make_pair(Action::OFK_Host, &DefaultToolChain));
@@ -131,8 +138,7 @@ bool Compilation::CleanupFileMap(const ArgStringMap &Files,
   return Success;
 }
 
-int Compilation::ExecuteCommand(const Command &C,
-                                const Command *&FailingCommand) const {
+bool Compilation::LogCommand(const Command &C) const {
   if ((getDriver().CCPrintOptions ||
        getArgs().hasArg(options::OPT_v)) && !getDriver().CCGenDiagnostics) {
     raw_ostream *OS = &llvm::errs();
@@ -147,9 +153,8 @@ int Compilation::ExecuteCommand(const Command &C,
       if (EC) {
         getDriver().Diag(clang::diag::err_drv_cc_print_options_failure)
             << EC.message();
-        FailingCommand = &C;
         delete OS;
-        return 1;
+        return false;
       }
     }
 
@@ -161,6 +166,15 @@ int Compilation::ExecuteCommand(const Command &C,
     if (OS != &llvm::errs())
       delete OS;
   }
+  return true;
+}
+
+int Compilation::ExecuteCommand(const Command &C,
+                                const Command *&FailingCommand) const {
+  if (!LogCommand(C)) {
+    FailingCommand = &C;
+    return 1;
+  }
 
   std::string Error;
   bool ExecutionFailed;
@@ -179,6 +193,13 @@ int Compilation::ExecuteCommand(const Command &C,
 void Compilation::ExecuteJobs(
     const JobList &Jobs,
     SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const {
+  // Compilations for diagnostics and redirected compilations keep their
+  // output where the caller wants it, so they always run serially.
+  if (NumParallelJobs > 1 && Jobs.size() > 1 && !ForDiagnostics &&
+      !Redirects && llvm::llvm_is_multithreaded() &&
+      ExecuteJobsInParallel(Jobs, FailingCommands))
+    return;
+
   for (const auto &Job : Jobs) {
     const Command *FailingCommand = nullptr;
     if (int Res = ExecuteCommand(Job, FailingCommand)) {
@@ -190,6 +211,162 @@ void Compilation::ExecuteJobs(
   }
 }
 
+/// Whether \p Consumer may read a file that \p Producer writes.
+///
+/// The driver records the outputs of the action that created each command.
+/// \p Consumer depends on \p Producer if one of those files is one of its
+/// inputs or one of its arguments, such as the PCH of an -include-pch.
+/// Commands created for the same action, which may pass temporary files to
+/// each other, always run one after the other.
+static bool dependsOn(const Command &Consumer, const Command &Producer) {
+  if (&Consumer.getSource() == &Producer.getSource())
+    return true;
+  for (StringRef Output : Producer.getOutputFilenames()) {
+    auto IsOutput = [&](const char *File) { return Output == File; };
+    if (llvm::any_of(Consumer.getInputFilenames(), IsOutput) ||
+        llvm::any_of(Consumer.getArguments(), IsOutput))
+      return true;
+  }
+  return false;
+}
+
+namespace {
+/// The state of a job run by Compilation::ExecuteJobsInParallel.
+struct ParallelJob {
+  const Command *Cmd = nullptr;
+
+  /// The earlier jobs that have to succeed before this one can start.
+  SmallVector<unsigned, 4> Dependencies;
+
+  /// The files capturing the standard output and error of the job.
+  SmallString<128> OutputFile, ErrorFile;
+  StringRef OutputRedirect, ErrorRedirect;
+  const StringRef *Redirects[3] = {nullptr, nullptr, nullptr};
+
+  bool Started = false;
+  bool Finished = false;
+  int Res = 0;
+  std::string Error;
+};
+} // end anonymous namespace
+
+bool Compilation::ExecuteJobsInParallel(
+    const JobList &Jobs,
+    SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const {
+  std::vector<ParallelJob> States(Jobs.size());
+  auto RemoveCaptureFiles = [&] {
+    for (ParallelJob &J : States) {
+      if (!J.OutputFile.empty())
+        llvm::sys::fs::remove(J.OutputFile);
+      if (!J.ErrorFile.empty())
+        llvm::sys::fs::remove(J.ErrorFile);
+    }
+  };
+
+  unsigned Index = 0;
+  for (const Command &Job : Jobs) {
+    ParallelJob &J = States[Index];
+    J.Cmd = &Job;
+    for (unsigned Prev = 0; Prev != Index; ++Prev)
+      if (dependsOn(Job, *States[Prev].Cmd))
+        J.Dependencies.push_back(Prev);
+
+    if (llvm::sys::fs::createTemporaryFile("clang-job", "out", J.OutputFile) ||
+        llvm::sys::fs::createTemporaryFile("clang-job", "err", J.ErrorFile)) {
+      RemoveCaptureFiles();
+      return false;
+    }
+    J.OutputRedirect = J.OutputFile;
+    J.ErrorRedirect = J.ErrorFile;
+    J.Redirects[1] = &J.OutputRedirect;
+    J.Redirects[2] = &J.ErrorRedirect;
+    ++Index;
+  }
+
+  // The first failing job. Only the jobs before it may still be started.
+  unsigned StopIndex = States.size();
+  unsigned NextToReplay = 0;
+  unsigned NumRunning = 0, NumFinished = 0, NumSeen = 0;
+  std::mutex Mutex;
+  std::condition_variable JobFinished;
+  llvm::ThreadPool Pool(NumParallelJobs);
+
+  // Replay the output of a finished job, exactly as it would have appeared
+  // had the job run in the foreground.
+  auto Replay = [&](ParallelJob &J) {
+    if (!LogCommand(*J.Cmd) && !J.Res)
+      J.Res = 1;
+    if (auto Buf = llvm::MemoryBuffer::getFile(J.OutputFile))
+      llvm::outs() << (*Buf)->getBuffer();
+    llvm::outs().flush();
+    if (auto Buf = llvm::MemoryBuffer::getFile(J.ErrorFile))
+      llvm::errs() << (*Buf)->getBuffer();
+    if (!J.Error.empty())
+      getDriver().Diag(clang::diag::err_drv_command_failure) << J.Error;
+  };
+
+  std::unique_lock<std::mutex> Lock(Mutex);
+  while (true) {
+    // Note the first failure as soon as possible so that no job after it
+    // gets started.
+    for (unsigned I = 0; I < StopIndex; ++I)
+      if (States[I].Finished && States[I].Res)
+        StopIndex = I;
+
+    while (NextToReplay < States.size() && NextToReplay <= StopIndex &&
+           States[NextToReplay].Finished) {
+      ParallelJob &J = States[NextToReplay];
+      Replay(J);
+      if (J.Res) {
+        FailingCommands.push_back(std::make_pair(J.Res, J.Cmd));
+        StopIndex = NextToReplay;
+      }
+      ++NextToReplay;
+    }
+
+    for (unsigned I = 0; I < StopIndex && NumRunning < NumParallelJobs; ++I) {
+      ParallelJob &J = States[I];
+      if (J.Started || llvm::any_of(J.Dependencies, [&](unsigned D) {
+            return !States[D].Finished || States[D].Res;
+          }))
+        continue;
+
+      J.Started = true;
+      ++NumRunning;
+      Pool.async([&, I] {
+        ParallelJob &J = States[I];
+        std::string Error;
+        bool ExecutionFailed;
+        int Res = J.Cmd->Execute(J.Redirects, &Error, &ExecutionFailed);
+
+        std::lock_guard<std::mutex> Guard(Mutex);
+        J.Res = ExecutionFailed ? 1 : Res;
+        J.Error = std::move(Error);
+        J.Finished = true;
+        --NumRunning;
+        ++NumFinished;
+        JobFinished.notify_one();
+      });
+    }
+
+    if (!NumRunning)
+      break;
+    JobFinished.wait(Lock, [&] { return NumFinished != NumSeen; });
+    NumSeen = NumFinished;
+  }
+  Lock.unlock();
+  Pool.wait();
+
+  // Jobs after the first failure would not have run serially; drop what they
+  // produced.
+  for (unsigned I = StopIndex + 1; I < States.size(); ++I)
+    if (States[I].Started)
+      CleanupFileMap(ResultFiles, cast<JobAction>(&States[I].Cmd->getSource()));
+
+  RemoveCaptureFiles();
+  return true;
+}
+
 void Compilation::initCompilationForDiagnostics() {
   ForDiagnostics = true;
 
@@ -721,6 +721,15 @@ Compilation *Driver::BuildCompilation(ArrayRef<const char *> ArgList) {
   Compilation *C = new Compilation(*this, TC, UArgs.release(), TranslatedArgs,
                                    ContainsError);
 
+  if (Arg *A = TranslatedArgs->getLastArg(options::OPT_fparallel_jobs_EQ)) {
+    unsigned NumJobs;
+    if (StringRef(A->getValue()).getAsInteger(10, NumJobs) || !NumJobs)
+      Diag(diag::err_drv_invalid_int_value)
+          << A->getAsString(*TranslatedArgs) << A->getValue();
+    else
+      C->setNumParallelJobs(NumJobs);
+  }
+
   if (!HandleImmediateArgs(*C))
     return C;
 
@@ -1052,6 +1061,12 @@ void Driver::setUpResponseFiles(Compilation &C, Command &Cmd) {
 int Driver::ExecuteCompilation(
     Compilation &C,
     SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) {
+  // The integrated cc1 tool does not reset all of its global state (e.g.
+  // -mllvm options) between runs, so only a lone job runs in process.
+  if (C.getJobs().size() > 1)
+    for (auto &Job : C.getJobs())
+      Job.setInProcess(false);
+
   // Just print if -### was present.
   if (C.getArgs().hasArg(options::OPT__HASH_HASH_HASH)) {
     C.getJobs().Print(llvm::errs(), "\n", true);
@@ -3463,6 +3478,7 @@ InputInfo Driver::BuildJobsForActionNoCache(
       llvm::errs() << "] \n";
     }
   } else {
+    unsigned NumJobs = C.getJobs().size();
     if (UnbundlingResults.empty())
       T->ConstructJob(
           C, *JA, Result, InputInfos,
@@ -3473,6 +3489,20 @@ InputInfo Driver::BuildJobsForActionNoCache(
           C, *JA, UnbundlingResults, InputInfos,
           C.getArgsForToolChain(TC, BoundArch, JA->getOffloadingDeviceKind()),
           LinkingOutput);
+
+    // Record what the new commands write, so that -fparallel-jobs knows which
+    // later commands have to wait for them.
+    for (auto I = C.getJobs().begin() + NumJobs, E = C.getJobs().end(); I != E;
+         ++I) {
+      if (UnbundlingResults.empty()) {
+        if (Result.isFilename())
+          I->addOutputFilename(Result.getFilename());
+        continue;
+      }
+      for (const InputInfo &Output : UnbundlingResults)
+        if (Output.isFilename())
+          I->addOutputFilename(Output.getFilename());
+    }
   }
   return Result;
 }
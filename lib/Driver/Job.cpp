@@ -19,8 +19,10 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
@@ -356,6 +358,73 @@ int Command::Execute(const StringRef **Redirects, std::string *ErrMsg,
                                    /*memoryLimit*/ 0, ErrMsg, ExecutionFailed);
 }
 
+CC1Command::CC1Command(const Action &Source, const Tool &Creator,
+                       const char *Executable,
+                       const ArgStringList &Arguments,
+                       ArrayRef<InputInfo> Inputs)
+    : Command(Source, Creator, Executable, Arguments, Inputs) {
+  InProcess = true;
+}
+
+void CC1Command::Print(raw_ostream &OS, const char *Terminator, bool Quote,
+                       CrashReportInfo *CrashInfo) const {
+  Command::Print(OS, "", Quote, CrashInfo);
+  // Crash reproducer scripts must stay runnable.
+  if (InProcess && !CrashInfo)
+    OS << " (in-process)";
+  OS << Terminator;
+}
+
+/// The recovery context of the job that runs in process, and the status its
+/// Execute returns if the job is abandoned.
+static llvm::CrashRecoveryContext *InProcessCRC = nullptr;
+static int InProcessExitStatus = -2;
+
+void CC1Command::exitInProcessJob(int ExitStatus) {
+  // A fatal error on another thread, such as one building a module, cannot
+  // unwind the job.
+  if (!InProcessCRC || InProcessCRC != llvm::CrashRecoveryContext::GetCurrent())
+    return;
+  InProcessExitStatus = ExitStatus;
+  InProcessCRC->HandleCrash();
+}
+
+int CC1Command::Execute(const StringRef **Redirects, std::string *ErrMsg,
+                        bool *ExecutionFailed) const {
+  // Redirected output needs a process of its own.
+  const Driver &D = getCreator().getToolChain().getDriver();
+  if (!InProcess || !D.CC1Main || Redirects)
+    return Command::Execute(Redirects, ErrMsg, ExecutionFailed);
+
+  if (ExecutionFailed)
+    *ExecutionFailed = false;
+
+  // There is no command line length limit in process, so the arguments are
+  // passed directly even if a response file was set up.
+  SmallVector<const char *, 128> Argv;
+  Argv.push_back(getExecutable());
+  Argv.append(getArguments().begin(), getArguments().end());
+
+  llvm::CrashRecoveryContext::Enable();
+  llvm::CrashRecoveryContext CRC;
+  const void *PrettyState = llvm::SavePrettyStackState();
+  InProcessCRC = &CRC;
+  InProcessExitStatus = -2;
+
+  int Res = 0;
+  bool Completed = CRC.RunSafely([&] { Res = D.CC1Main(Argv); });
+  InProcessCRC = nullptr;
+  llvm::CrashRecoveryContext::Disable();
+
+  if (!Completed) {
+    // Report a crash or a fatal error the way a failed child process reports
+    // it, so that the driver still cleans up and generates crash diagnostics.
+    llvm::RestorePrettyStackState(PrettyState);
+    return InProcessExitStatus;
+  }
+  return Res;
+}
+
 FallbackCommand::FallbackCommand(const Action &Source_, const Tool &Creator_,
                                  const char *Executable_,
                                  const ArgStringList &Arguments_,
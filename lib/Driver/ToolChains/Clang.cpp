@@ -3208,6 +3208,14 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   CmdArgs.push_back("-discard-value-names");
 #endif
 
+  if (Args.hasFlag(options::OPT_fdiscard_function_bodies,
+                   options::OPT_fno_discard_function_bodies, false))
+    CmdArgs.push_back("-fdiscard-function-bodies");
+
+  if (Args.hasFlag(options::OPT_fpipelined_codegen,
+                   options::OPT_fno_pipelined_codegen, false))
+    CmdArgs.push_back("-fpipelined-codegen");
+
   // Set the main file name, so that debug info works even with
   // -save-temps.
   CmdArgs.push_back("-main-file-name");
@@ -3888,6 +3896,7 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   Args.AddLastArg(CmdArgs, options::OPT_fdiagnostics_print_source_range_info);
   Args.AddLastArg(CmdArgs, options::OPT_fdiagnostics_parseable_fixits);
   Args.AddLastArg(CmdArgs, options::OPT_ftime_report);
+  Args.AddLastArg(CmdArgs, options::OPT_ftemplate_profile_EQ);
   Args.AddLastArg(CmdArgs, options::OPT_ftrapv);
 
   if (Arg *A = Args.getLastArg(options::OPT_ftrapv_handler_EQ)) {
@@ -4121,6 +4130,10 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
                    options::OPT_fno_delayed_template_parsing, IsWindowsMSVC))
     CmdArgs.push_back("-fdelayed-template-parsing");
 
+  if (Args.hasFlag(options::OPT_fpch_instantiate_templates,
+                   options::OPT_fno_pch_instantiate_templates, false))
+    CmdArgs.push_back("-fpch-instantiate-templates");
+
   // -fgnu-keywords default varies depending on language; only pass if
   // specified.
   if (Arg *A = Args.getLastArg(options::OPT_fgnu_keywords,
@@ -4485,11 +4498,45 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
       isa<CompileJobAction>(JA))
     CmdArgs.push_back("-disable-llvm-passes");
 
+  // With -fparallel-codegen=N, the backend writes the object file in N
+  // partitions, "<file>" and "<file>.1" to "<file>.N-1", which a partial link
+  // then combines into the output.
+  SmallVector<InputInfo, 8> CodeGenPartitions;
+  if (Arg *A = Args.getLastArg(options::OPT_fparallel_codegen_EQ)) {
+    StringRef Value = A->getValue();
+    unsigned Jobs;
+    if (Value.getAsInteger(10, Jobs) || !Jobs)
+      D.Diag(diag::err_drv_invalid_int_value) << A->getAsString(Args) << Value;
+    else if (Jobs > 1 && Output.getType() == types::TY_Object &&
+             Output.isFilename()) {
+      if (!RawTriple.isOSBinFormatELF() && !RawTriple.isOSBinFormatMachO()) {
+        D.Diag(diag::err_drv_unsupported_opt_for_target)
+            << A->getAsString(Args) << TripleStr;
+      } else {
+        CmdArgs.push_back(Args.MakeArgString("-fparallel-codegen=" +
+                                             Twine(Jobs)));
+        std::string TmpName = D.GetTemporaryPath(
+            llvm::sys::path::stem(Input.getBaseInput()),
+            types::getTypeTempSuffix(types::TY_Object));
+        for (unsigned I = 0; I != Jobs; ++I) {
+          std::string Name = TmpName;
+          if (I)
+            Name += "." + llvm::utostr(I);
+          const char *Partition = C.addTempFile(Args.MakeArgString(Name));
+          CodeGenPartitions.push_back(
+              InputInfo(types::TY_Object, Partition, Output.getBaseInput()));
+        }
+      }
+    }
+  }
+
   if (Output.getType() == types::TY_Dependencies) {
     // Handled with other dependency code.
   } else if (Output.isFilename()) {
     CmdArgs.push_back("-o");
-    CmdArgs.push_back(Output.getFilename());
+    CmdArgs.push_back(CodeGenPartitions.empty()
+                          ? Output.getFilename()
+                          : CodeGenPartitions.front().getFilename());
   } else {
     assert(Output.isNothing() && "Invalid output.");
   }
@@ -4594,10 +4641,28 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     // fails, so that the main compilation's fallback to cl.exe runs.
     C.addCommand(llvm::make_unique<ForceSuccessCommand>(JA, *this, Exec,
                                                         CmdArgs, Inputs));
+  } else if (D.CC1Main && !D.CCGenDiagnostics &&
+             Args.hasFlag(options::OPT_fintegrated_cc1,
+                          options::OPT_fno_integrated_cc1, false)) {
+    // Run cc1 in the driver process rather than re-executing the driver.
+    C.addCommand(
+        llvm::make_unique<CC1Command>(JA, *this, Exec, CmdArgs, Inputs));
   } else {
     C.addCommand(llvm::make_unique<Command>(JA, *this, Exec, CmdArgs, Inputs));
   }
 
+  if (!CodeGenPartitions.empty()) {
+    ArgStringList LinkArgs;
+    LinkArgs.push_back("-r");
+    for (const InputInfo &Partition : CodeGenPartitions)
+      LinkArgs.push_back(Partition.getFilename());
+    LinkArgs.push_back("-o");
+    LinkArgs.push_back(Output.getFilename());
+    C.addCommand(llvm::make_unique<Command>(
+        JA, *this, Args.MakeArgString(getToolChain().GetLinkerPath()),
+        LinkArgs, CodeGenPartitions));
+  }
+
   // Handle the debug info splitting at object creation time if we're
   // creating an object.
   // TODO: Currently only works on linux with newer objcopy.
@@ -615,6 +615,10 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
       (Args.hasArg(OPT_mdisable_fp_elim) || Args.hasArg(OPT_pg));
   Opts.DisableFree = Args.hasArg(OPT_disable_free);
   Opts.DiscardValueNames = Args.hasArg(OPT_discard_value_names);
+  Opts.DiscardFunctionBodies = Args.hasArg(OPT_fdiscard_function_bodies);
+  // There is no parsing to overlap with when the input is IR.
+  Opts.PipelinedCodeGen = Args.hasArg(OPT_fpipelined_codegen) &&
+                          IK.getLanguage() != InputKind::LLVM_IR;
   Opts.DisableTailCalls = Args.hasArg(OPT_mdisable_tail_calls);
   Opts.FloatABI = Args.getLastArgValue(OPT_mfloat_abi);
   Opts.LessPreciseFPMAD = Args.hasArg(OPT_cl_mad_enable) ||
@@ -699,6 +703,27 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
   }
   Opts.ThinLinkBitcodeFile = Args.getLastArgValue(OPT_fthin_link_bitcode_EQ);
 
+  if (Arg *A = Args.getLastArg(OPT_fparallel_codegen_EQ)) {
+    StringRef Value = A->getValue();
+    unsigned Jobs;
+    if (Value.getAsInteger(10, Jobs) || !Jobs) {
+      Diags.Report(diag::err_drv_invalid_int_value)
+          << A->getAsString(Args) << Value;
+      Success = false;
+    } else if (Jobs > 1) {
+      // The other partitions are written next to the output file.
+      StringRef OutputFile = Args.getLastArgValue(OPT_o);
+      if (OutputFile.empty() || OutputFile == "-") {
+        Diags.Report(diag::err_drv_argument_only_allowed_with)
+            << A->getAsString(Args) << "-o <file>";
+        Success = false;
+      } else {
+        Opts.ParallelCodeGenJobs = Jobs;
+        Opts.ParallelCodeGenOutputFile = OutputFile;
+      }
+    }
+  }
+
   Opts.MSVolatile = Args.hasArg(OPT_fms_volatile);
 
   Opts.VectorizeLoop = Args.hasArg(OPT_vectorize_loops);
@@ -1340,6 +1365,7 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
   Opts.ASTDumpAll = Args.hasArg(OPT_ast_dump_all);
   Opts.ASTDumpFilter = Args.getLastArgValue(OPT_ast_dump_filter);
   Opts.ASTDumpLookups = Args.hasArg(OPT_ast_dump_lookups);
+  Opts.SkipHeaderFunctionBodies = Args.hasArg(OPT_skip_header_function_bodies);
   Opts.UseGlobalModuleIndex = !Args.hasArg(OPT_fno_modules_global_index);
   Opts.GenerateGlobalModuleIndex = Opts.UseGlobalModuleIndex;
   Opts.ModuleMapFiles = Args.getAllArgValues(OPT_fmodule_map_file);
@@ -1368,6 +1394,7 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
       llvm::Triple::normalize(Args.getLastArgValue(OPT_aux_triple));
   Opts.FindPchSource = Args.getLastArgValue(OPT_find_pch_source_EQ);
   Opts.StatsFile = Args.getLastArgValue(OPT_stats_file);
+  Opts.TemplateProfileFile = Args.getLastArgValue(OPT_ftemplate_profile_EQ);
 
   if (const Arg *A = Args.getLastArg(OPT_arcmt_check,
                                      OPT_arcmt_modify,
@@ -2188,6 +2215,7 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
       getLastArgIntValue(Args, OPT_fconstexpr_steps, 1048576, Diags);
   Opts.BracketDepth = getLastArgIntValue(Args, OPT_fbracket_depth, 256, Diags);
   Opts.DelayedTemplateParsing = Args.hasArg(OPT_fdelayed_template_parsing);
+  Opts.PCHInstantiateTemplates = Args.hasArg(OPT_fpch_instantiate_templates);
   Opts.NumLargeByValueCopy =
       getLastArgIntValue(Args, OPT_Wlarge_by_value_copy_EQ, 0, Diags);
   Opts.MSBitfields = Args.hasArg(OPT_mms_bitfields);
@@ -2469,6 +2497,20 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
   Opts.AllowEditorPlaceholders = Args.hasArg(OPT_fallow_editor_placeholders);
 }
 
+static bool isCodeGenAction(frontend::ActionKind Action) {
+  switch (Action) {
+  case frontend::EmitAssembly:
+  case frontend::EmitBC:
+  case frontend::EmitLLVM:
+  case frontend::EmitLLVMOnly:
+  case frontend::EmitCodeGenOnly:
+  case frontend::EmitObj:
+    return true;
+  default:
+    return false;
+  }
+}
+
 static bool isStrictlyPreprocessorAction(frontend::ActionKind Action) {
   switch (Action) {
   case frontend::ASTDeclList:
@@ -2686,6 +2728,18 @@ bool CompilerInvocation::CreateFromArgs(CompilerInvocation &Res,
   ParseTargetArgs(Res.getTargetOpts(), Args, Diags);
   Success &= ParseCodeGenArgs(Res.getCodeGenOpts(), Args, DashX, Diags,
                               Res.getTargetOpts());
+  // Function bodies can only be released when the code generator is the sole
+  // consumer of the AST: plugins may look at them after they were emitted.
+  if (Res.getCodeGenOpts().DiscardFunctionBodies) {
+    if (const Arg *A = Args.getLastArg(OPT_load, OPT_plugin, OPT_add_plugin)) {
+      Diags.Report(diag::err_drv_argument_not_allowed_with)
+          << "-fdiscard-function-bodies" << A->getAsString(Args);
+      Success = false;
+    }
+    if (!isCodeGenAction(Res.getFrontendOpts().ProgramAction) ||
+        !Res.getFrontendOpts().ASTMergeFiles.empty())
+      Res.getCodeGenOpts().DiscardFunctionBodies = false;
+  }
   ParseHeaderSearchArgs(Res.getHeaderSearchOpts(), Args,
                         Res.getFileSystemOpts().WorkingDir);
   if (DashX.getFormat() == InputKind::Precompiled ||
@@ -23,6 +23,8 @@
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/PreprocessorOptions.h"
 #include "clang/Parse/ParseAST.h"
+#include "clang/Sema/Sema.h"
+#include "clang/Sema/TemplateProfile.h"
 #include "clang/Serialization/ASTDeserializationListener.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
@@ -176,6 +178,14 @@ FrontendAction::CreateWrappedASTConsumer(CompilerInstance &CI,
     if ((ActionType == PluginASTAction::AddBeforeMainAction ||
          ActionType == PluginASTAction::AddAfterMainAction) &&
         P->ParseArgs(CI, CI.getFrontendOpts().PluginArgs[it->getName()])) {
+      // The plugin could look at the function bodies that the code generator
+      // releases.
+      if (CI.getCodeGenOpts().DiscardFunctionBodies) {
+        CI.getDiagnostics().Report(
+            diag::err_fe_discard_function_bodies_with_plugin)
+            << it->getName();
+        return nullptr;
+      }
       std::unique_ptr<ASTConsumer> PluginConsumer = P->CreateASTConsumer(CI, InFile);
       if (ActionType == PluginASTAction::AddBeforeMainAction) {
         Consumers.push_back(std::move(PluginConsumer));
@@ -928,6 +938,18 @@ void FrontendAction::EndSourceFile() {
   // Finalize the action.
   EndSourceFileAction();
 
+  StringRef TemplateProfileFile = CI.getFrontendOpts().TemplateProfileFile;
+  if (!TemplateProfileFile.empty() && CI.hasSema() &&
+      CI.getSema().TemplateProfiler) {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(TemplateProfileFile, EC, llvm::sys::fs::F_Text);
+    if (EC)
+      CI.getDiagnostics().Report(diag::warn_fe_unable_to_open_template_profile)
+          << TemplateProfileFile << EC.message();
+    else
+      CI.getSema().TemplateProfiler->print(OS);
+  }
+
   // Sema references the ast consumer, so reset sema first.
   //
   // FIXME: There is more per-file stuff we could just drop here?
@@ -1001,7 +1023,8 @@ void ASTFrontendAction::ExecuteAction() {
     CI.createSema(getTranslationUnitKind(), CompletionConsumer);
 
   ParseAST(CI.getSema(), CI.getFrontendOpts().ShowStats,
-           CI.getFrontendOpts().SkipFunctionBodies);
+           CI.getFrontendOpts().SkipFunctionBodies,
+           CI.getFrontendOpts().SkipHeaderFunctionBodies);
 }
 
 void PluginASTAction::anchor() { }
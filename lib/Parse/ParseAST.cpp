@@ -110,11 +110,13 @@ void clang::ParseAST(Preprocessor &PP, ASTConsumer *Consumer,
   ParseAST(*S.get(), PrintStats, SkipFunctionBodies);
 }
 
-void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
+void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies,
+                     bool SkipHeaderFunctionBodies) {
   // Collect global stats on Decls/Stmts (until we have a module streamer).
   if (PrintStats) {
     Decl::EnableStatistics();
     Stmt::EnableStatistics();
+    S.getASTContext().enableAllocationStats();
   }
 
   // Also turn on collection of stats inside of the Sema object.
@@ -124,7 +126,8 @@ void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
   ASTConsumer *Consumer = &S.getASTConsumer();
 
   std::unique_ptr<Parser> ParseOP(
-      new Parser(S.getPreprocessor(), S, SkipFunctionBodies));
+      new Parser(S.getPreprocessor(), S, SkipFunctionBodies,
+                 SkipHeaderFunctionBodies));
   Parser &P = *ParseOP.get();
 
   llvm::CrashRecoveryContextCleanupRegistrar<const void, ResetStackCleanup>
@@ -167,4 +170,13 @@ void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
     Stmt::PrintStats();
     Consumer->PrintStats();
   }
+
+  // If function bodies were left to be parsed on demand, hand the parser over
+  // to Sema so that clients can still ask for them once parsing is done.
+  if (SkipHeaderFunctionBodies && !S.LateParsedTemplateMap.empty() &&
+      S.OpaqueParser == &P) {
+    CleanupParser.unregister();
+    S.SetLateParserDeleter(Parser::LateParserDeleterCallback);
+    ParseOP.release();
+  }
 }
@@ -47,12 +47,14 @@ IdentifierInfo *Parser::getSEHExceptKeyword() {
   return Ident__except;
 }
 
-Parser::Parser(Preprocessor &pp, Sema &actions, bool skipFunctionBodies)
+Parser::Parser(Preprocessor &pp, Sema &actions, bool skipFunctionBodies,
+               bool skipHeaderFunctionBodies)
   : PP(pp), Actions(actions), Diags(PP.getDiagnostics()),
     GreaterThanIsOperator(true), ColonIsSacred(false), 
     InMessageExpression(false), TemplateParameterDepth(0),
     ParsingInObjCContainer(false) {
   SkipFunctionBodies = pp.isCodeCompletionEnabled() || skipFunctionBodies;
+  SkipHeaderFunctionBodies = skipHeaderFunctionBodies;
   Tok.startToken();
   Tok.setKind(tok::eof);
   Actions.CurScope = nullptr;
@@ -420,7 +422,13 @@ Parser::~Parser() {
 
   PP.clearCodeCompletionHandler();
 
-  if (getLangOpts().DelayedTemplateParsing &&
+  // Sema must not call back into us once we are gone.
+  if (Actions.OpaqueParser == this) {
+    Actions.SetLateTemplateParser(nullptr, nullptr, nullptr);
+    Actions.SetLateParserDeleter(nullptr);
+  }
+
+  if ((getLangOpts().DelayedTemplateParsing || SkipHeaderFunctionBodies) &&
       !PP.isIncrementalProcessingEnabled() && !TemplateIds.empty()) {
     // If an ASTConsumer parsed delay-parsed templates in their
     // HandleTranslationUnit() method, TemplateIds created there were not
@@ -525,6 +533,10 @@ void Parser::LateTemplateParserCleanupCallback(void *P) {
   DestroyTemplateIdAnnotationsRAIIObj CleanupRAII(((Parser *)P)->TemplateIds);
 }
 
+void Parser::LateParserDeleterCallback(void *P) {
+  delete (Parser *)P;
+}
+
 bool Parser::ParseFirstTopLevelDecl(DeclGroupPtrTy &Result) {
   Actions.ActOnStartOfTranslationUnit();
 
@@ -592,8 +604,9 @@ bool Parser::ParseTopLevelDecl(DeclGroupPtrTy &Result) {
     return false;
 
   case tok::eof:
-    // Late template parsing can begin.
-    if (getLangOpts().DelayedTemplateParsing)
+    // Late template parsing can begin. Function bodies skipped outside the
+    // main file are parsed the same way when they are needed.
+    if (getLangOpts().DelayedTemplateParsing || SkipHeaderFunctionBodies)
       Actions.SetLateTemplateParser(LateTemplateParserCallback,
                                     PP.isIncrementalProcessingEnabled() ?
                                     LateTemplateParserCleanupCallback : nullptr,
@@ -1100,6 +1113,33 @@ Decl *Parser::ParseFunctionDefinition(ParsingDeclarator &D,
     }
     return DP;
   }
+  else if (isLazyFunctionBodyCandidate() && Tok.isNot(tok::equal) &&
+           !CurParsedObjCImpl && Actions.canDelayFunctionBody(D)) {
+    // Outside the main file, store the tokens of the body so that it can be
+    // parsed on demand, e.g. when a template is instantiated or a client asks
+    // for the body.
+    ParseScope BodyScope(this, Scope::FnScope | Scope::DeclScope |
+                                   Scope::CompoundStmtScope);
+    Scope *ParentScope = getCurScope()->getParent();
+
+    D.setFunctionDefinitionKind(FDK_Definition);
+    Decl *DP = Actions.HandleDeclarator(ParentScope, D,
+                                        TemplateInfo.TemplateParams
+                                            ? *TemplateInfo.TemplateParams
+                                            : MultiTemplateParamsArg());
+    D.complete(DP);
+    D.getMutableDeclSpec().abort();
+
+    CachedTokens Toks;
+    LexTemplateFunctionForLateParsing(Toks);
+
+    if (DP) {
+      FunctionDecl *FnD = DP->getAsFunction();
+      Actions.CheckForFunctionRedefinition(FnD);
+      Actions.MarkAsLateParsedTemplate(FnD, DP, Toks);
+    }
+    return DP;
+  }
   else if (CurParsedObjCImpl && 
            !TemplateInfo.TemplateParams &&
            (Tok.is(tok::l_brace) || Tok.is(tok::kw_try) ||
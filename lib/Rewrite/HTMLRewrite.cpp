@@ -364,11 +364,39 @@ void html::AddHeaderFooterInternalBuiltinCSS(Rewriter &R, FileID FID,
   R.InsertTextAfter(EndLoc, "</body></html>\n");
 }
 
+/// ApplyCachedHighlights - Apply the highlighting recorded for a file on an
+/// earlier call, if any.  Otherwise, return the list in which to record it.
+static html::RelexRewriteCache::HighlightList *
+ApplyCachedHighlights(RewriteBuffer &RB, const char *BufferStart, FileID FID,
+                      html::RelexRewriteCache::HighlightMap &Map,
+                      bool &Applied) {
+  auto Entry = Map.insert(
+      std::make_pair(FID, html::RelexRewriteCache::HighlightList()));
+  Applied = !Entry.second;
+  if (Applied)
+    for (const auto &H : Entry.first->second)
+      html::HighlightRange(RB, H.B, H.E, BufferStart, H.StartTag.c_str(),
+                           H.EndTag.c_str());
+  return &Entry.first->second;
+}
+
+/// HighlightAndRecord - Highlight a range, and record it in the list if
+/// there is one.
+static void HighlightAndRecord(RewriteBuffer &RB, unsigned B, unsigned E,
+                               const char *BufferStart,
+                               const char *StartTag, const char *EndTag,
+                               html::RelexRewriteCache::HighlightList *List) {
+  html::HighlightRange(RB, B, E, BufferStart, StartTag, EndTag);
+  if (List)
+    List->push_back({B, E, StartTag, EndTag});
+}
+
 /// SyntaxHighlight - Relex the specified FileID and annotate the HTML with
 /// information about keywords, macro expansions etc.  This uses the macro
 /// table state from the end of the file, so it won't be perfectly perfect,
 /// but it will be reasonably close.
-void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
+void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP,
+                           RelexRewriteCache *Cache) {
   RewriteBuffer &RB = R.getEditBuffer(FID);
 
   const SourceManager &SM = PP.getSourceManager();
@@ -376,6 +404,15 @@ void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
   Lexer L(FID, FromFile, SM, PP.getLangOpts());
   const char *BufferStart = L.getBuffer().data();
 
+  RelexRewriteCache::HighlightList *List = nullptr;
+  if (Cache) {
+    bool Applied;
+    List = ApplyCachedHighlights(RB, BufferStart, FID, Cache->SyntaxHighlights,
+                                 Applied);
+    if (Applied)
+      return;
+  }
+
   // Inform the preprocessor that we want to retain comments as tokens, so we
   // can highlight them.
   L.SetCommentRetentionState(true);
@@ -401,13 +438,13 @@ void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
 
       // If this is a pp-identifier, for a keyword, highlight it as such.
       if (Tok.isNot(tok::identifier))
-        HighlightRange(RB, TokOffs, TokOffs+TokLen, BufferStart,
-                       "<span class='keyword'>", "</span>");
+        HighlightAndRecord(RB, TokOffs, TokOffs+TokLen, BufferStart,
+                           "<span class='keyword'>", "</span>", List);
       break;
     }
     case tok::comment:
-      HighlightRange(RB, TokOffs, TokOffs+TokLen, BufferStart,
-                     "<span class='comment'>", "</span>");
+      HighlightAndRecord(RB, TokOffs, TokOffs+TokLen, BufferStart,
+                         "<span class='comment'>", "</span>", List);
       break;
     case tok::utf8_string_literal:
       // Chop off the u part of u8 prefix
@@ -424,8 +461,8 @@ void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
       // FALL THROUGH.
     case tok::string_literal:
       // FIXME: Exclude the optional ud-suffix from the highlighted range.
-      HighlightRange(RB, TokOffs, TokOffs+TokLen, BufferStart,
-                     "<span class='string_literal'>", "</span>");
+      HighlightAndRecord(RB, TokOffs, TokOffs+TokLen, BufferStart,
+                         "<span class='string_literal'>", "</span>", List);
       break;
     case tok::hash: {
       // If this is a preprocessor directive, all tokens to end of line are too.
@@ -442,8 +479,8 @@ void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
       }
 
       // Find end of line.  This is a hack.
-      HighlightRange(RB, TokOffs, TokEnd, BufferStart,
-                     "<span class='directive'>", "</span>");
+      HighlightAndRecord(RB, TokOffs, TokEnd, BufferStart,
+                         "<span class='directive'>", "</span>", List);
 
       // Don't skip the next token.
       continue;
@@ -458,13 +495,26 @@ void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
 /// file, to re-expand macros and insert (into the HTML) information about the
 /// macro expansions.  This won't be perfectly perfect, but it will be
 /// reasonably close.
-void html::HighlightMacros(Rewriter &R, FileID FID, const Preprocessor& PP) {
+void html::HighlightMacros(Rewriter &R, FileID FID, const Preprocessor& PP,
+                           RelexRewriteCache *Cache) {
+  RewriteBuffer &RB = R.getEditBuffer(FID);
+
   // Re-lex the raw token stream into a token buffer.
   const SourceManager &SM = PP.getSourceManager();
   std::vector<Token> TokenStream;
 
   const llvm::MemoryBuffer *FromFile = SM.getBuffer(FID);
   Lexer L(FID, FromFile, SM, PP.getLangOpts());
+  const char *BufferStart = L.getBuffer().data();
+
+  RelexRewriteCache::HighlightList *List = nullptr;
+  if (Cache) {
+    bool Applied;
+    List = ApplyCachedHighlights(RB, BufferStart, FID, Cache->MacroHighlights,
+                                 Applied);
+    if (Applied)
+      return;
+  }
 
   // Lex all the tokens in raw mode, to avoid entering #includes or expanding
   // macros.
@@ -587,8 +637,11 @@ void html::HighlightMacros(Rewriter &R, FileID FID, const Preprocessor& PP) {
     // highlighted.
     Expansion = "<span class='expansion'>" + Expansion + "</span></span>";
 
-    HighlightRange(R, LLoc.first, LLoc.second,
-                   "<span class='macro'>", Expansion.c_str());
+    unsigned BOffset = SM.getFileOffset(LLoc.first);
+    unsigned EOffset = SM.getFileOffset(LLoc.second) +
+        Lexer::MeasureTokenLength(LLoc.second, SM, R.getLangOpts());
+    HighlightAndRecord(RB, BOffset, EOffset, BufferStart,
+                       "<span class='macro'>", Expansion.c_str(), List);
   }
 
   // Restore the preprocessor's old state.
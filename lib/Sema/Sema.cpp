@@ -37,6 +37,7 @@
 #include "clang/Sema/SemaConsumer.h"
 #include "clang/Sema/SemaInternal.h"
 #include "clang/Sema/TemplateDeduction.h"
+#include "clang/Sema/TemplateProfile.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallSet.h"
 using namespace clang;
@@ -128,7 +129,8 @@ Sema::Sema(Preprocessor &pp, ASTContext &ctxt, ASTConsumer &consumer,
       CodeSegStack(nullptr), CurInitSeg(nullptr), VisContext(nullptr),
       PragmaAttributeCurrentTargetDecl(nullptr),
       IsBuildingRecoveryCallExpr(false), Cleanup{}, LateTemplateParser(nullptr),
-      LateTemplateParserCleanup(nullptr), OpaqueParser(nullptr), IdResolver(pp),
+      LateTemplateParserCleanup(nullptr), OpaqueParser(nullptr),
+      LateParserDeleter(nullptr), IdResolver(pp),
       StdExperimentalNamespaceCache(nullptr), StdInitializerList(nullptr),
       CXXTypeInfoDecl(nullptr), MSVCGuidDecl(nullptr), NSNumberDecl(nullptr),
       NSValueDecl(nullptr), NSStringDecl(nullptr),
@@ -330,6 +332,10 @@ void Sema::Initialize() {
 }
 
 Sema::~Sema() {
+  // Destroy the parser first if we own it; it still refers to us.
+  if (LateParserDeleter)
+    LateParserDeleter(OpaqueParser);
+
   if (VisContext) FreeVisContext();
   // Kill all the active scopes.
   for (unsigned I = 1, E = FunctionScopes.size(); I != E; ++I)
@@ -786,7 +792,7 @@ void Sema::ActOnEndOfTranslationUnit() {
     return;
 
   // Complete translation units and modules define vtables and perform implicit
-  // instantiations. PCH files do not.
+  // instantiations. PCH files do not, unless asked to perform instantiations.
   if (TUKind != TU_Prefix) {
     DiagnoseUseOfUnimplementedSelectors();
 
@@ -820,6 +826,12 @@ void Sema::ActOnEndOfTranslationUnit() {
       LateTemplateParserCleanup(OpaqueParser);
 
     CheckDelayedMemberExceptionSpecs();
+  } else if (LangOpts.PCHInstantiateTemplates) {
+    // Instantiate the templates the header already uses, so that their
+    // definitions are serialized into the PCH instead of being instantiated
+    // again by every translation unit that includes it. Instantiations whose
+    // definitions are not available yet are left pending for those units.
+    PerformPendingInstantiations(/*LocalOnly=*/false, /*AtEndOfTU=*/false);
   }
 
   DiagnoseUnterminatedPragmaPack();
@@ -1314,8 +1326,13 @@ void Sema::PopFunctionScopeInfo(const AnalysisBasedWarnings::Policy *WP,
     for (const auto &PUD : Scope->PossiblyUnreachableDiags)
       Diag(PUD.Loc, PUD.PD);
 
+  // The "top" function scope is reused rather than deleted; do not let it
+  // keep referring to the statements of the function, whose body may be
+  // released once it has been emitted (-fdiscard-function-bodies).
   if (FunctionScopes.back() != Scope)
     delete Scope;
+  else
+    Scope->Clear();
 }
 
 void Sema::PushCompoundScope() {
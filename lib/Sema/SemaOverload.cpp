@@ -4965,6 +4965,204 @@ TryCopyInitialization(Sema &S, Expr *From, QualType ToType,
                                /*AllowObjCConversionOnExplicit=*/false);
 }
 
+/// Get the definition of the class type \p T, if it is a complete class type
+/// whose members are known.
+static CXXRecordDecl *getCompleteClassDefinition(QualType T) {
+  CXXRecordDecl *RD = T->getAsCXXRecordDecl();
+  if (!RD || !(RD = RD->getDefinition()) || RD->isBeingDefined())
+    return nullptr;
+  return RD;
+}
+
+/// Determine whether there is obviously no implicit conversion sequence from
+/// \p From to the parameter type \p ToType: \p From is of a complete class
+/// type with no conversion functions, and \p ToType is a scalar type.
+static bool isObviouslyBadConversion(Sema &S, Expr *From, QualType ToType) {
+  if (!S.getLangOpts().CPlusPlus || !ToType->isScalarType())
+    return false;
+  CXXRecordDecl *FromRD = getCompleteClassDefinition(From->getType());
+  if (!FromRD)
+    return false;
+  auto Conversions = FromRD->getVisibleConversionFunctions();
+  return Conversions.begin() == Conversions.end();
+}
+
+/// Determine whether the classes named by \p T, directly or through
+/// pointers, references, arrays and member pointers, are all complete. A
+/// conversion involving a class that is not complete yet, such as one from a
+/// pointer to it to a pointer to a base class, may become possible once the
+/// class is defined.
+static bool involvesOnlyCompleteClasses(QualType T) {
+  while (true) {
+    T = T.getNonReferenceType();
+    if (const auto *PT = T->getAs<PointerType>()) {
+      T = PT->getPointeeType();
+    } else if (const auto *MPT = T->getAs<MemberPointerType>()) {
+      if (!involvesOnlyCompleteClasses(QualType(MPT->getClass(), 0)))
+        return false;
+      T = MPT->getPointeeType();
+    } else if (const ArrayType *AT = T->getAsArrayTypeUnsafe()) {
+      T = AT->getElementType();
+    } else {
+      break;
+    }
+  }
+  if (T->isObjCObjectPointerType())
+    return false;
+  if (T->isDependentType() || !T->getAsCXXRecordDecl())
+    return true;
+  return getCompleteClassDefinition(T);
+}
+
+/// Determine whether the implicit conversion sequence from \p From to the
+/// parameter type \p ToType may only depend on the type and value kind of
+/// \p From, so that it can be cached. This requires \p From to be of a
+/// complete class type, and \p ToType to be a scalar type or (a reference
+/// to) a complete class type, that only involves complete classes. The
+/// conversion functions and constructors that can be used are then known;
+/// getConversionCacheability checks the types they involve.
+static bool isCacheableConversion(Sema &S, Expr *From, QualType ToType) {
+  if (!S.getLangOpts().CPlusPlus || S.getLangOpts().CUDA ||
+      From->getObjectKind() != OK_Ordinary ||
+      !getCompleteClassDefinition(From->getType()))
+    return false;
+  QualType T = ToType.getNonReferenceType();
+  return (T->isScalarType() || getCompleteClassDefinition(T)) &&
+         involvesOnlyCompleteClasses(T);
+}
+
+namespace {
+/// Whether an implicit conversion sequence between two types can be cached.
+enum ConversionCacheability {
+  /// The sequence only depends on the types.
+  CC_Cacheable,
+  /// The sequence also depends on the context it is formed in, because it
+  /// involves deducing the arguments of a constructor or conversion function
+  /// template, and access checking is part of the substitution of those.
+  CC_PerContext,
+  /// The sequence depends on the value of the source expression, through
+  /// the enable_if attribute of a constructor or conversion function, or on
+  /// a class that is not complete yet, through the type of a conversion
+  /// function or of a parameter of a constructor.
+  CC_Uncacheable
+};
+}
+
+static ConversionCacheability
+getConversionCacheability(Sema &S, QualType FromType, QualType ToType) {
+  ConversionCacheability Result = CC_Cacheable;
+  auto Check = [&](NamedDecl *D) {
+    D = D->getUnderlyingDecl();
+    if (auto *FTD = dyn_cast<FunctionTemplateDecl>(D)) {
+      Result = CC_PerContext;
+      D = FTD->getTemplatedDecl();
+    }
+    if (D->hasAttr<EnableIfAttr>())
+      return false;
+    auto *FD = cast<FunctionDecl>(D);
+    if (auto *Conv = dyn_cast<CXXConversionDecl>(FD))
+      if (!involvesOnlyCompleteClasses(Conv->getConversionType()))
+        return false;
+    for (ParmVarDecl *Param : FD->parameters())
+      if (!involvesOnlyCompleteClasses(Param->getType()))
+        return false;
+    return true;
+  };
+
+  for (NamedDecl *D :
+       getCompleteClassDefinition(FromType)->getVisibleConversionFunctions())
+    if (!Check(D))
+      return CC_Uncacheable;
+  if (CXXRecordDecl *ToRD =
+          getCompleteClassDefinition(ToType.getNonReferenceType()))
+    for (NamedDecl *D : S.LookupConstructors(ToRD))
+      if (!Check(D))
+        return CC_Uncacheable;
+  return Result;
+}
+
+/// The number of implicit conversion sequences that are cached at most.
+static const unsigned MaxCachedConversionSequences = 1 << 14;
+
+/// Try to copy-initialize a parameter of type \p ToType from the expression
+/// \p From during overload resolution, reusing the conversion sequence formed
+/// by an earlier overload resolution with the same types if possible.
+static ImplicitConversionSequence
+TryCachedCopyInitialization(Sema &S, Expr *From, QualType ToType,
+                            bool SuppressUserConversions,
+                            bool AllowObjCWritebackConversion,
+                            bool AllowExplicit) {
+  unsigned Flags = From->getValueKind() << 3 | SuppressUserConversions << 2 |
+                   AllowObjCWritebackConversion << 1 | AllowExplicit;
+  Sema::ConversionSequenceCacheKey Key(
+      std::make_pair(From->getType().getAsOpaquePtr(),
+                     ToType.getAsOpaquePtr()),
+      std::make_pair(nullptr, Flags));
+
+  // Conversions that may depend on the context they are formed in are cached
+  // per context, under an uninitialized entry for the types.
+  auto Cached = S.ConversionSequenceCache.find(Key);
+  if (Cached != S.ConversionSequenceCache.end() &&
+      !Cached->second.isInitialized()) {
+    Key.second.first = S.CurContext;
+    Cached = S.ConversionSequenceCache.find(Key);
+  }
+
+  ImplicitConversionSequence ICS;
+  if (Cached != S.ConversionSequenceCache.end()) {
+    ICS = Cached->second;
+    if (ICS.isBad() && ICS.Bad.FromExpr)
+      ICS.Bad.setFromExpr(From);
+    return ICS;
+  }
+
+  ICS = TryCopyInitialization(S, From, ToType, SuppressUserConversions,
+                              /*InOverloadResolution=*/true,
+                              AllowObjCWritebackConversion, AllowExplicit);
+  if (ICS.isAmbiguous())
+    return ICS;
+  // Keep the cache bounded by starting over once it is full.
+  if (S.ConversionSequenceCache.size() >= MaxCachedConversionSequences)
+    S.ConversionSequenceCache.clear();
+  if (!Key.second.first && !SuppressUserConversions) {
+    switch (getConversionCacheability(S, From->getType(), ToType)) {
+    case CC_Cacheable:
+      break;
+    case CC_PerContext:
+      S.ConversionSequenceCache[Key] = ImplicitConversionSequence();
+      Key.second.first = S.CurContext;
+      break;
+    case CC_Uncacheable:
+      return ICS;
+    }
+  }
+  S.ConversionSequenceCache[Key] = ICS;
+  return ICS;
+}
+
+/// Try to copy-initialize the parameter of type \p ParamType of an overload
+/// candidate from the argument \p Arg.
+static ImplicitConversionSequence
+TryArgumentInitialization(Sema &S, Expr *Arg, QualType ParamType,
+                          bool SuppressUserConversions,
+                          bool AllowExplicit = false) {
+  ImplicitConversionSequence ICS;
+  if (isObviouslyBadConversion(S, Arg, ParamType)) {
+    ICS.setBad(BadConversionSequence::no_conversion, Arg, ParamType);
+    return ICS;
+  }
+
+  bool AllowObjCWritebackConversion = S.getLangOpts().ObjCAutoRefCount;
+  if (isCacheableConversion(S, Arg, ParamType))
+    return TryCachedCopyInitialization(S, Arg, ParamType,
+                                       SuppressUserConversions,
+                                       AllowObjCWritebackConversion,
+                                       AllowExplicit);
+  return TryCopyInitialization(S, Arg, ParamType, SuppressUserConversions,
+                               /*InOverloadResolution=*/true,
+                               AllowObjCWritebackConversion, AllowExplicit);
+}
+
 static bool TryCopyInitialization(const CanQualType FromQTy,
                                   const CanQualType ToQTy,
                                   Sema &S,
@@ -6001,13 +6199,9 @@ Sema::AddOverloadCandidate(FunctionDecl *Function,
       // (13.3.3.1) that converts that argument to the corresponding
       // parameter of F.
       QualType ParamType = Proto->getParamType(ArgIdx);
-      Candidate.Conversions[ArgIdx]
-        = TryCopyInitialization(*this, Args[ArgIdx], ParamType,
-                                SuppressUserConversions,
-                                /*InOverloadResolution=*/true,
-                                /*AllowObjCWritebackConversion=*/
-                                  getLangOpts().ObjCAutoRefCount,
-                                AllowExplicit);
+      Candidate.Conversions[ArgIdx] =
+          TryArgumentInitialization(*this, Args[ArgIdx], ParamType,
+                                    SuppressUserConversions, AllowExplicit);
       if (Candidate.Conversions[ArgIdx].isBad()) {
         Candidate.Viable = false;
         Candidate.FailureKind = ovl_fail_bad_conversion;
@@ -6501,12 +6695,9 @@ Sema::AddMethodCandidate(CXXMethodDecl *Method, DeclAccessPair FoundDecl,
       // (13.3.3.1) that converts that argument to the corresponding
       // parameter of F.
       QualType ParamType = Proto->getParamType(ArgIdx);
-      Candidate.Conversions[ArgIdx + 1]
-        = TryCopyInitialization(*this, Args[ArgIdx], ParamType,
-                                SuppressUserConversions,
-                                /*InOverloadResolution=*/true,
-                                /*AllowObjCWritebackConversion=*/
-                                  getLangOpts().ObjCAutoRefCount);
+      Candidate.Conversions[ArgIdx + 1] =
+          TryArgumentInitialization(*this, Args[ArgIdx], ParamType,
+                                    SuppressUserConversions);
       if (Candidate.Conversions[ArgIdx + 1].isBad()) {
         Candidate.Viable = false;
         Candidate.FailureKind = ovl_fail_bad_conversion;
@@ -6701,13 +6892,9 @@ bool Sema::CheckNonDependentConversions(
        ++I) {
     QualType ParamType = ParamTypes[I];
     if (!ParamType->isDependentType()) {
-      Conversions[ThisConversions + I]
-        = TryCopyInitialization(*this, Args[I], ParamType,
-                                SuppressUserConversions,
-                                /*InOverloadResolution=*/true,
-                                /*AllowObjCWritebackConversion=*/
-                                  getLangOpts().ObjCAutoRefCount,
-                                AllowExplicit);
+      Conversions[ThisConversions + I] =
+          TryArgumentInitialization(*this, Args[I], ParamType,
+                                    SuppressUserConversions, AllowExplicit);
       if (Conversions[ThisConversions + I].isBad())
         return true;
     }
@@ -9829,6 +9829,34 @@ void Sema::UnmarkAsLateParsedTemplate(FunctionDecl *FD) {
   FD->setLateTemplateParsed(false);
 }
 
+bool Sema::LateParseFunctionBody(FunctionDecl *FD) {
+  if (!FD->isLateTemplateParsed())
+    return FD->hasBody();
+
+  // The parser is gone; there is nobody left to parse the stored tokens.
+  if (!LateTemplateParser)
+    return false;
+
+  if (FD->isFromASTFile() && ExternalSource)
+    ExternalSource->ReadLateParsedTemplates(LateParsedTemplateMap);
+
+  auto LPTIter = LateParsedTemplateMap.find(FD);
+  if (LPTIter == LateParsedTemplateMap.end())
+    return false;
+
+  // Anything the body needs instantiated has to be instantiated now; we may
+  // be past the end of the translation unit already.
+  GlobalEagerInstantiationScope GlobalInstantiations(*this, /*Enabled=*/true);
+  LocalEagerInstantiationScope LocalInstantiations(*this);
+
+  LateTemplateParser(OpaqueParser, *LPTIter->second);
+
+  LocalInstantiations.perform();
+  GlobalInstantiations.perform();
+
+  return FD->hasBody();
+}
+
 bool Sema::IsInsideALocalClassWithinATemplateFunction() {
   DeclContext *DC = CurContext;
 
@@ -23,6 +23,7 @@
 #include "clang/Sema/DeclSpec.h"
 #include "clang/Sema/Sema.h"
 #include "clang/Sema/Template.h"
+#include "clang/Sema/TemplateProfile.h"
 #include "llvm/ADT/SmallBitVector.h"
 #include <algorithm>
 
@@ -2615,6 +2616,10 @@ Sema::DeduceTemplateArguments(ClassTemplatePartialSpecializationDecl *Partial,
   if (Partial->isInvalidDecl())
     return TDK_Invalid;
 
+  TemplateProfile::Scope Profile(
+      TemplateProfiler.get(), TemplateProfile::TPA_Deduction,
+      [&] { return Partial; });
+
   // C++ [temp.class.spec.match]p2:
   //   A partial specialization matches a given actual template
   //   argument list if the template arguments of the partial
@@ -2658,6 +2663,10 @@ Sema::DeduceTemplateArguments(VarTemplatePartialSpecializationDecl *Partial,
   if (Partial->isInvalidDecl())
     return TDK_Invalid;
 
+  TemplateProfile::Scope Profile(
+      TemplateProfiler.get(), TemplateProfile::TPA_Deduction,
+      [&] { return Partial; });
+
   // C++ [temp.class.spec.match]p2:
   //   A partial specialization matches a given actual template
   //   argument list if the template arguments of the partial
@@ -3556,6 +3565,10 @@ Sema::TemplateDeductionResult Sema::DeduceTemplateArguments(
   if (FunctionTemplate->isInvalidDecl())
     return TDK_Invalid;
 
+  TemplateProfile::Scope Profile(
+      TemplateProfiler.get(), TemplateProfile::TPA_Deduction,
+      [&] { return FunctionTemplate; });
+
   FunctionDecl *Function = FunctionTemplate->getTemplatedDecl();
   unsigned NumParams = Function->getNumParams();
 
@@ -3769,6 +3782,10 @@ Sema::TemplateDeductionResult Sema::DeduceTemplateArguments(
   if (FunctionTemplate->isInvalidDecl())
     return TDK_Invalid;
 
+  TemplateProfile::Scope Profile(
+      TemplateProfiler.get(), TemplateProfile::TPA_Deduction,
+      [&] { return FunctionTemplate; });
+
   FunctionDecl *Function = FunctionTemplate->getTemplatedDecl();
   TemplateParameterList *TemplateParams
     = FunctionTemplate->getTemplateParameters();
@@ -3997,6 +4014,10 @@ Sema::DeduceTemplateArguments(FunctionTemplateDecl *ConversionTemplate,
   if (ConversionTemplate->isInvalidDecl())
     return TDK_Invalid;
 
+  TemplateProfile::Scope Profile(
+      TemplateProfiler.get(), TemplateProfile::TPA_Deduction,
+      [&] { return ConversionTemplate; });
+
   CXXConversionDecl *ConversionGeneric
     = cast<CXXConversionDecl>(ConversionTemplate->getTemplatedDecl());
 
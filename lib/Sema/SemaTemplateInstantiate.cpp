@@ -25,6 +25,7 @@
 #include "clang/Sema/PrettyDeclStackTrace.h"
 #include "clang/Sema/Template.h"
 #include "clang/Sema/TemplateDeduction.h"
+#include "clang/Sema/TemplateProfile.h"
 
 using namespace clang;
 using namespace sema;
@@ -1568,6 +1569,9 @@ TypeSourceInfo *Sema::SubstType(TypeSourceInfo *T,
       !T->getType()->isVariablyModifiedType())
     return T;
 
+  TemplateProfile::Scope Profile(
+      TemplateProfiler.get(), TemplateProfile::TPA_SubstType,
+      [&] { return CodeSynthesisContexts.back().Entity; });
   TemplateInstantiator Instantiator(*this, Args, Loc, Entity);
   return AllowDeducedTST ? Instantiator.TransformTypeWithDeducedTST(T)
                          : Instantiator.TransformType(T);
@@ -1593,6 +1597,9 @@ TypeSourceInfo *Sema::SubstType(TypeLoc TL,
     return TLB.getTypeSourceInfo(Context, TL.getType());
   }
 
+  TemplateProfile::Scope Profile(
+      TemplateProfiler.get(), TemplateProfile::TPA_SubstType,
+      [&] { return CodeSynthesisContexts.back().Entity; });
   TemplateInstantiator Instantiator(*this, Args, Loc, Entity);
   TypeLocBuilder TLB;
   TLB.reserve(TL.getFullDataSize());
@@ -1616,6 +1623,9 @@ QualType Sema::SubstType(QualType T,
   if (!T->isInstantiationDependentType() && !T->isVariablyModifiedType())
     return T;
 
+  TemplateProfile::Scope Profile(
+      TemplateProfiler.get(), TemplateProfile::TPA_SubstType,
+      [&] { return CodeSynthesisContexts.back().Entity; });
   TemplateInstantiator Instantiator(*this, TemplateArgs, Loc, Entity);
   return Instantiator.TransformType(T);
 }
@@ -2013,6 +2023,9 @@ Sema::InstantiateClass(SourceLocation PointOfInstantiation,
   assert(!Inst.isAlreadyInstantiating() && "should have been caught by caller");
   PrettyDeclStackTraceEntry CrashInfo(*this, Instantiation, SourceLocation(),
                                       "instantiating class definition");
+  TemplateProfile::Scope Profile(
+      TemplateProfiler.get(), TemplateProfile::TPA_InstantiateClass,
+      [&] { return Instantiation; });
 
   // Enter the scope of this instantiation. We don't use
   // PushDeclContext because we don't have a scope.
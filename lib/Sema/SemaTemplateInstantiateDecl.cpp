@@ -23,6 +23,7 @@
 #include "clang/Sema/Lookup.h"
 #include "clang/Sema/PrettyDeclStackTrace.h"
 #include "clang/Sema/Template.h"
+#include "clang/Sema/TemplateProfile.h"
 
 using namespace clang;
 
@@ -3867,6 +3868,9 @@ void Sema::InstantiateFunctionDefinition(SourceLocation PointOfInstantiation,
     return;
   PrettyDeclStackTraceEntry CrashInfo(*this, Function, SourceLocation(),
                                       "instantiating function definition");
+  TemplateProfile::Scope Profile(
+      TemplateProfiler.get(), TemplateProfile::TPA_InstantiateFunction,
+      [&] { return Function; });
 
   // The instantiation is visible here, even if it was first declared in an
   // unimported module.
@@ -5130,7 +5134,13 @@ NamedDecl *Sema::FindInstantiatedDecl(SourceLocation Loc, NamedDecl *D,
 
 /// \brief Performs template instantiation for all implicit template
 /// instantiations we have seen until this point.
-void Sema::PerformPendingInstantiations(bool LocalOnly) {
+///
+/// \param AtEndOfTU Whether this is the end of the translation unit. If not,
+/// instantiations that cannot be performed yet, because their template is not
+/// defined yet, are silently left pending instead of being diagnosed.
+void Sema::PerformPendingInstantiations(bool LocalOnly, bool AtEndOfTU) {
+  std::deque<PendingImplicitInstantiation> Deferred;
+
   while (!PendingLocalImplicitInstantiations.empty() ||
          (!LocalOnly && !PendingInstantiations.empty())) {
     PendingImplicitInstantiation Inst;
@@ -5145,16 +5155,33 @@ void Sema::PerformPendingInstantiations(bool LocalOnly) {
 
     // Instantiate function definitions
     if (FunctionDecl *Function = dyn_cast<FunctionDecl>(Inst.first)) {
+      if (!AtEndOfTU) {
+        FunctionDecl *Pattern = Function->getTemplateInstantiationPattern();
+        if (!Pattern || !Pattern->isDefined()) {
+          Deferred.push_back(Inst);
+          continue;
+        }
+      }
+
+      // Before the end of the translation unit, instantiations required by
+      // this one are added to our queue rather than performed recursively,
+      // so that they can be deferred as well.
       bool DefinitionRequired = Function->getTemplateSpecializationKind() ==
                                 TSK_ExplicitInstantiationDefinition;
-      InstantiateFunctionDefinition(/*FIXME:*/Inst.second, Function, true,
-                                    DefinitionRequired, true);
+      InstantiateFunctionDefinition(/*FIXME:*/Inst.second, Function,
+                                    /*Recursive=*/AtEndOfTU,
+                                    DefinitionRequired, AtEndOfTU);
       if (Function->isDefined())
         Function->setInstantiationIsPending(false);
       continue;
     }
 
-    // Instantiate variable definitions
+    // Instantiate variable definitions at the end of the translation unit
+    // only; their definitions may still be provided out of line.
+    if (!AtEndOfTU) {
+      Deferred.push_back(Inst);
+      continue;
+    }
     VarDecl *Var = cast<VarDecl>(Inst.first);
 
     assert((Var->isStaticDataMember() ||
@@ -5193,6 +5220,9 @@ void Sema::PerformPendingInstantiations(bool LocalOnly) {
     InstantiateVariableDefinition(/*FIXME:*/ Inst.second, Var, true,
                                   DefinitionRequired, true);
   }
+
+  PendingInstantiations.insert(PendingInstantiations.end(), Deferred.begin(),
+                               Deferred.end());
 }
 
 void Sema::PerformDependentDiagnostics(const DeclContext *Pattern,
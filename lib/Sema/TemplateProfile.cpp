@@ -0,0 +1,113 @@
+//===--- TemplateProfile.cpp - Cost of template instantiation -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the TemplateProfile class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Sema/TemplateProfile.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclCXX.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace clang;
+
+void TemplateProfile::enter(Activity A, const Decl *Template) {
+  Stack.push_back({A, Template, Clock::now(), Context.getASTAllocatedBytes(),
+                   Clock::duration::zero(), 0});
+}
+
+void TemplateProfile::exit() {
+  assert(!Stack.empty() && "unbalanced template profile scopes");
+  ActiveScope Active = Stack.pop_back_val();
+  Clock::duration Time = Clock::now() - Active.StartTime;
+  size_t Bytes = Context.getASTAllocatedBytes() - Active.StartBytes;
+
+  Cost &C = Costs[std::make_pair(Active.Template, unsigned(Active.Kind))];
+  ++C.Count;
+  C.Time += Time - Active.NestedTime;
+  C.Bytes += Bytes - Active.NestedBytes;
+
+  if (!Stack.empty()) {
+    Stack.back().NestedTime += Time;
+    Stack.back().NestedBytes += Bytes;
+  }
+}
+
+static StringRef getActivityName(TemplateProfile::Activity A) {
+  switch (A) {
+  case TemplateProfile::TPA_InstantiateClass:
+    return "class";
+  case TemplateProfile::TPA_InstantiateFunction:
+    return "function";
+  case TemplateProfile::TPA_SubstType:
+    return "subst-type";
+  case TemplateProfile::TPA_Deduction:
+    return "deduction";
+  case TemplateProfile::TPA_NumActivities:
+    break;
+  }
+  llvm_unreachable("unknown template profile activity");
+}
+
+/// Get the name under which the cost of an activity on \p D is reported: the
+/// name of the template \p D is instantiated from, if any.
+static std::string getTemplateName(const Decl *D) {
+  if (const auto *FD = dyn_cast_or_null<FunctionDecl>(D)) {
+    if (const FunctionDecl *Pattern = FD->getTemplateInstantiationPattern())
+      D = Pattern;
+  } else if (const auto *RD = dyn_cast_or_null<CXXRecordDecl>(D)) {
+    if (const CXXRecordDecl *Pattern = RD->getTemplateInstantiationPattern())
+      D = Pattern;
+  } else if (const auto *VD = dyn_cast_or_null<VarDecl>(D)) {
+    if (const VarDecl *Pattern = VD->getTemplateInstantiationPattern())
+      D = Pattern;
+  }
+  if (const auto *ND = dyn_cast_or_null<NamedDecl>(D))
+    return ND->getQualifiedNameAsString();
+  return "<unknown>";
+}
+
+void TemplateProfile::print(raw_ostream &OS) const {
+  // Specializations of the same template are reported together, by name, as
+  // they would be when merging the profiles of several translation units.
+  std::map<std::pair<std::string, unsigned>, Cost> ByName;
+  for (const auto &Entry : Costs) {
+    Cost &C = ByName[std::make_pair(getTemplateName(Entry.first.first),
+                                    Entry.first.second)];
+    C.Count += Entry.second.Count;
+    C.Time += Entry.second.Time;
+    C.Bytes += Entry.second.Bytes;
+  }
+
+  typedef std::pair<const std::pair<std::string, unsigned>, Cost> NamedCost;
+  std::vector<const NamedCost *> Sorted;
+  for (const NamedCost &Entry : ByName)
+    Sorted.push_back(&Entry);
+  std::stable_sort(Sorted.begin(), Sorted.end(),
+                   [](const NamedCost *LHS, const NamedCost *RHS) {
+                     return std::make_tuple(LHS->second.Time,
+                                            LHS->second.Bytes) >
+                            std::make_tuple(RHS->second.Time,
+                                            RHS->second.Bytes);
+                   });
+
+  for (const NamedCost *Entry : Sorted) {
+    const Cost &C = Entry->second;
+    OS << getActivityName(Activity(Entry->first.second)) << '\t' << C.Count
+       << '\t'
+       << std::chrono::duration_cast<std::chrono::microseconds>(C.Time).count()
+       << '\t' << C.Bytes << '\t' << Entry->first.first << '\n';
+  }
+}
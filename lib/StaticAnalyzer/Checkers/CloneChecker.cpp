@@ -21,6 +21,10 @@
 #include "clang/StaticAnalyzer/Core/CheckerManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/AnalysisManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/CheckerContext.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace clang;
 using namespace ento;
@@ -38,6 +42,12 @@ public:
   void checkEndOfTranslationUnit(const TranslationUnitDecl *TU,
                                  AnalysisManager &Mgr, BugReporter &BR) const;
 
+  /// Writes the fingerprints of the clone candidates of this translation unit
+  /// to a new file in \p Dir, to find clones across translation units later.
+  void saveFingerprints(AnalysisManager &Mgr, StringRef Dir,
+                        unsigned MinComplexity,
+                        StringRef IgnoredFilesPattern) const;
+
   /// Reports all clones to the user.
   void reportClones(BugReporter &BR, AnalysisManager &Mgr,
                     std::vector<CloneDetector::CloneGroup> &CloneGroups) const;
@@ -76,6 +86,11 @@ void CloneChecker::checkEndOfTranslationUnit(const TranslationUnitDecl *TU,
   StringRef IgnoredFilesPattern = Mgr.getAnalyzerOptions().getOptionAsString(
       "IgnoredFilesPattern", "", this);
 
+  StringRef FingerprintDir = Mgr.getAnalyzerOptions().getOptionAsString(
+      "FingerprintDir", "", this);
+  if (!FingerprintDir.empty())
+    saveFingerprints(Mgr, FingerprintDir, MinComplexity, IgnoredFilesPattern);
+
   // Let the CloneDetector create a list of clones from all the analyzed
   // statements. We don't filter for matching variable patterns at this point
   // because reportSuspiciousClones() wants to search them for errors.
@@ -104,6 +119,65 @@ void CloneChecker::checkEndOfTranslationUnit(const TranslationUnitDecl *TU,
   reportClones(BR, Mgr, AllCloneGroups);
 }
 
+void CloneChecker::saveFingerprints(AnalysisManager &Mgr, StringRef Dir,
+                                    unsigned MinComplexity,
+                                    StringRef IgnoredFilesPattern) const {
+  // Without real constraints, the only group holds every analyzed sequence.
+  std::vector<CloneDetector::CloneGroup> AllSequences;
+  Detector.findClones(AllSequences, MinGroupSizeConstraint(1));
+
+  // Drop the sequences in ignored files one by one, as the constraint drops
+  // whole groups.
+  FilenamePatternConstraint IgnoredFiles(IgnoredFilesPattern);
+  CloneDetector::CloneGroup Sequences;
+  for (const CloneDetector::CloneGroup &Group : AllSequences)
+    for (const StmtSequence &S : Group)
+      if (!IgnoredFiles.isAutoGenerated({S}))
+        Sequences.push_back(S);
+
+  SourceManager &SM = Mgr.getSourceManager();
+  const FileEntry *MainFile = SM.getFileEntryForID(SM.getMainFileID());
+  if (!MainFile)
+    return;
+  StringRef MainBuffer = SM.getBufferData(SM.getMainFileID());
+  unsigned NumLines = std::count(MainBuffer.begin(), MainBuffer.end(), '\n');
+
+  CloneFingerprintSet Fingerprints;
+  Fingerprints.addTranslationUnit(Sequences, MinComplexity, NumLines);
+
+  // The fingerprints only serve to find clones across translation units, so
+  // failing to write them does not fail the analysis.
+  DiagnosticsEngine &Diags = Mgr.getDiagnostic();
+  unsigned WriteErrorID = Diags.getCustomDiagID(
+      DiagnosticsEngine::Warning,
+      "could not write clone fingerprints to '%0': %1");
+
+  if (std::error_code EC = llvm::sys::fs::create_directories(Dir)) {
+    Diags.Report(WriteErrorID) << Dir << EC.message();
+    return;
+  }
+
+  SmallString<128> Model(Dir);
+  llvm::sys::path::append(Model, llvm::sys::path::filename(MainFile->getName()) +
+                                     "-%%%%%%%%.clonefp");
+  SmallString<128> ResultPath;
+  int FD;
+  if (std::error_code EC =
+          llvm::sys::fs::createUniqueFile(Model, FD, ResultPath)) {
+    Diags.Report(WriteErrorID) << Dir << EC.message();
+    return;
+  }
+
+  llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+  Fingerprints.write(OS);
+  OS.close();
+  if (OS.has_error()) {
+    Diags.Report(WriteErrorID) << ResultPath << "write error";
+    OS.clear_error();
+    llvm::sys::fs::remove(ResultPath);
+  }
+}
+
 static PathDiagnosticLocation makeLocation(const StmtSequence &S,
                                            AnalysisManager &Mgr) {
   ASTContext &ACtx = Mgr.getASTContext();
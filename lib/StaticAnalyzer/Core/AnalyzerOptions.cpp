@@ -356,6 +356,12 @@ unsigned AnalyzerOptions::getMaxNodesPerTopLevelFunction() {
   return MaxNodesPerTopLevelFunction.getValue();
 }
 
+unsigned AnalyzerOptions::getMaxCachedDeclContexts() {
+  if (!MaxCachedDeclContexts.hasValue())
+    MaxCachedDeclContexts = getOptionAsInteger("max-cached-decl-contexts", 256);
+  return MaxCachedDeclContexts.getValue();
+}
+
 bool AnalyzerOptions::shouldSynthesizeBodies() {
   return getBooleanOption("faux-bodies", true);
 }
@@ -386,6 +392,17 @@ bool AnalyzerOptions::shouldUnrollLoops() {
   return UnrollLoops.getValue();
 }
 
+bool AnalyzerOptions::shouldSummarizePureFunctions() {
+  if (!SummarizePureFunctions.hasValue())
+    SummarizePureFunctions =
+        getBooleanOption("summarize-pure-functions", /*Default=*/false);
+  return SummarizePureFunctions.getValue();
+}
+
+StringRef AnalyzerOptions::getAnalysisCacheDir() {
+  return getOptionAsString("analysis-cache-dir", "");
+}
+
 bool AnalyzerOptions::shouldDisplayNotesAsEvents() {
   if (!DisplayNotesAsEvents.hasValue())
     DisplayNotesAsEvents =
@@ -2759,6 +2759,45 @@ ExplodedGraph &GRBugReporter::getGraph() { return Eng.getGraph(); }
 ProgramStateManager&
 GRBugReporter::getStateManager() { return Eng.getStateManager(); }
 
+const GRBugReporter::NodeOrderMap &GRBugReporter::getShortestPathOrder() {
+  const ExplodedGraph &G = getGraph();
+  if (OrderedGraph == &G && OrderedGeneration == G.getGeneration())
+    return ShortestPathOrder;
+
+  // Perform a forward BFS over the whole graph, once for all the reports.
+  // Every node on a path from a root to an error node reaches the error node,
+  // so this finds the same shortest paths as a search of the graph trimmed to
+  // the error nodes of each equivalence class.
+  ShortestPathOrder.clear();
+  OrderedGraph = &G;
+  OrderedGeneration = G.getGeneration();
+
+  std::queue<const ExplodedNode *> WS;
+  unsigned Priority = 0;
+  for (ExplodedGraph::const_roots_iterator I = G.roots_begin(),
+                                           E = G.roots_end();
+       I != E; ++I)
+    if (ShortestPathOrder.insert(std::make_pair(*I, Priority)).second) {
+      WS.push(*I);
+      ++Priority;
+    }
+
+  while (!WS.empty()) {
+    const ExplodedNode *Node = WS.front();
+    WS.pop();
+
+    for (ExplodedNode::const_succ_iterator I = Node->succ_begin(),
+                                           E = Node->succ_end();
+         I != E; ++I)
+      if (ShortestPathOrder.insert(std::make_pair(*I, Priority)).second) {
+        WS.push(*I);
+        ++Priority;
+      }
+  }
+
+  return ShortestPathOrder;
+}
+
 BugReporter::~BugReporter() {
   FlushReports();
 
@@ -2817,18 +2856,15 @@ public:
   size_t Index;
 };
 
-/// A wrapper around a trimmed graph and its node maps.
-class TrimmedGraph {
-  InterExplodedGraphMap InverseMap;
-
-  typedef llvm::DenseMap<const ExplodedNode *, unsigned> PriorityMapTy;
-  PriorityMapTy PriorityMap;
+/// The error nodes of an equivalence class of reports, from which the graphs
+/// of their shortest paths are built.
+class ReportPaths {
+  typedef GRBugReporter::NodeOrderMap PriorityMapTy;
+  const PriorityMapTy &PriorityMap;
 
   typedef std::pair<const ExplodedNode *, size_t> NodeIndexPair;
   SmallVector<NodeIndexPair, 32> ReportNodes;
 
-  std::unique_ptr<ExplodedGraph> G;
-
   /// A helper class for sorting ExplodedNodes by priority.
   template <bool Descending>
   class PriorityCompare {
@@ -2857,72 +2893,28 @@ class TrimmedGraph {
   };
 
 public:
-  TrimmedGraph(const ExplodedGraph *OriginalGraph,
-               ArrayRef<const ExplodedNode *> Nodes);
+  ReportPaths(const PriorityMapTy &PriorityMap,
+              ArrayRef<const ExplodedNode *> Nodes);
 
   bool popNextReportGraph(ReportGraph &GraphWrapper);
 };
 }
 
-TrimmedGraph::TrimmedGraph(const ExplodedGraph *OriginalGraph,
-                           ArrayRef<const ExplodedNode *> Nodes) {
-  // The trimmed graph is created in the body of the constructor to ensure
-  // that the DenseMaps have been initialized already.
-  InterExplodedGraphMap ForwardMap;
-  G = OriginalGraph->trim(Nodes, &ForwardMap, &InverseMap);
+ReportPaths::ReportPaths(const PriorityMapTy &PriorityMap,
+                         ArrayRef<const ExplodedNode *> Nodes)
+    : PriorityMap(PriorityMap) {
+  for (unsigned i = 0, count = Nodes.size(); i < count; ++i)
+    if (Nodes[i])
+      ReportNodes.push_back(std::make_pair(Nodes[i], i));
 
-  // Find the (first) error node in the trimmed graph.  We just need to consult
-  // the node map which maps from nodes in the original graph to nodes
-  // in the new graph.
-  llvm::SmallPtrSet<const ExplodedNode *, 32> RemainingNodes;
-
-  for (unsigned i = 0, count = Nodes.size(); i < count; ++i) {
-    if (const ExplodedNode *NewNode = ForwardMap.lookup(Nodes[i])) {
-      ReportNodes.push_back(std::make_pair(NewNode, i));
-      RemainingNodes.insert(NewNode);
-    }
-  }
-
-  assert(!RemainingNodes.empty() && "No error node found in the trimmed graph");
-
-  // Perform a forward BFS to find all the shortest paths.
-  std::queue<const ExplodedNode *> WS;
-
-  assert(G->num_roots() == 1);
-  WS.push(*G->roots_begin());
-  unsigned Priority = 0;
-
-  while (!WS.empty()) {
-    const ExplodedNode *Node = WS.front();
-    WS.pop();
-
-    PriorityMapTy::iterator PriorityEntry;
-    bool IsNew;
-    std::tie(PriorityEntry, IsNew) =
-      PriorityMap.insert(std::make_pair(Node, Priority));
-    ++Priority;
-
-    if (!IsNew) {
-      assert(PriorityEntry->second <= Priority);
-      continue;
-    }
-
-    if (RemainingNodes.erase(Node))
-      if (RemainingNodes.empty())
-        break;
-
-    for (ExplodedNode::const_pred_iterator I = Node->succ_begin(),
-                                           E = Node->succ_end();
-         I != E; ++I)
-      WS.push(*I);
-  }
+  assert(!ReportNodes.empty() && "No error node found");
 
   // Sort the error paths from longest to shortest.
   std::sort(ReportNodes.begin(), ReportNodes.end(),
             PriorityCompare<true>(PriorityMap));
 }
 
-bool TrimmedGraph::popNextReportGraph(ReportGraph &GraphWrapper) {
+bool ReportPaths::popNextReportGraph(ReportGraph &GraphWrapper) {
   if (ReportNodes.empty())
     return false;
 
@@ -2946,9 +2938,7 @@ bool TrimmedGraph::popNextReportGraph(ReportGraph &GraphWrapper) {
                                        OrigN->isSink());
 
     // Store the mapping to the original node.
-    InterExplodedGraphMap::const_iterator IMitr = InverseMap.find(OrigN);
-    assert(IMitr != InverseMap.end() && "No mapping to original node.");
-    GraphWrapper.BackMap[NewN] = IMitr->second;
+    GraphWrapper.BackMap[NewN] = OrigN;
 
     // Link up the new node with the previous node.
     if (Succ)
@@ -3105,10 +3095,10 @@ bool GRBugReporter::generatePathDiagnostic(PathDiagnostic& PD,
     }
   }
 
-  TrimmedGraph TrimG(&getGraph(), errorNodes);
+  ReportPaths Paths(getShortestPathOrder(), errorNodes);
   ReportGraph ErrorGraph;
 
-  while (TrimG.popNextReportGraph(ErrorGraph)) {
+  while (Paths.popNextReportGraph(ErrorGraph)) {
     // Find the BugReport with the original location.
     assert(ErrorGraph.Index < bugReports.size());
     BugReport *R = bugReports[ErrorGraph.Index];
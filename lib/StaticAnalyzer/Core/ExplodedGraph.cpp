@@ -46,7 +46,7 @@ void ExplodedNode::SetAuditor(ExplodedNode::Auditor* A) {
 //===----------------------------------------------------------------------===//
 
 ExplodedGraph::ExplodedGraph()
-  : NumNodes(0), ReclaimNodeInterval(0) {}
+  : NumNodes(0), Generation(0), ReclaimNodeInterval(0) {}
 
 ExplodedGraph::~ExplodedGraph() {}
 
@@ -172,6 +172,7 @@ void ExplodedGraph::collectNode(ExplodedNode *node) {
   FreeNodes.push_back(node);
   Nodes.RemoveNode(node);
   --NumNodes;
+  ++Generation;
   node->~ExplodedNode();
 }
 
@@ -217,6 +218,7 @@ void ExplodedNode::addPredecessor(ExplodedNode *V, ExplodedGraph &G) {
   assert (!V->isSink());
   Preds.addNode(V, G);
   V->Succs.addNode(this, G);
+  ++G.Generation;
 #ifndef NDEBUG
   if (NodeAuditor) NodeAuditor->AddEdge(V, this);
 #endif
@@ -325,6 +327,7 @@ ExplodedNode *ExplodedGraph::getNode(const ProgramPoint &L,
     // Insert the node into the node set and return it.
     Nodes.InsertNode(V, InsertPos);
     ++NumNodes;
+    ++Generation;
 
     if (IsNew) *IsNew = true;
   }
@@ -339,6 +342,7 @@ ExplodedNode *ExplodedGraph::createUncachedNode(const ProgramPoint &L,
                                                 bool IsSink) {
   NodeTy *V = (NodeTy *) getAllocator().Allocate<NodeTy>();
   new (V) NodeTy(L, State, IsSink);
+  ++Generation;
   return V;
 }
 
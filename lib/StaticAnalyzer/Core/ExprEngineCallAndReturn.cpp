@@ -37,6 +37,9 @@ STATISTIC(NumInlinedCalls,
 STATISTIC(NumReachedInlineCountMax,
   "The # of times we reached inline count maximum");
 
+STATISTIC(NumSummarizedCalls,
+  "The # of times we reused the result of an earlier inlined call");
+
 void ExprEngine::processCallEnter(NodeBuilderContext& BC, CallEnter CE,
                                   ExplodedNode *Pred) {
   // Get the entry block in the CFG of the callee.
@@ -210,6 +213,20 @@ static bool isTemporaryPRValue(const CXXConstructExpr *E, SVal V) {
   return isa<CXXTempObjectRegion>(MR);
 }
 
+/// Get the values of the arguments of a call, if they are all concrete
+/// integers.
+static bool getConcreteArgs(const CallEvent &Call,
+                            SmallVectorImpl<llvm::APSInt> &Args) {
+  for (unsigned I = 0, E = Call.getNumArgs(); I != E; ++I) {
+    Optional<nonloc::ConcreteInt> CI =
+        Call.getArgSVal(I).getAs<nonloc::ConcreteInt>();
+    if (!CI)
+      return false;
+    Args.push_back(CI->getValue());
+  }
+  return true;
+}
+
 /// The call exit is simulated with a sequence of nodes, which occur between
 /// CallExitBegin and CallExitEnd. The following operations occur between the
 /// two program points:
@@ -262,6 +279,18 @@ void ExprEngine::processCallExit(ExplodedNode *CEBNode) {
       }
 
       state = state->BindExpr(CE, callerCtx, V);
+
+      // Remember the result for later calls with the same arguments.
+      if (AMgr.options.shouldSummarizePureFunctions()) {
+        if (Optional<nonloc::ConcreteInt> CI =
+                V.getAs<nonloc::ConcreteInt>()) {
+          SmallVector<llvm::APSInt, 4> Args;
+          const Decl *Callee = calleeCtx->getDecl();
+          if (maySummarizeCall(*Call, Callee) && getConcreteArgs(*Call, Args))
+            Engine.FunctionSummaries->addCallSummary(Callee, Args,
+                                                     CI->getValue());
+        }
+      }
     }
 
     // Bind the constructed object value to CXXConstructExpr.
@@ -456,6 +485,142 @@ bool ExprEngine::inlineCall(const CallEvent &Call, const Decl *D,
   return true;
 }
 
+static bool isSummarizableType(QualType T) {
+  return T->isIntegralOrEnumerationType();
+}
+
+/// Returns true if the statement only computes on integers held in local
+/// variables and parameters, and has no other effects.
+static bool isPureScalarStmt(const Stmt *S) {
+  if (!S)
+    return true;
+
+  if (const Expr *E = dyn_cast<Expr>(S))
+    if (!isSummarizableType(E->getType()))
+      return false;
+
+  switch (S->getStmtClass()) {
+  case Stmt::CompoundStmtClass:
+  case Stmt::NullStmtClass:
+  case Stmt::IfStmtClass:
+  case Stmt::WhileStmtClass:
+  case Stmt::DoStmtClass:
+  case Stmt::ForStmtClass:
+  case Stmt::SwitchStmtClass:
+  case Stmt::CaseStmtClass:
+  case Stmt::DefaultStmtClass:
+  case Stmt::BreakStmtClass:
+  case Stmt::ContinueStmtClass:
+  case Stmt::ReturnStmtClass:
+  case Stmt::LabelStmtClass:
+  case Stmt::GotoStmtClass:
+  case Stmt::AttributedStmtClass:
+  case Stmt::ParenExprClass:
+  case Stmt::IntegerLiteralClass:
+  case Stmt::CharacterLiteralClass:
+  case Stmt::CXXBoolLiteralExprClass:
+  case Stmt::ConditionalOperatorClass:
+  case Stmt::BinaryOperatorClass:
+  case Stmt::CompoundAssignOperatorClass:
+  case Stmt::ImplicitCastExprClass:
+  case Stmt::CStyleCastExprClass:
+  case Stmt::CXXStaticCastExprClass:
+    break;
+
+  case Stmt::UnaryExprOrTypeTraitExprClass:
+    // The argument of sizeof is not evaluated, unless it is a VLA.
+    return !cast<UnaryExprOrTypeTraitExpr>(S)
+                ->getTypeOfArgument()
+                ->isVariableArrayType();
+
+  case Stmt::UnaryOperatorClass: {
+    UnaryOperatorKind Op = cast<UnaryOperator>(S)->getOpcode();
+    if (Op == UO_Deref || Op == UO_AddrOf)
+      return false;
+    break;
+  }
+
+  case Stmt::DeclStmtClass:
+    for (const Decl *D : cast<DeclStmt>(S)->decls()) {
+      const VarDecl *VD = dyn_cast<VarDecl>(D);
+      if (!VD || !VD->hasLocalStorage() || !isSummarizableType(VD->getType()))
+        return false;
+      if (!isPureScalarStmt(VD->getInit()))
+        return false;
+    }
+    return true;
+
+  case Stmt::DeclRefExprClass: {
+    const ValueDecl *D = cast<DeclRefExpr>(S)->getDecl();
+    if (isa<EnumConstantDecl>(D))
+      return true;
+    const VarDecl *VD = dyn_cast<VarDecl>(D);
+    return VD && VD->hasLocalStorage();
+  }
+
+  default:
+    return false;
+  }
+
+  for (const Stmt *Child : S->children())
+    if (!isPureScalarStmt(Child))
+      return false;
+  return true;
+}
+
+bool ExprEngine::maySummarizeCall(const CallEvent &Call, const Decl *D) {
+  if (!isa<SimpleFunctionCall>(Call))
+    return false;
+
+  Optional<bool> MaySummarize = Engine.FunctionSummaries->maySummarize(D);
+  if (MaySummarize.hasValue())
+    return MaySummarize.getValue();
+
+  // Summaries are keyed on the concrete values of the arguments, and only
+  // hold the concrete return value, so the callee may not read or write
+  // anything but its scalar parameters and locals.
+  bool Result = false;
+  if (const FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+    Result = !FD->isVariadic() && isSummarizableType(FD->getReturnType());
+    for (const ParmVarDecl *P : FD->parameters())
+      Result = Result && isSummarizableType(P->getType());
+    const Stmt *Body = AMgr.getAnalysisDeclContext(D)->getBody();
+    Result = Result && Body && isPureScalarStmt(Body);
+  }
+  Engine.FunctionSummaries->markMaySummarize(D, Result);
+  return Result;
+}
+
+bool ExprEngine::applyCallSummary(const CallEvent &Call, const Decl *D,
+                                  NodeBuilder &Bldr, ExplodedNode *Pred,
+                                  ProgramStateRef State) {
+  if (!AMgr.options.shouldSummarizePureFunctions())
+    return false;
+
+  SmallVector<llvm::APSInt, 4> Args;
+  if (!maySummarizeCall(Call, D) || !getConcreteArgs(Call, Args))
+    return false;
+
+  const llvm::APSInt *Result =
+      Engine.FunctionSummaries->findCallSummary(D, Args);
+  if (!Result)
+    return false;
+
+  // The callee has no effects besides its return value, so there is nothing
+  // to invalidate.
+  State = State->BindExpr(Call.getOriginExpr(), Pred->getLocationContext(),
+                          svalBuilder.makeIntVal(*Result));
+  Bldr.generateNode(Call.getProgramPoint(), State, Pred);
+
+  NumSummarizedCalls++;
+
+  // Mark the decl as visited, as if it was inlined.
+  if (VisitedCallees)
+    VisitedCallees->insert(D);
+
+  return true;
+}
+
 static ProgramStateRef getInlineFailedState(ProgramStateRef State,
                                             const Stmt *CallE) {
   const void *ReplayState = State->get<ReplayWithoutInlining>();
@@ -911,6 +1076,10 @@ void ExprEngine::defaultEvalCall(NodeBuilder &Bldr, ExplodedNode *Pred,
     RuntimeDefinition RD = Call->getRuntimeDefinition();
     const Decl *D = RD.getDecl();
     if (shouldInlineCall(*Call, D, Pred)) {
+      // Reuse the result of an earlier inlining of the callee, if possible.
+      if (applyCallSummary(*Call, D, Bldr, Pred, State))
+        return;
+
       if (RD.mayHaveOtherDefinitions()) {
         AnalyzerOptions &Options = getAnalysisManager().options;
 
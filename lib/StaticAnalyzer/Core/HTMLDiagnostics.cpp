@@ -45,6 +45,9 @@ class HTMLDiagnostics : public PathDiagnosticConsumer {
   const Preprocessor &PP;
   AnalyzerOptions &AnalyzerOpts;
   const bool SupportsCrossFileDiagnostics;
+  /// The syntax and macro highlighting of the files already rendered, which
+  /// is the same in every report.
+  html::RelexRewriteCache RewriteCache;
 public:
   HTMLDiagnostics(AnalyzerOptions &AnalyzerOpts,
                   const std::string& prefix,
@@ -475,8 +478,8 @@ void HTMLDiagnostics::RewriteFile(Rewriter &R, const SourceManager& SMgr,
   // We might not have a preprocessor if we come from a deserialized AST file,
   // for example.
 
-  html::SyntaxHighlight(R, FID, PP);
-  html::HighlightMacros(R, FID, PP);
+  html::SyntaxHighlight(R, FID, PP, &RewriteCache);
+  html::HighlightMacros(R, FID, PP, &RewriteCache);
 }
 
 void HTMLDiagnostics::HandlePiece(Rewriter& R, FileID BugFileID,
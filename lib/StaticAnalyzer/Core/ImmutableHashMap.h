@@ -0,0 +1,464 @@
+//== ImmutableHashMap.h - Hash-consed persistent hash map -------*- C++ -*--==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines ImmutableHashMap, a persistent map implemented as a
+//  hash array mapped trie whose nodes are uniqued by their factory. It is an
+//  alternative to llvm::ImmutableMap for the bindings of RegionStore.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_STATICANALYZER_CORE_IMMUTABLEHASHMAP_H
+#define LLVM_CLANG_LIB_STATICANALYZER_CORE_IMMUTABLEHASHMAP_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/TrailingObjects.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace clang {
+
+namespace ento {
+
+/// \brief A persistent map from keys to data, stored as a hash array mapped
+/// trie.
+///
+/// Each level of the trie consumes five bits of the hash of a key, so that
+/// lookups and updates visit at most seven nodes, however large the map is.
+/// An update copies the nodes on the path to the updated key and shares all
+/// other nodes with the original map. Keys whose hashes are equal are kept
+/// in a collision node below the last level, sorted by key.
+///
+/// The shape of the trie only depends on the keys that it holds: an entry is
+/// only pushed into a child node when another key shares its hash prefix, and
+/// a child that is left with a single entry is folded back into its parent.
+/// The factory uniques the nodes, so two maps with the same bindings share
+/// their root, and maps are compared and profiled by pointer.
+///
+/// Nodes are allocated in the factory's allocator and are never freed.
+template <typename KeyT, typename DataT> class ImmutableHashMap {
+public:
+  typedef KeyT key_type;
+  typedef const KeyT &key_type_ref;
+  typedef DataT data_type;
+  typedef const DataT &data_type_ref;
+  typedef std::pair<KeyT, DataT> value_type;
+
+  class Node final
+      : public llvm::FoldingSetNode,
+        private llvm::TrailingObjects<Node, value_type, const Node *> {
+    typedef llvm::TrailingObjects<Node, value_type, const Node *>
+        TrailingObjectsTy;
+    friend TrailingObjectsTy;
+
+    /// The slots of the node that hold an entry, and those that hold a child
+    /// node, indexed by a chunk of the hash of the keys. Both are zero in a
+    /// collision node.
+    uint32_t DataMap, NodeMap;
+    unsigned NumEntries, NumChildren;
+
+    size_t numTrailingObjects(
+        typename TrailingObjectsTy::template OverloadToken<value_type>) const {
+      return NumEntries;
+    }
+
+    Node(uint32_t DataMap, uint32_t NodeMap, ArrayRef<value_type> Entries,
+         ArrayRef<const Node *> Children)
+        : DataMap(DataMap), NodeMap(NodeMap), NumEntries(Entries.size()),
+          NumChildren(Children.size()) {
+      std::uninitialized_copy(Entries.begin(), Entries.end(),
+                              this->template getTrailingObjects<value_type>());
+      std::uninitialized_copy(
+          Children.begin(), Children.end(),
+          this->template getTrailingObjects<const Node *>());
+    }
+
+  public:
+    static Node *Create(llvm::BumpPtrAllocator &Alloc, uint32_t DataMap,
+                        uint32_t NodeMap, ArrayRef<value_type> Entries,
+                        ArrayRef<const Node *> Children) {
+      void *Mem = Alloc.Allocate(
+          Node::template totalSizeToAlloc<value_type, const Node *>(
+              Entries.size(), Children.size()),
+          alignof(Node));
+      return new (Mem) Node(DataMap, NodeMap, Entries, Children);
+    }
+
+    uint32_t getDataMap() const { return DataMap; }
+    uint32_t getNodeMap() const { return NodeMap; }
+    bool isCollision() const { return !DataMap && !NodeMap; }
+
+    ArrayRef<value_type> getEntries() const {
+      return llvm::makeArrayRef(
+          this->template getTrailingObjects<value_type>(), NumEntries);
+    }
+    ArrayRef<const Node *> getChildren() const {
+      return llvm::makeArrayRef(
+          this->template getTrailingObjects<const Node *>(), NumChildren);
+    }
+
+    /// Get the index of the entry for slot \p Bit.
+    unsigned getEntryIndex(uint32_t Bit) const {
+      return llvm::countPopulation(DataMap & (Bit - 1));
+    }
+    /// Get the index of the child for slot \p Bit.
+    unsigned getChildIndex(uint32_t Bit) const {
+      return llvm::countPopulation(NodeMap & (Bit - 1));
+    }
+
+    static void Profile(llvm::FoldingSetNodeID &ID, uint32_t DataMap,
+                        uint32_t NodeMap, ArrayRef<value_type> Entries,
+                        ArrayRef<const Node *> Children) {
+      ID.AddInteger(DataMap);
+      ID.AddInteger(NodeMap);
+      for (const value_type &E : Entries) {
+        llvm::ImutProfileInfo<KeyT>::Profile(ID, E.first);
+        llvm::ImutProfileInfo<DataT>::Profile(ID, E.second);
+      }
+      for (const Node *Child : Children)
+        ID.AddPointer(Child);
+    }
+    void Profile(llvm::FoldingSetNodeID &ID) const {
+      Profile(ID, DataMap, NodeMap, getEntries(), getChildren());
+    }
+  };
+
+  /// Iterates over the entries of a map, in the order of the hashes of their
+  /// keys.
+  class iterator {
+    /// The nodes on the path to the current entry. Each of them is paired
+    /// with the index of its next slot, where the entries of a node come
+    /// before its children.
+    SmallVector<std::pair<const Node *, unsigned>, 8> Path;
+
+    /// Move to the first entry at or after the current slot.
+    void settle() {
+      while (!Path.empty()) {
+        const Node *N = Path.back().first;
+        unsigned Slot = Path.back().second;
+        unsigned NumEntries = N->getEntries().size();
+        if (Slot < NumEntries)
+          return;
+        if (Slot < NumEntries + N->getChildren().size()) {
+          ++Path.back().second;
+          Path.push_back(std::make_pair(N->getChildren()[Slot - NumEntries], 0));
+          continue;
+        }
+        Path.pop_back();
+      }
+    }
+
+  public:
+    iterator() = default;
+    explicit iterator(const Node *Root) {
+      if (Root) {
+        Path.push_back(std::make_pair(Root, 0));
+        settle();
+      }
+    }
+
+    const value_type &operator*() const {
+      return Path.back().first->getEntries()[Path.back().second];
+    }
+    const value_type *operator->() const { return &**this; }
+
+    key_type_ref getKey() const { return (**this).first; }
+    data_type_ref getData() const { return (**this).second; }
+
+    iterator &operator++() {
+      ++Path.back().second;
+      settle();
+      return *this;
+    }
+
+    bool operator==(const iterator &X) const { return Path == X.Path; }
+    bool operator!=(const iterator &X) const { return !(*this == X); }
+  };
+
+  class Factory {
+    llvm::BumpPtrAllocator &Alloc;
+    llvm::FoldingSet<Node> Nodes;
+
+    const Node *getNode(uint32_t DataMap, uint32_t NodeMap,
+                        ArrayRef<value_type> Entries,
+                        ArrayRef<const Node *> Children) {
+      llvm::FoldingSetNodeID ID;
+      Node::Profile(ID, DataMap, NodeMap, Entries, Children);
+      void *InsertPos;
+      if (Node *N = Nodes.FindNodeOrInsertPos(ID, InsertPos))
+        return N;
+
+      Node *N = Node::Create(Alloc, DataMap, NodeMap, Entries, Children);
+      Nodes.InsertNode(N, InsertPos);
+      return N;
+    }
+
+    const Node *getCollisionNode(ArrayRef<value_type> Entries) {
+      return getNode(0, 0, Entries, None);
+    }
+
+    /// Get the node that holds two entries whose keys share the hash prefix
+    /// of the parent of the node.
+    const Node *merge(const value_type &A, unsigned HashA, const value_type &B,
+                      unsigned HashB, unsigned Shift) {
+      if (Shift >= HashBits) {
+        if (llvm::ImutContainerInfo<KeyT>::isLess(B.first, A.first))
+          return getCollisionNode({B, A});
+        return getCollisionNode({A, B});
+      }
+
+      uint32_t BitA = getBit(HashA, Shift), BitB = getBit(HashB, Shift);
+      if (BitA == BitB)
+        return getNode(0, BitA, None,
+                       merge(A, HashA, B, HashB, Shift + BitsPerLevel));
+      if (BitA < BitB)
+        return getNode(BitA | BitB, 0, {A, B}, None);
+      return getNode(BitA | BitB, 0, {B, A}, None);
+    }
+
+    const Node *add(const Node *N, const value_type &V, unsigned Hash,
+                    unsigned Shift) {
+      if (!N)
+        return getNode(getBit(Hash, Shift), 0, V, None);
+
+      ArrayRef<value_type> Entries = N->getEntries();
+      ArrayRef<const Node *> Children = N->getChildren();
+
+      if (N->isCollision()) {
+        SmallVector<value_type, 4> NewEntries(Entries.begin(), Entries.end());
+        auto I = std::lower_bound(NewEntries.begin(), NewEntries.end(), V,
+                                  [](const value_type &L, const value_type &R) {
+                                    return llvm::ImutContainerInfo<
+                                        KeyT>::isLess(L.first, R.first);
+                                  });
+        if (I != NewEntries.end() && I->first == V.first) {
+          if (I->second == V.second)
+            return N;
+          I->second = V.second;
+        } else {
+          NewEntries.insert(I, V);
+        }
+        return getCollisionNode(NewEntries);
+      }
+
+      uint32_t Bit = getBit(Hash, Shift);
+      if (N->getDataMap() & Bit) {
+        unsigned Idx = N->getEntryIndex(Bit);
+        const value_type &Old = Entries[Idx];
+        SmallVector<value_type, 8> NewEntries(Entries.begin(), Entries.end());
+        if (Old.first == V.first) {
+          if (Old.second == V.second)
+            return N;
+          NewEntries[Idx].second = V.second;
+          return getNode(N->getDataMap(), N->getNodeMap(), NewEntries,
+                         Children);
+        }
+
+        // Another key shares this slot; push both entries into a child.
+        const Node *Child = merge(Old, getHash(Old.first), V, Hash,
+                                  Shift + BitsPerLevel);
+        NewEntries.erase(NewEntries.begin() + Idx);
+        SmallVector<const Node *, 8> NewChildren(Children.begin(),
+                                                 Children.end());
+        NewChildren.insert(NewChildren.begin() + N->getChildIndex(Bit), Child);
+        return getNode(N->getDataMap() & ~Bit, N->getNodeMap() | Bit,
+                       NewEntries, NewChildren);
+      }
+
+      if (N->getNodeMap() & Bit) {
+        unsigned Idx = N->getChildIndex(Bit);
+        const Node *NewChild = add(Children[Idx], V, Hash, Shift + BitsPerLevel);
+        if (NewChild == Children[Idx])
+          return N;
+        SmallVector<const Node *, 8> NewChildren(Children.begin(),
+                                                 Children.end());
+        NewChildren[Idx] = NewChild;
+        return getNode(N->getDataMap(), N->getNodeMap(), Entries, NewChildren);
+      }
+
+      SmallVector<value_type, 8> NewEntries(Entries.begin(), Entries.end());
+      NewEntries.insert(NewEntries.begin() + N->getEntryIndex(Bit), V);
+      return getNode(N->getDataMap() | Bit, N->getNodeMap(), NewEntries,
+                     Children);
+    }
+
+    /// Remove the entry for \p K from the subtree rooted at \p N.
+    ///
+    /// If a node other than the root would be left with a single entry and no
+    /// children, that entry is returned in \p Single instead, so that the
+    /// parent holds it directly.
+    const Node *remove(const Node *N, key_type_ref K, unsigned Hash,
+                       unsigned Shift, const value_type *&Single) {
+      Single = nullptr;
+      ArrayRef<value_type> Entries = N->getEntries();
+      ArrayRef<const Node *> Children = N->getChildren();
+
+      if (N->isCollision()) {
+        auto I = llvm::find_if(
+            Entries, [&](const value_type &E) { return E.first == K; });
+        if (I == Entries.end())
+          return N;
+        if (Entries.size() == 2) {
+          Single = &Entries[I == Entries.begin() ? 1 : 0];
+          return nullptr;
+        }
+        SmallVector<value_type, 4> NewEntries(Entries.begin(), I);
+        NewEntries.append(std::next(I), Entries.end());
+        return getCollisionNode(NewEntries);
+      }
+
+      uint32_t Bit = getBit(Hash, Shift);
+      if (N->getDataMap() & Bit) {
+        unsigned Idx = N->getEntryIndex(Bit);
+        if (!(Entries[Idx].first == K))
+          return N;
+        if (Children.empty()) {
+          if (Entries.size() == 1)
+            return nullptr;
+          if (Entries.size() == 2 && Shift) {
+            Single = &Entries[1 - Idx];
+            return nullptr;
+          }
+        }
+        SmallVector<value_type, 8> NewEntries(Entries.begin(), Entries.end());
+        NewEntries.erase(NewEntries.begin() + Idx);
+        return getNode(N->getDataMap() & ~Bit, N->getNodeMap(), NewEntries,
+                       Children);
+      }
+
+      if (N->getNodeMap() & Bit) {
+        unsigned Idx = N->getChildIndex(Bit);
+        const value_type *ChildSingle;
+        const Node *NewChild =
+            remove(Children[Idx], K, Hash, Shift + BitsPerLevel, ChildSingle);
+        if (NewChild == Children[Idx])
+          return N;
+
+        SmallVector<const Node *, 8> NewChildren(Children.begin(),
+                                                 Children.end());
+        if (NewChild) {
+          NewChildren[Idx] = NewChild;
+          return getNode(N->getDataMap(), N->getNodeMap(), Entries,
+                         NewChildren);
+        }
+
+        // The child was left with a single entry, which moves up into this
+        // node.
+        assert(ChildSingle && "Nodes below the root hold two entries");
+        if (Entries.empty() && Children.size() == 1 && Shift) {
+          Single = ChildSingle;
+          return nullptr;
+        }
+        NewChildren.erase(NewChildren.begin() + Idx);
+        SmallVector<value_type, 8> NewEntries(Entries.begin(), Entries.end());
+        NewEntries.insert(NewEntries.begin() + N->getEntryIndex(Bit),
+                          *ChildSingle);
+        return getNode(N->getDataMap() | Bit, N->getNodeMap() & ~Bit,
+                       NewEntries, NewChildren);
+      }
+
+      return N;
+    }
+
+  public:
+    explicit Factory(llvm::BumpPtrAllocator &Alloc) : Alloc(Alloc) {}
+
+    Factory(const Factory &) = delete;
+    Factory &operator=(const Factory &) = delete;
+
+    ImmutableHashMap getEmptyMap() const { return ImmutableHashMap(); }
+
+    ImmutableHashMap add(ImmutableHashMap Old, key_type_ref K,
+                         data_type_ref D) {
+      return ImmutableHashMap(add(Old.Root, value_type(K, D), getHash(K), 0));
+    }
+
+    ImmutableHashMap remove(ImmutableHashMap Old, key_type_ref K) {
+      if (!Old.Root)
+        return Old;
+      const value_type *Single;
+      return ImmutableHashMap(remove(Old.Root, K, getHash(K), 0, Single));
+    }
+  };
+
+private:
+  enum : unsigned { BitsPerLevel = 5, HashBits = 32 };
+
+  const Node *Root;
+
+  static unsigned getHash(key_type_ref K) {
+    llvm::FoldingSetNodeID ID;
+    llvm::ImutProfileInfo<KeyT>::Profile(ID, K);
+    return ID.ComputeHash();
+  }
+
+  /// Get the slot of a node at depth \p Shift / BitsPerLevel for \p Hash.
+  static uint32_t getBit(unsigned Hash, unsigned Shift) {
+    return uint32_t(1) << ((Hash >> Shift) & ((1u << BitsPerLevel) - 1));
+  }
+
+public:
+  explicit ImmutableHashMap(const Node *Root = nullptr) : Root(Root) {}
+
+  bool isEmpty() const { return !Root; }
+
+  const DataT *lookup(key_type_ref K) const {
+    unsigned Hash = getHash(K);
+    unsigned Shift = 0;
+    for (const Node *N = Root; N; Shift += BitsPerLevel) {
+      ArrayRef<value_type> Entries = N->getEntries();
+      if (N->isCollision()) {
+        for (const value_type &E : Entries)
+          if (E.first == K)
+            return &E.second;
+        return nullptr;
+      }
+
+      uint32_t Bit = getBit(Hash, Shift);
+      if (N->getDataMap() & Bit) {
+        const value_type &E = Entries[N->getEntryIndex(Bit)];
+        return E.first == K ? &E.second : nullptr;
+      }
+      if (!(N->getNodeMap() & Bit))
+        return nullptr;
+      N = N->getChildren()[N->getChildIndex(Bit)];
+    }
+    return nullptr;
+  }
+
+  bool contains(key_type_ref K) const { return lookup(K) != nullptr; }
+
+  iterator begin() const { return iterator(Root); }
+  iterator end() const { return iterator(); }
+
+  const Node *getRoot() const { return Root; }
+
+  bool operator==(const ImmutableHashMap &RHS) const {
+    return Root == RHS.Root;
+  }
+  bool operator!=(const ImmutableHashMap &RHS) const {
+    return Root != RHS.Root;
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const { ID.AddPointer(Root); }
+};
+
+} // end namespace ento
+
+} // end namespace clang
+
+#endif
@@ -17,8 +17,11 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
 #include "llvm/ADT/FoldingSet.h"
-#include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/TrailingObjects.h"
 #include "llvm/Support/raw_ostream.h"
+#include <memory>
 
 using namespace clang;
 using namespace ento;
@@ -48,66 +51,167 @@ public:
   }
 };
 
-class RangeTrait : public llvm::ImutContainerInfo<Range> {
-public:
-  // When comparing if one Range is less than another, we should compare
-  // the actual APSInt values instead of their pointers.  This keeps the order
-  // consistent (instead of comparing by pointer values) and can potentially
-  // be used to speed up some of the operations in RangeSet.
-  static inline bool isLess(key_type_ref lhs, key_type_ref rhs) {
-    return *lhs.first < *rhs.first ||
-           (!(*rhs.first < *lhs.first) && *lhs.second < *rhs.second);
-  }
-};
-
-/// RangeSet contains a set of ranges. If the set is empty, then
-///  there the value of a symbol is overly constrained and there are no
-///  possible values for that symbol.
+/// RangeSet contains a set of ranges, sorted by their lower bounds. If the set
+///  is empty, then there the value of a symbol is overly constrained and there
+///  are no possible values for that symbol.
+///
+/// Almost all sets hold one to three ranges, so they are stored as a single
+/// array that trails a node owned by the Factory, rather than as a balanced
+/// tree. The factory uniques the nodes, so that RangeSets are compared and
+/// profiled by pointer.
 class RangeSet {
-  typedef llvm::ImmutableSet<Range, RangeTrait> PrimRangeSet;
-  PrimRangeSet ranges; // no need to make const, since it is an
-                       // ImmutableSet - this allows default operator=
-                       // to work.
+  class Storage final : public llvm::FoldingSetNode,
+                        private llvm::TrailingObjects<Storage, Range> {
+    friend TrailingObjects;
+
+    unsigned NumRanges;
+
+    explicit Storage(ArrayRef<Range> Ranges) : NumRanges(Ranges.size()) {
+      std::uninitialized_copy(Ranges.begin(), Ranges.end(),
+                              getTrailingObjects<Range>());
+    }
+
+  public:
+    static Storage *Create(llvm::BumpPtrAllocator &Alloc,
+                           ArrayRef<Range> Ranges) {
+      void *Mem = Alloc.Allocate(totalSizeToAlloc<Range>(Ranges.size()),
+                                 alignof(Storage));
+      return new (Mem) Storage(Ranges);
+    }
+
+    ArrayRef<Range> getRanges() const {
+      return llvm::makeArrayRef(getTrailingObjects<Range>(), NumRanges);
+    }
+
+    static void Profile(llvm::FoldingSetNodeID &ID, ArrayRef<Range> Ranges) {
+      for (const Range &R : Ranges)
+        R.Profile(ID);
+    }
+    void Profile(llvm::FoldingSetNodeID &ID) const {
+      Profile(ID, getRanges());
+    }
+  };
+
+  /// The ranges of the set, or null if it is empty.
+  const Storage *Impl;
+
+  explicit RangeSet(const Storage *Impl) : Impl(Impl) {}
+
 public:
-  typedef PrimRangeSet::Factory Factory;
-  typedef PrimRangeSet::iterator iterator;
+  /// Creates RangeSets and owns their storage, which lives as long as the
+  /// factory.
+  class Factory {
+    llvm::BumpPtrAllocator Alloc;
+    llvm::FoldingSet<Storage> Sets;
+
+  public:
+    Factory() = default;
+    Factory(const Factory &) = delete;
+    Factory &operator=(const Factory &) = delete;
+
+    RangeSet getEmptySet() { return RangeSet(nullptr); }
+
+    /// Get the set of the given ranges, which must be sorted by their lower
+    /// bounds.
+    RangeSet getSet(ArrayRef<Range> Ranges) {
+      if (Ranges.empty())
+        return getEmptySet();
+
+      llvm::FoldingSetNodeID ID;
+      Storage::Profile(ID, Ranges);
+      void *InsertPos;
+      if (Storage *S = Sets.FindNodeOrInsertPos(ID, InsertPos))
+        return RangeSet(S);
+
+      Storage *S = Storage::Create(Alloc, Ranges);
+      Sets.InsertNode(S, InsertPos);
+      return RangeSet(S);
+    }
+  };
 
-  RangeSet(PrimRangeSet RS) : ranges(RS) {}
+  typedef const Range *iterator;
 
   /// Create a new set with all ranges of this set and RS.
   /// Possible intersections are not checked here.
   RangeSet addRange(Factory &F, const RangeSet &RS) {
-    PrimRangeSet Ranges(RS.ranges);
-    for (const auto &range : ranges)
-      Ranges = F.add(Ranges, range);
-    return RangeSet(Ranges);
+    if (isEmpty() || RS == *this)
+      return RS;
+    if (RS.isEmpty())
+      return *this;
+
+    SmallVector<Range, 4> Ranges;
+    iterator I = begin(), E = end(), J = RS.begin(), JE = RS.end();
+    while (I != E && J != JE) {
+      if (*I == *J) {
+        Ranges.push_back(*I++);
+        ++J;
+      } else if (isLess(*J, *I))
+        Ranges.push_back(*J++);
+      else
+        Ranges.push_back(*I++);
+    }
+    Ranges.append(I, E);
+    Ranges.append(J, JE);
+    return F.getSet(Ranges);
   }
 
-  iterator begin() const { return ranges.begin(); }
-  iterator end() const { return ranges.end(); }
+  iterator begin() const {
+    return Impl ? Impl->getRanges().begin() : nullptr;
+  }
+  iterator end() const { return Impl ? Impl->getRanges().end() : nullptr; }
 
-  bool isEmpty() const { return ranges.isEmpty(); }
+  bool isEmpty() const { return !Impl; }
 
   /// Construct a new RangeSet representing '{ [from, to] }'.
   RangeSet(Factory &F, const llvm::APSInt &from, const llvm::APSInt &to)
-      : ranges(F.add(F.getEmptySet(), Range(from, to))) {}
+      : RangeSet(F.getSet(Range(from, to))) {}
 
   /// Profile - Generates a hash profile of this RangeSet for use
   ///  by FoldingSet.
-  void Profile(llvm::FoldingSetNodeID &ID) const { ranges.Profile(ID); }
+  void Profile(llvm::FoldingSetNodeID &ID) const { ID.AddPointer(Impl); }
 
   /// getConcreteValue - If a symbol is contrained to equal a specific integer
   ///  constant then this method returns that value.  Otherwise, it returns
   ///  NULL.
   const llvm::APSInt *getConcreteValue() const {
-    return ranges.isSingleton() ? ranges.begin()->getConcreteValue() : nullptr;
+    return Impl && Impl->getRanges().size() == 1
+               ? begin()->getConcreteValue()
+               : nullptr;
+  }
+
+  /// Returns true if \p V, converted to the type of the values in the set, is
+  /// one of them.
+  bool contains(llvm::APSInt V) const {
+    if (isEmpty())
+      return false;
+
+    APSIntType Type(getMinValue());
+    if (Type.testInRange(V, true) != APSIntType::RTR_Within)
+      return false;
+    Type.apply(V);
+
+    for (const Range &R : *this) {
+      if (V < R.From())
+        break;
+      if (V <= R.To())
+        return true;
+    }
+    return false;
   }
 
 private:
-  void IntersectInRange(BasicValueFactory &BV, Factory &F,
-                        const llvm::APSInt &Lower, const llvm::APSInt &Upper,
-                        PrimRangeSet &newRanges, PrimRangeSet::iterator &i,
-                        PrimRangeSet::iterator &e) const {
+  /// When comparing if one Range is less than another, we should compare
+  /// the actual APSInt values instead of their pointers.  This keeps the
+  /// order consistent (instead of comparing by pointer values).
+  static bool isLess(const Range &lhs, const Range &rhs) {
+    return lhs.From() < rhs.From() ||
+           (!(rhs.From() < lhs.From()) && lhs.To() < rhs.To());
+  }
+
+  void IntersectInRange(BasicValueFactory &BV, const llvm::APSInt &Lower,
+                        const llvm::APSInt &Upper,
+                        SmallVectorImpl<Range> &newRanges, iterator &i,
+                        iterator e) const {
     // There are six cases for each range R in the set:
     //   1. R is entirely before the intersection range.
     //   2. R is entirely after the intersection range.
@@ -126,24 +230,23 @@ private:
 
       if (i->Includes(Lower)) {
         if (i->Includes(Upper)) {
-          newRanges =
-              F.add(newRanges, Range(BV.getValue(Lower), BV.getValue(Upper)));
+          newRanges.push_back(Range(BV.getValue(Lower), BV.getValue(Upper)));
           break;
         } else
-          newRanges = F.add(newRanges, Range(BV.getValue(Lower), i->To()));
+          newRanges.push_back(Range(BV.getValue(Lower), i->To()));
       } else {
         if (i->Includes(Upper)) {
-          newRanges = F.add(newRanges, Range(i->From(), BV.getValue(Upper)));
+          newRanges.push_back(Range(i->From(), BV.getValue(Upper)));
           break;
         } else
-          newRanges = F.add(newRanges, *i);
+          newRanges.push_back(*i);
       }
     }
   }
 
   const llvm::APSInt &getMinValue() const {
     assert(!isEmpty());
-    return ranges.begin()->From();
+    return begin()->From();
   }
 
   bool pin(llvm::APSInt &Lower, llvm::APSInt &Upper) const {
@@ -240,20 +343,24 @@ public:
     if (!pin(Lower, Upper))
       return F.getEmptySet();
 
-    PrimRangeSet newRanges = F.getEmptySet();
+    SmallVector<Range, 4> newRanges;
 
-    PrimRangeSet::iterator i = begin(), e = end();
+    iterator i = begin(), e = end();
     if (Lower <= Upper)
-      IntersectInRange(BV, F, Lower, Upper, newRanges, i, e);
+      IntersectInRange(BV, Lower, Upper, newRanges, i, e);
     else {
       // The order of the next two statements is important!
       // IntersectInRange() does not reset the iteration state for i and e.
       // Therefore, the lower range most be handled first.
-      IntersectInRange(BV, F, BV.getMinValue(Upper), Upper, newRanges, i, e);
-      IntersectInRange(BV, F, Lower, BV.getMaxValue(Lower), newRanges, i, e);
+      IntersectInRange(BV, BV.getMinValue(Upper), Upper, newRanges, i, e);
+      IntersectInRange(BV, Lower, BV.getMaxValue(Lower), newRanges, i, e);
     }
 
-    return newRanges;
+    // Most assumptions do not narrow the set; keep it rather than looking
+    // the same ranges up again.
+    if (ArrayRef<Range>(newRanges) == ArrayRef<Range>(begin(), end()))
+      return *this;
+    return F.getSet(newRanges);
   }
 
   void print(raw_ostream &os) const {
@@ -271,9 +378,7 @@ public:
     os << " }";
   }
 
-  bool operator==(const RangeSet &other) const {
-    return ranges == other.ranges;
-  }
+  bool operator==(const RangeSet &other) const { return Impl == other.Impl; }
 };
 } // end anonymous namespace
 
@@ -422,12 +527,11 @@ ConditionTruthVal RangeConstraintManager::checkNull(ProgramStateRef State,
   if (const llvm::APSInt *Value = Ranges->getConcreteValue())
     return *Value == 0;
 
-  BasicValueFactory &BV = getBasicVals();
-  APSIntType IntType = BV.getAPSIntType(Sym->getType());
+  APSIntType IntType = getBasicVals().getAPSIntType(Sym->getType());
   llvm::APSInt Zero = IntType.getZeroValue();
 
   // Check if zero is in the set of possible values.
-  if (Ranges->Intersect(BV, F, Zero, Zero).isEmpty())
+  if (!Ranges->contains(Zero))
     return false;
 
   // Zero is a possible value, but it is not the /only/ possible value.
@@ -15,6 +15,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "ImmutableHashMap.h"
 #include "clang/AST/Attr.h"
 #include "clang/AST/CharUnits.h"
 #include "clang/Analysis/Analyses/LiveVariables.h"
@@ -28,12 +29,20 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/SubEngine.h"
 #include "llvm/ADT/ImmutableMap.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/raw_ostream.h"
 #include <utility>
 
 using namespace clang;
 using namespace ento;
 
+#define DEBUG_TYPE "RegionStore"
+
+STATISTIC(NumBindingMapUpdates,
+          "The # of updates to the binding maps of stores");
+STATISTIC(NumBindingMapBytes,
+          "The # of bytes allocated by updates to the binding maps of stores");
+
 //===----------------------------------------------------------------------===//
 // Representation of binding keys.
 //===----------------------------------------------------------------------===//
@@ -136,34 +145,337 @@ namespace llvm {
 
 LLVM_DUMP_METHOD void BindingKey::dump() const { llvm::errs() << *this; }
 
+//===----------------------------------------------------------------------===//
+// Representation of binding maps.
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// Counts an update to a binding map and the memory that it allocates.
+class BindingMapUpdate {
+  const llvm::BumpPtrAllocator &Alloc;
+  size_t StartBytes;
+
+public:
+  explicit BindingMapUpdate(const llvm::BumpPtrAllocator &Alloc)
+      : Alloc(Alloc), StartBytes(Alloc.getBytesAllocated()) {
+    ++NumBindingMapUpdates;
+  }
+  ~BindingMapUpdate() {
+    NumBindingMapBytes += Alloc.getBytesAllocated() - StartBytes;
+  }
+};
+
+template <typename KeyT, typename DataT> class BindingMapRef;
+
+/// A map in the bindings of a store.
+///
+/// Depending on the store model, the map is either an llvm::ImmutableMap,
+/// which is an AVL tree, or an ImmutableHashMap. The map only holds its root,
+/// tagged with the kind of map it belongs to, so that the clusters of the
+/// default store are no larger than llvm::ImmutableMaps. Tree roots are
+/// reference counted like in llvm::ImmutableMap.
+template <typename KeyT, typename DataT> class BindingMap {
+public:
+  typedef llvm::ImmutableMap<KeyT, DataT> TreeMapTy;
+  typedef typename TreeMapTy::TreeTy TreeTy;
+  typedef ImmutableHashMap<KeyT, DataT> HashMapTy;
+  typedef typename HashMapTy::Node HashNodeTy;
+  typedef const KeyT &key_type_ref;
+  typedef const DataT &data_type_ref;
+  typedef std::pair<KeyT, DataT> value_type;
+
+private:
+  friend class BindingMapRef<KeyT, DataT>;
+
+  /// The root of the map, which is a trie node if the flag is set and an
+  /// AVL tree node otherwise.
+  llvm::PointerIntPair<const void *, 1, bool> Root;
+
+  BindingMap(const void *R, bool Hashed) : Root(R, Hashed) { retain(); }
+
+  TreeTy *getTree() const {
+    if (Root.getInt())
+      return nullptr;
+    return static_cast<TreeTy *>(const_cast<void *>(Root.getPointer()));
+  }
+
+  HashMapTy getHashMap() const {
+    if (!Root.getInt())
+      return HashMapTy();
+    return HashMapTy(static_cast<const HashNodeTy *>(Root.getPointer()));
+  }
+
+  void retain() const {
+    if (TreeTy *T = getTree())
+      T->retain();
+  }
+
+  void release() const {
+    if (TreeTy *T = getTree())
+      T->release();
+  }
+
+public:
+  BindingMap(const BindingMap &X) : Root(X.Root) { retain(); }
+
+  BindingMap &operator=(const BindingMap &X) {
+    if (Root != X.Root) {
+      X.retain();
+      release();
+      Root = X.Root;
+    }
+    return *this;
+  }
+
+  ~BindingMap() { release(); }
+
+  class iterator {
+    typename TreeTy::iterator TreeI;
+    typename HashMapTy::iterator HashI;
+    bool Hashed;
+
+  public:
+    explicit iterator(const TreeTy *Root) : TreeI(Root), Hashed(false) {}
+    explicit iterator(typename HashMapTy::iterator HashI)
+        : HashI(HashI), Hashed(true) {}
+
+    const value_type &operator*() const {
+      return Hashed ? *HashI : TreeI->getValue();
+    }
+    const value_type *operator->() const { return &**this; }
+
+    key_type_ref getKey() const { return (**this).first; }
+    data_type_ref getData() const { return (**this).second; }
+
+    iterator &operator++() {
+      if (Hashed)
+        ++HashI;
+      else
+        ++TreeI;
+      return *this;
+    }
+
+    bool operator==(const iterator &X) const {
+      return Hashed ? HashI == X.HashI : TreeI == X.TreeI;
+    }
+    bool operator!=(const iterator &X) const { return !(*this == X); }
+  };
+
+  class Factory {
+    friend class BindingMapRef<KeyT, DataT>;
+
+    llvm::BumpPtrAllocator &Alloc;
+    typename TreeMapTy::Factory TreeF;
+    typename HashMapTy::Factory HashF;
+    const bool Hashed;
+
+  public:
+    Factory(llvm::BumpPtrAllocator &Alloc, bool Hashed)
+        : Alloc(Alloc), TreeF(Alloc), HashF(Alloc), Hashed(Hashed) {}
+
+    bool isHashed() const { return Hashed; }
+
+    BindingMap getEmptyMap() { return BindingMap(nullptr, Hashed); }
+
+    /// Get the map whose root was returned by getRootWithoutRetain().
+    BindingMap getMap(const void *Root) { return BindingMap(Root, Hashed); }
+
+    BindingMap add(const BindingMap &Old, key_type_ref K, data_type_ref D) {
+      BindingMapUpdate Update(Alloc);
+      if (Hashed)
+        return BindingMap(HashF.add(Old.getHashMap(), K, D).getRoot(), true);
+      return BindingMap(
+          TreeF.add(TreeMapTy(Old.getTree()), K, D).getRootWithoutRetain(),
+          false);
+    }
+
+    BindingMap remove(const BindingMap &Old, key_type_ref K) {
+      BindingMapUpdate Update(Alloc);
+      if (Hashed)
+        return BindingMap(HashF.remove(Old.getHashMap(), K).getRoot(), true);
+      return BindingMap(
+          TreeF.remove(TreeMapTy(Old.getTree()), K).getRootWithoutRetain(),
+          false);
+    }
+  };
+
+  bool isEmpty() const { return !Root.getPointer(); }
+
+  const DataT *lookup(key_type_ref K) const {
+    if (Root.getInt())
+      return getHashMap().lookup(K);
+    if (TreeTy *T = getTree())
+      if (TreeTy *N = T->find(K))
+        return &N->getValue().second;
+    return nullptr;
+  }
+
+  iterator begin() const {
+    if (Root.getInt())
+      return iterator(getHashMap().begin());
+    return iterator(getTree());
+  }
+  iterator end() const {
+    if (Root.getInt())
+      return iterator(getHashMap().end());
+    return iterator(static_cast<const TreeTy *>(nullptr));
+  }
+
+  /// Get an opaque pointer to the root of the map, which identifies it.
+  const void *getRootWithoutRetain() const { return Root.getPointer(); }
+
+  bool operator==(const BindingMap &RHS) const {
+    TreeTy *T = getTree(), *RHST = RHS.getTree();
+    if (T && RHST)
+      return T->isEqual(*RHST);
+    return Root == RHS.Root;
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    ID.AddPointer(getRootWithoutRetain());
+  }
+};
+
+/// A reference to a binding map that is being updated.
+///
+/// Like llvm::ImmutableMapRef, it defers the canonicalization of AVL trees
+/// until the map is turned back into a BindingMap. Hash maps are always
+/// canonical. The factory tells which kind of map the root belongs to.
+template <typename KeyT, typename DataT> class BindingMapRef {
+  typedef BindingMap<KeyT, DataT> MapTy;
+  typedef typename MapTy::TreeTy TreeTy;
+  typedef typename MapTy::HashMapTy HashMapTy;
+
+  const void *Root;
+  typename MapTy::Factory *F;
+
+  BindingMapRef(const void *Root, typename MapTy::Factory *F)
+      : Root(Root), F(F) {
+    retain();
+  }
+
+  TreeTy *getTree() const {
+    if (F->isHashed())
+      return nullptr;
+    return static_cast<TreeTy *>(const_cast<void *>(Root));
+  }
+
+  HashMapTy getHashMap() const {
+    if (!F->isHashed())
+      return HashMapTy();
+    return HashMapTy(static_cast<const typename MapTy::HashNodeTy *>(Root));
+  }
+
+  void retain() const {
+    if (TreeTy *T = getTree())
+      T->retain();
+  }
+
+  void release() const {
+    if (TreeTy *T = getTree())
+      T->release();
+  }
+
+public:
+  typedef typename MapTy::key_type_ref key_type_ref;
+  typedef typename MapTy::data_type_ref data_type_ref;
+  typedef typename MapTy::iterator iterator;
+
+  BindingMapRef(const MapTy &M, typename MapTy::Factory &F)
+      : Root(M.getRootWithoutRetain()), F(&F) {
+    retain();
+  }
+
+  BindingMapRef(const BindingMapRef &X) : Root(X.Root), F(X.F) { retain(); }
+
+  BindingMapRef &operator=(const BindingMapRef &X) {
+    if (Root != X.Root) {
+      X.retain();
+      release();
+      Root = X.Root;
+    }
+    F = X.F;
+    return *this;
+  }
+
+  ~BindingMapRef() { release(); }
+
+  BindingMapRef add(key_type_ref K, data_type_ref D) const {
+    BindingMapUpdate Update(F->Alloc);
+    if (F->isHashed())
+      return BindingMapRef(F->HashF.add(getHashMap(), K, D).getRoot(), F);
+    return BindingMapRef(F->TreeF.getTreeFactory()->add(
+                             getTree(), std::pair<KeyT, DataT>(K, D)),
+                         F);
+  }
+
+  BindingMapRef remove(key_type_ref K) const {
+    BindingMapUpdate Update(F->Alloc);
+    if (F->isHashed())
+      return BindingMapRef(F->HashF.remove(getHashMap(), K).getRoot(), F);
+    return BindingMapRef(F->TreeF.getTreeFactory()->remove(getTree(), K), F);
+  }
+
+  bool isEmpty() const { return !Root; }
+
+  const DataT *lookup(key_type_ref K) const {
+    if (F->isHashed())
+      return getHashMap().lookup(K);
+    if (TreeTy *T = getTree())
+      if (TreeTy *N = T->find(K))
+        return &N->getValue().second;
+    return nullptr;
+  }
+
+  iterator begin() const {
+    if (F->isHashed())
+      return iterator(getHashMap().begin());
+    return iterator(getTree());
+  }
+  iterator end() const {
+    if (F->isHashed())
+      return iterator(getHashMap().end());
+    return iterator(static_cast<const TreeTy *>(nullptr));
+  }
+
+  MapTy asImmutableMap() const {
+    if (F->isHashed())
+      return MapTy(Root, true);
+    return MapTy(F->TreeF.getTreeFactory()->getCanonicalTree(getTree()),
+                 false);
+  }
+
+  void manualRetain() { retain(); }
+  void manualRelease() { release(); }
+};
+} // end anonymous namespace
+
 //===----------------------------------------------------------------------===//
 // Actual Store type.
 //===----------------------------------------------------------------------===//
 
-typedef llvm::ImmutableMap<BindingKey, SVal>    ClusterBindings;
-typedef llvm::ImmutableMapRef<BindingKey, SVal> ClusterBindingsRef;
+typedef BindingMap<BindingKey, SVal>    ClusterBindings;
+typedef BindingMapRef<BindingKey, SVal> ClusterBindingsRef;
 typedef std::pair<BindingKey, SVal> BindingPair;
 
-typedef llvm::ImmutableMap<const MemRegion *, ClusterBindings>
+typedef BindingMap<const MemRegion *, ClusterBindings>
         RegionBindings;
 
 namespace {
-class RegionBindingsRef : public llvm::ImmutableMapRef<const MemRegion *,
-                                 ClusterBindings> {
+class RegionBindingsRef : public BindingMapRef<const MemRegion *,
+                                               ClusterBindings> {
   ClusterBindings::Factory *CBFactory;
 
 public:
-  typedef llvm::ImmutableMapRef<const MemRegion *, ClusterBindings>
-          ParentTy;
+  typedef BindingMapRef<const MemRegion *, ClusterBindings> ParentTy;
 
   RegionBindingsRef(ClusterBindings::Factory &CBFactory,
-                    const RegionBindings::TreeTy *T,
-                    RegionBindings::TreeTy::Factory *F)
-      : llvm::ImmutableMapRef<const MemRegion *, ClusterBindings>(T, F),
+                    const RegionBindings &B, RegionBindings::Factory &F)
+      : BindingMapRef<const MemRegion *, ClusterBindings>(B, F),
         CBFactory(&CBFactory) {}
 
   RegionBindingsRef(const ParentTy &P, ClusterBindings::Factory &CBFactory)
-      : llvm::ImmutableMapRef<const MemRegion *, ClusterBindings>(P),
+      : BindingMapRef<const MemRegion *, ClusterBindings>(P),
         CBFactory(&CBFactory) {}
 
   RegionBindingsRef add(key_type_ref K, data_type_ref D) const {
@@ -183,7 +495,7 @@ public:
 
   const SVal *lookup(BindingKey K) const;
   const SVal *lookup(const MemRegion *R, BindingKey::Kind k) const;
-  using llvm::ImmutableMapRef<const MemRegion *, ClusterBindings>::lookup;
+  using BindingMapRef<const MemRegion *, ClusterBindings>::lookup;
 
   RegionBindingsRef removeBinding(BindingKey K);
 
@@ -293,16 +605,21 @@ struct maximal_features_tag {};
 
 class RegionStoreFeatures {
   bool SupportsFields;
+  bool HashedBindings;
 public:
   RegionStoreFeatures(minimal_features_tag) :
-    SupportsFields(false) {}
+    SupportsFields(false), HashedBindings(false) {}
 
   RegionStoreFeatures(maximal_features_tag) :
-    SupportsFields(true) {}
+    SupportsFields(true), HashedBindings(false) {}
 
   void enableFields(bool t) { SupportsFields = t; }
 
+  /// Keep the bindings in ImmutableHashMaps rather than in AVL trees.
+  void enableHashedBindings(bool t) { HashedBindings = t; }
+
   bool supportsFields() const { return SupportsFields; }
+  bool usesHashedBindings() const { return HashedBindings; }
 };
 }
 
@@ -317,7 +634,7 @@ class RegionStoreManager : public StoreManager {
 public:
   const RegionStoreFeatures Features;
 
-  RegionBindings::Factory RBFactory;
+  mutable RegionBindings::Factory RBFactory;
   mutable ClusterBindings::Factory CBFactory;
 
   typedef std::vector<SVal> SValListTy;
@@ -345,7 +662,8 @@ private:
 public:
   RegionStoreManager(ProgramStateManager& mgr, const RegionStoreFeatures &f)
     : StoreManager(mgr), Features(f),
-      RBFactory(mgr.getAllocator()), CBFactory(mgr.getAllocator()),
+      RBFactory(mgr.getAllocator(), f.usesHashedBindings()),
+      CBFactory(mgr.getAllocator(), f.usesHashedBindings()),
       SmallStructLimit(0) {
     if (SubEngine *Eng = StateMgr.getOwningEngine()) {
       AnalyzerOptions &Options = Eng->getAnalysisManager().options;
@@ -592,9 +910,7 @@ public: // Part of public interface to class.
   //===------------------------------------------------------------------===//
 
   RegionBindingsRef getRegionBindings(Store store) const {
-    return RegionBindingsRef(CBFactory,
-                             static_cast<const RegionBindings::TreeTy*>(store),
-                             RBFactory.getTreeFactory());
+    return RegionBindingsRef(CBFactory, RBFactory.getMap(store), RBFactory);
   }
 
   void print(Store store, raw_ostream &Out, const char* nl,
@@ -638,6 +954,13 @@ ento::CreateFieldsOnlyRegionStoreManager(ProgramStateManager &StMgr) {
   return llvm::make_unique<RegionStoreManager>(StMgr, F);
 }
 
+std::unique_ptr<StoreManager>
+ento::CreateHashedRegionStoreManager(ProgramStateManager &StMgr) {
+  RegionStoreFeatures F = maximal_features_tag();
+  F.enableHashedBindings(true);
+  return llvm::make_unique<RegionStoreManager>(StMgr, F);
+}
+
 
 //===----------------------------------------------------------------------===//
 // Region Cluster analysis.
@@ -0,0 +1,155 @@
+//===-- AnalysisCache.cpp - Record of unchanged bug-free functions --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// The record of a translation unit is a text file, named after a hash of the
+// path of its main file. Its first line holds the key of the configuration
+// it was made with. Each function is then described by a line holding its
+// key, its analysis mode, its inlining mode and its name, separated by tabs,
+// followed by one line for each of its callees, which starts with a tab.
+//
+//===----------------------------------------------------------------------===//
+
+#include "AnalysisCache.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/LineIterator.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <tuple>
+
+using namespace clang;
+using namespace ento;
+
+AnalysisCache::AnalysisCache(StringRef Dir, StringRef MainFile,
+                             StringRef ConfigKey)
+    : Dir(Dir), ConfigKey(ConfigKey) {
+  SmallString<128> AbsoluteMainFile(MainFile);
+  llvm::sys::fs::make_absolute(AbsoluteMainFile);
+
+  llvm::MD5 Hash;
+  llvm::MD5::MD5Result Result;
+  Hash.update(AbsoluteMainFile);
+  Hash.final(Result);
+  SmallString<32> FileName;
+  llvm::MD5::stringifyResult(Result, FileName);
+  FileName += ".analysis";
+
+  SmallString<128> FilePath(Dir);
+  llvm::sys::path::append(FilePath, FileName);
+  Path = FilePath.str().str();
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return;
+
+  llvm::line_iterator I(**Buffer, /*SkipBlanks=*/true), E;
+  if (I == E || *I != ConfigKey)
+    return;
+
+  Entry *Current = nullptr;
+  for (++I; I != E; ++I) {
+    StringRef Line = *I;
+    if (Line.startswith("\t")) {
+      if (Current)
+        Current->Callees.push_back(Line.drop_front().str());
+      continue;
+    }
+
+    StringRef Key, ModeStr, InliningModeStr, Name;
+    std::tie(Key, Line) = Line.split('\t');
+    std::tie(ModeStr, Line) = Line.split('\t');
+    std::tie(InliningModeStr, Name) = Line.split('\t');
+    unsigned Mode, InliningMode;
+    if (Name.empty() || ModeStr.getAsInteger(10, Mode) ||
+        InliningModeStr.getAsInteger(10, InliningMode)) {
+      Current = nullptr;
+      continue;
+    }
+
+    Current = &Entries[getEntryName(Mode, InliningMode, Name)];
+    Current->Mode = Mode;
+    Current->InliningMode = InliningMode;
+    Current->Name = Name.str();
+    Current->Key = Key.str();
+    Current->Callees.clear();
+  }
+}
+
+std::string AnalysisCache::getEntryName(unsigned Mode, unsigned InliningMode,
+                                        StringRef Name) {
+  return (Twine(Mode) + "\t" + Twine(InliningMode) + "\t" + Name).str();
+}
+
+const std::vector<std::string> *
+AnalysisCache::lookup(unsigned Mode, unsigned InliningMode, StringRef Name,
+                      StringRef Key) const {
+  auto I = Entries.find(getEntryName(Mode, InliningMode, Name));
+  if (I == Entries.end() || I->getValue().Key != Key)
+    return nullptr;
+  return &I->getValue().Callees;
+}
+
+void AnalysisCache::add(unsigned Mode, unsigned InliningMode, StringRef Name,
+                        StringRef Key, std::vector<std::string> Callees) {
+  Entry &E = Entries[getEntryName(Mode, InliningMode, Name)];
+  E.Mode = Mode;
+  E.InliningMode = InliningMode;
+  E.Name = Name.str();
+  E.Key = Key.str();
+  E.Callees = std::move(Callees);
+}
+
+void AnalysisCache::save(llvm::function_ref<bool(StringRef Name)> IsLive) {
+  if (llvm::sys::fs::create_directories(Dir))
+    return;
+
+  // Write the record to a temporary file first, so that concurrent runs on
+  // the same translation unit never see a partial record.
+  SmallString<128> TempPath(Path);
+  TempPath += "-%%%%%%%%";
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(TempPath, FD, TempPath))
+    return;
+
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << ConfigKey << '\n';
+
+    // Write the functions in a deterministic order.
+    std::vector<const Entry *> Live;
+    for (const auto &I : Entries)
+      if (IsLive(I.getValue().Name))
+        Live.push_back(&I.getValue());
+    std::sort(Live.begin(), Live.end(), [](const Entry *L, const Entry *R) {
+      return std::tie(L->Name, L->Mode, L->InliningMode) <
+             std::tie(R->Name, R->Mode, R->InliningMode);
+    });
+
+    for (const Entry *E : Live) {
+      OS << E->Key << '\t' << E->Mode << '\t' << E->InliningMode << '\t'
+         << E->Name << '\n';
+      for (const std::string &Callee : E->Callees)
+        OS << '\t' << Callee << '\n';
+    }
+
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return;
+    }
+  }
+
+  if (llvm::sys::fs::rename(TempPath, Path))
+    llvm::sys::fs::remove(TempPath);
+}
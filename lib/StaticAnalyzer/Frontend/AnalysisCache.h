@@ -0,0 +1,80 @@
+//===-- AnalysisCache.h - Record of unchanged bug-free functions -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief This file defines the clang::ento::AnalysisCache class, which
+/// records on disk the functions of a translation unit whose analysis found
+/// no bugs, so that later runs of the analyzer can skip them as long as they
+/// have not changed.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SA_FRONTEND_ANALYSISCACHE_H
+#define LLVM_CLANG_SA_FRONTEND_ANALYSISCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace ento {
+
+/// The functions of a translation unit that were analyzed without finding
+/// bugs, keyed by their analysis mode, inlining mode and name.
+///
+/// Each function is recorded with a key, which hashes everything its
+/// analysis depends on, and with the callees that were inlined into it, so
+/// that a skipped function still keeps its callees from being analyzed as
+/// top-level functions. The record of a translation unit is kept in one file
+/// in the cache directory, and is discarded as a whole if the configuration
+/// of the analyzer changes.
+class AnalysisCache {
+public:
+  /// Load the record of the translation unit whose main file is \p MainFile
+  /// from \p Dir, if it was made with the same configuration.
+  AnalysisCache(StringRef Dir, StringRef MainFile, StringRef ConfigKey);
+
+  /// Get the callees of a function that was analyzed without finding bugs
+  /// when it had the given key, or null if there is no such record.
+  const std::vector<std::string> *lookup(unsigned Mode, unsigned InliningMode,
+                                         StringRef Name, StringRef Key) const;
+
+  /// Record that a function was analyzed without finding bugs.
+  void add(unsigned Mode, unsigned InliningMode, StringRef Name, StringRef Key,
+           std::vector<std::string> Callees);
+
+  /// Write the record of the functions for which \p IsLive returns true,
+  /// replacing the old one. Failures are silently ignored, as they only
+  /// cost a later run the time to analyze the functions again.
+  void save(llvm::function_ref<bool(StringRef Name)> IsLive);
+
+private:
+  struct Entry {
+    unsigned Mode;
+    unsigned InliningMode;
+    std::string Name;
+    std::string Key;
+    std::vector<std::string> Callees;
+  };
+
+  static std::string getEntryName(unsigned Mode, unsigned InliningMode,
+                                  StringRef Name);
+
+  std::string Dir;
+  std::string Path;
+  std::string ConfigKey;
+  llvm::StringMap<Entry> Entries;
+};
+
+} // end namespace ento
+} // end namespace clang
+
+#endif
@@ -12,16 +12,22 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/StaticAnalyzer/Frontend/AnalysisConsumer.h"
+#include "AnalysisCache.h"
 #include "ModelInjector.h"
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/DeclObjC.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/AST/ODRHash.h"
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/Analysis/Analyses/LiveVariables.h"
 #include "clang/Analysis/CFG.h"
 #include "clang/Analysis/CallGraph.h"
 #include "clang/Analysis/CodeInjector.h"
 #include "clang/Basic/SourceManager.h"
+#include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/TargetOptions.h"
+#include "clang/Basic/Version.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/StaticAnalyzer/Checkers/LocalCheckers.h"
@@ -33,9 +39,13 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/AnalysisManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "clang/StaticAnalyzer/Frontend/CheckerRegistration.h"
+#include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Timer.h"
@@ -59,6 +69,9 @@ STATISTIC(NumBlocksInAnalyzedFunctions,
                       "The # of basic blocks in the analyzed functions.");
 STATISTIC(PercentReachableBlocks, "The % of reachable basic blocks.");
 STATISTIC(MaxCFGSize, "The maximum number of basic blocks in a function.");
+STATISTIC(NumFunctionsSkippedByCache,
+                      "The # of functions skipped because they were analyzed "
+                      "without finding bugs in an earlier run.");
 
 //===----------------------------------------------------------------------===//
 // Special PathDiagnosticConsumers.
@@ -188,10 +201,44 @@ public:
   /// Time the analyzes time of each translation unit.
   static llvm::Timer* TUTotalTimer;
 
+  /// Time the exploration of the paths of each function, and the generation
+  /// of the reports that it found.
+  static llvm::Timer* ExplorationTimer;
+  static llvm::Timer* BugReportTimer;
+
   /// The information about analyzed functions shared throughout the
   /// translation unit.
   FunctionSummariesTy FunctionSummaries;
 
+  /// The record of the functions analyzed without finding bugs, if the
+  /// 'analysis-cache-dir' config option is set.
+  std::unique_ptr<AnalysisCache> Cache;
+
+  /// The call graph of the translation unit, which determines the functions
+  /// whose bodies the cache key of a function depends on.
+  std::unique_ptr<CallGraph> CacheCallGraph;
+
+  /// The functions of the translation unit by name, or null for the names
+  /// that are shared by several functions, which are never cached.
+  llvm::StringMap<const Decl *> CacheableDecls;
+
+  /// The cache keys and function hashes computed so far.
+  llvm::DenseMap<const Decl *, std::string> CacheKeys;
+  llvm::DenseMap<const Decl *, std::string> FunctionHashes;
+
+  /// The functions analyzed in this run, by declaration, analysis mode and
+  /// inlining mode.
+  struct AnalyzedFunction {
+    bool FoundBugs = false;
+    std::vector<std::string> Callees;
+  };
+  typedef std::pair<const Decl *, std::pair<unsigned, unsigned>>
+      AnalyzedFunctionKey;
+  llvm::MapVector<AnalyzedFunctionKey, AnalyzedFunction> AnalyzedFunctions;
+
+  /// Whether any bugs were reported while analyzing the current function.
+  bool FoundBugsInCurrentFunction = false;
+
   AnalysisConsumer(const Preprocessor &pp, const std::string &outdir,
                    AnalyzerOptionsRef opts, ArrayRef<std::string> plugins,
                    CodeInjector *injector)
@@ -202,12 +249,18 @@ public:
     if (Opts->PrintStats) {
       llvm::EnableStatistics(false);
       TUTotalTimer = new llvm::Timer("time", "Analyzer Total Time");
+      ExplorationTimer =
+          new llvm::Timer("exploration", "Path-Sensitive Exploration Time");
+      BugReportTimer =
+          new llvm::Timer("reports", "Path-Sensitive Report Generation Time");
     }
   }
 
   ~AnalysisConsumer() override {
     if (Opts->PrintStats) {
       delete TUTotalTimer;
+      delete ExplorationTimer;
+      delete BugReportTimer;
       llvm::PrintStatistics();
     }
   }
@@ -321,6 +374,34 @@ public:
                   ExprEngine::InliningModes IMode = ExprEngine::Inline_Minimal,
                   SetOfConstDecls *VisitedCallees = nullptr);
 
+  /// \brief Load the record of the functions analyzed without finding bugs
+  /// in an earlier run on this translation unit.
+  void loadAnalysisCache(StringRef Dir, const unsigned LocalTUDeclsSize);
+
+  /// \brief Record the functions analyzed without finding bugs in this run.
+  void saveAnalysisCache();
+
+  /// \brief Add the declarations of the types and global variables in
+  /// \p DC to the key of the configuration.
+  void addTypeDeclarations(const DeclContext *DC,
+                           llvm::function_ref<void(StringRef)> AddString);
+
+  /// \brief Get a hash of the body and the signature of the function, and
+  /// of the types of the declarations that its body refers to.
+  StringRef getFunctionHash(const Decl *D);
+
+  /// \brief Get a key that changes whenever the function or any function it
+  /// calls, directly or not, changes.
+  StringRef getCacheKey(const Decl *D);
+
+  /// \brief Check if the function was analyzed in the same analysis and
+  /// inlining modes without finding bugs in an earlier run, and has not
+  /// changed since. If so, add the callees that were inlined into it to
+  /// \p VisitedCallees.
+  bool isCachedAsBugFree(const Decl *D, AnalysisMode Mode,
+                         ExprEngine::InliningModes IMode,
+                         SetOfConstDecls *VisitedCallees);
+
   void RunPathSensitiveChecks(Decl *D,
                               ExprEngine::InliningModes IMode,
                               SetOfConstDecls *VisitedCallees);
@@ -393,6 +474,8 @@ private:
 // AnalysisConsumer implementation.
 //===----------------------------------------------------------------------===//
 llvm::Timer* AnalysisConsumer::TUTotalTimer = nullptr;
+llvm::Timer* AnalysisConsumer::ExplorationTimer = nullptr;
+llvm::Timer* AnalysisConsumer::BugReportTimer = nullptr;
 
 bool AnalysisConsumer::HandleTopLevelDecl(DeclGroupRef DG) {
   storeTopLevelDecls(DG);
@@ -522,6 +605,10 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
   {
     if (TUTotalTimer) TUTotalTimer->startTimer();
 
+    StringRef CacheDir = Opts->getAnalysisCacheDir();
+    if (!CacheDir.empty())
+      loadAnalysisCache(CacheDir, LocalTUDecls.size());
+
     // Introduce a scope to destroy BR before Mgr.
     BugReporter BR(*Mgr);
     TranslationUnitDecl *TU = C.getTranslationUnitDecl();
@@ -561,6 +648,9 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
   // used with option -disable-free.
   Mgr.reset();
 
+  if (Cache)
+    saveAnalysisCache();
+
   if (TUTotalTimer) TUTotalTimer->stopTimer();
 
   // Count how many basic blocks we have not covered.
@@ -666,26 +756,296 @@ void AnalysisConsumer::HandleCode(Decl *D, AnalysisMode Mode,
   if (Mode == AM_None)
     return;
 
-  // Clear the AnalysisManager of old AnalysisDeclContexts.
-  Mgr->ClearContexts();
+  // Clear the AnalysisManager of old AnalysisDeclContexts, keeping the recent
+  // ones for the functions that are analyzed or inlined again.
+  Mgr->TrimContexts();
   // Ignore autosynthesized code.
   if (Mgr->getAnalysisDeclContext(D)->isBodyAutosynthesized())
     return;
 
+  if (Cache && isCachedAsBugFree(D, Mode, IMode, VisitedCallees)) {
+    NumFunctionsSkippedByCache++;
+    return;
+  }
+
   DisplayFunction(D, Mode, IMode);
   CFG *DeclCFG = Mgr->getCFG(D);
   if (DeclCFG)
     MaxCFGSize.updateMax(DeclCFG->size());
 
-  BugReporter BR(*Mgr);
+  FoundBugsInCurrentFunction = false;
+  {
+    BugReporter BR(*Mgr);
+
+    if (Mode & AM_Syntax) {
+      checkerMgr->runCheckersOnASTBody(D, *Mgr, BR);
+      if (BR.EQClasses_begin() != BR.EQClasses_end())
+        FoundBugsInCurrentFunction = true;
+    }
+    if ((Mode & AM_Path) && checkerMgr->hasPathSensitiveCheckers()) {
+      RunPathSensitiveChecks(D, IMode, VisitedCallees);
+      if (IMode != ExprEngine::Inline_Minimal)
+        NumFunctionsAnalyzed++;
+    }
+  }
+
+  if (Cache) {
+    AnalyzedFunction &F = AnalyzedFunctions[std::make_pair(
+        D, std::make_pair(unsigned(Mode), unsigned(IMode)))];
+    F.FoundBugs |= FoundBugsInCurrentFunction;
+    if (VisitedCallees)
+      for (const Decl *Callee : *VisitedCallees)
+        F.Callees.push_back(getFunctionName(Callee));
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Analysis cache.
+//===----------------------------------------------------------------------===//
+
+void AnalysisConsumer::loadAnalysisCache(StringRef Dir,
+                                         const unsigned LocalTUDeclsSize) {
+  SourceManager &SM = Ctx->getSourceManager();
+  const FileEntry *MainFile = SM.getFileEntryForID(SM.getMainFileID());
+  if (!MainFile)
+    return;
+
+  CacheCallGraph = llvm::make_unique<CallGraph>();
+  for (unsigned i = 0 ; i < LocalTUDeclsSize ; ++i)
+    CacheCallGraph->addToCallGraph(LocalTUDecls[i]);
 
-  if (Mode & AM_Syntax)
-    checkerMgr->runCheckersOnASTBody(D, *Mgr, BR);
-  if ((Mode & AM_Path) && checkerMgr->hasPathSensitiveCheckers()) {
-    RunPathSensitiveChecks(D, IMode, VisitedCallees);
-    if (IMode != ExprEngine::Inline_Minimal)
-      NumFunctionsAnalyzed++;
+  for (const auto &I : *CacheCallGraph) {
+    const Decl *D = I.second->getDecl();
+    if (!D)
+      continue;
+    auto Entry = CacheableDecls.insert(std::make_pair(getFunctionName(D), D));
+    if (!Entry.second)
+      Entry.first->second = nullptr;
+  }
+
+  // The analysis also depends on the compiler, the target and the options
+  // of the analyzer, so a change to any of them invalidates the whole cache.
+  llvm::MD5 Hash;
+  auto AddString = [&Hash](StringRef S) {
+    Hash.update(S);
+    Hash.update(StringRef("", 1));
+  };
+  AddString(getClangFullVersion());
+
+  const TargetOptions &TargetOpts = Ctx->getTargetInfo().getTargetOpts();
+  AddString(TargetOpts.Triple);
+  AddString(TargetOpts.CPU);
+  AddString(TargetOpts.FPMath);
+  AddString(TargetOpts.ABI);
+  AddString(llvm::utostr(static_cast<unsigned>(TargetOpts.EABIVersion)));
+  for (const std::string &Feature : TargetOpts.FeaturesAsWritten)
+    AddString(Feature);
+  for (const std::string &Feature : TargetOpts.Features)
+    AddString(Feature);
+
+  const LangOptions &LangOpts = Ctx->getLangOpts();
+#define LANGOPT(Name, Bits, Default, Description)                              \
+  AddString(llvm::utostr(LangOpts.Name));
+#define ENUM_LANGOPT(Name, Type, Bits, Default, Description)                   \
+  AddString(llvm::utostr(static_cast<unsigned>(LangOpts.get##Name())));
+#include "clang/Basic/LangOptions.def"
+  AddString(LangOpts.ObjCRuntime.getAsString());
+  for (const std::string &Func : LangOpts.NoBuiltinFuncs)
+    AddString(Func);
+
+  // The cache keys of functions only cover the types they use by name, so
+  // any change to the definition of a type, or to a global variable,
+  // invalidates the whole cache.
+  addTypeDeclarations(Ctx->getTranslationUnitDecl(), AddString);
+
+  for (const auto &Checker : Opts->CheckersControlList)
+    AddString((Checker.second ? "+" : "-") + Checker.first);
+  std::vector<std::pair<StringRef, StringRef>> Config;
+  for (const auto &Entry : Opts->Config)
+    Config.push_back(std::make_pair(Entry.getKey(), StringRef(Entry.second)));
+  std::sort(Config.begin(), Config.end());
+  for (const auto &Entry : Config) {
+    AddString(Entry.first);
+    AddString(Entry.second);
   }
+  AddString(llvm::utostr(Opts->AnalysisStoreOpt) + " " +
+            llvm::utostr(Opts->AnalysisConstraintsOpt) + " " +
+            llvm::utostr(Opts->AnalysisPurgeOpt) + " " +
+            llvm::utostr(Opts->maxBlockVisitOnPath) + " " +
+            llvm::utostr(Opts->InlineMaxStackDepth) + " " +
+            llvm::utostr(Opts->InliningMode) + " " +
+            llvm::utostr(Opts->AnalyzeAll) +
+            llvm::utostr(Opts->AnalyzeNestedBlocks) +
+            llvm::utostr(Opts->eagerlyAssumeBinOpBifurcation) +
+            llvm::utostr(Opts->UnoptimizedCFG) +
+            llvm::utostr(Opts->NoRetryExhausted));
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> ConfigKey;
+  llvm::MD5::stringifyResult(Result, ConfigKey);
+
+  Cache = llvm::make_unique<AnalysisCache>(Dir, MainFile->getName(),
+                                           ConfigKey);
+}
+
+void AnalysisConsumer::saveAnalysisCache() {
+  for (const auto &I : AnalyzedFunctions) {
+    const Decl *D = I.first.first;
+    if (I.second.FoundBugs)
+      continue;
+    std::string Name = getFunctionName(D);
+    auto Entry = CacheableDecls.find(Name);
+    if (Entry == CacheableDecls.end() || !Entry->second)
+      continue;
+    Cache->add(I.first.second.first, I.first.second.second, Name,
+               getCacheKey(D), I.second.Callees);
+  }
+
+  // Keep the records of the functions that were not analyzed in this run,
+  // such as those that were skipped, unless they no longer exist.
+  Cache->save([this](StringRef Name) {
+    auto Entry = CacheableDecls.find(Name);
+    return Entry != CacheableDecls.end() && Entry->second;
+  });
+}
+
+/// Add the declarations of the types and the global variables of a
+/// declaration context, as printed, to the key of the configuration.
+void AnalysisConsumer::addTypeDeclarations(
+    const DeclContext *DC, llvm::function_ref<void(StringRef)> AddString) {
+  for (const Decl *D : DC->decls()) {
+    if (isa<NamespaceDecl>(D) || isa<LinkageSpecDecl>(D) ||
+        isa<ExportDecl>(D)) {
+      addTypeDeclarations(cast<DeclContext>(D), AddString);
+      continue;
+    }
+
+    // Nested types are printed along with the records that contain them.
+    const auto *VD = dyn_cast<VarDecl>(D);
+    if (!isa<TypeDecl>(D) && !isa<ClassTemplateDecl>(D) &&
+        !isa<TypeAliasTemplateDecl>(D) && !isa<ObjCContainerDecl>(D) &&
+        !(VD && VD->hasGlobalStorage()))
+      continue;
+
+    std::string Str;
+    llvm::raw_string_ostream OS(Str);
+    D->print(OS, Ctx->getPrintingPolicy());
+    AddString(OS.str());
+  }
+}
+
+/// Add the name and the canonical type of a declaration to a hash.
+static void addDeclType(llvm::MD5 &Hash, const ValueDecl *D) {
+  Hash.update(D->getQualifiedNameAsString());
+  Hash.update(" ");
+  Hash.update(D->getType().getCanonicalType().getAsString());
+  Hash.update("\n");
+}
+
+/// Add the canonical types of the declarations that a statement refers to.
+static void addReferencedDeclTypes(llvm::MD5 &Hash, const Stmt *S) {
+  if (!S)
+    return;
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(S))
+    addDeclType(Hash, DRE->getDecl());
+  else if (const auto *ME = dyn_cast<MemberExpr>(S))
+    addDeclType(Hash, ME->getMemberDecl());
+  for (const Stmt *Child : S->children())
+    addReferencedDeclTypes(Hash, Child);
+}
+
+StringRef AnalysisConsumer::getFunctionHash(const Decl *D) {
+  std::string &FunctionHash = FunctionHashes[D];
+  if (!FunctionHash.empty())
+    return FunctionHash;
+
+  // ODRHash identifies the declarations the body refers to by name only, so
+  // the signature of the function and the types of those declarations are
+  // hashed as well.
+  llvm::MD5 Hash;
+  const Stmt *Body = D->getBody();
+  ODRHash ODR;
+  if (Body)
+    ODR.AddStmt(Body);
+  Hash.update(llvm::utostr(ODR.CalculateHash()) + "\n");
+
+  if (const FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+    Hash.update(FD->getType().getCanonicalType().getAsString());
+  } else if (const ObjCMethodDecl *MD = dyn_cast<ObjCMethodDecl>(D)) {
+    Hash.update(MD->getReturnType().getCanonicalType().getAsString());
+    for (const ParmVarDecl *Param : MD->parameters())
+      addDeclType(Hash, Param);
+  }
+  Hash.update("\n");
+  addReferencedDeclTypes(Hash, Body);
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Str;
+  llvm::MD5::stringifyResult(Result, Str);
+  FunctionHash.assign(Str.begin(), Str.end());
+  return FunctionHash;
+}
+
+StringRef AnalysisConsumer::getCacheKey(const Decl *D) {
+  if (!isa<ObjCMethodDecl>(D))
+    D = D->getCanonicalDecl();
+  std::string &Key = CacheKeys[D];
+  if (!Key.empty())
+    return Key;
+
+  // Hash the names, signatures and bodies of the functions reachable from D
+  // in the call graph, in a deterministic order. This covers all the
+  // functions that may be inlined into D.
+  llvm::MD5 Hash;
+  SmallVector<const Decl *, 16> Worklist;
+  llvm::SmallPtrSet<const Decl *, 16> Seen;
+  Worklist.push_back(D);
+  Seen.insert(D);
+  while (!Worklist.empty()) {
+    const Decl *Cur = Worklist.pop_back_val();
+
+    Hash.update(getFunctionName(Cur));
+    Hash.update(" ");
+    Hash.update(getFunctionHash(Cur));
+    Hash.update("\n");
+
+    if (CallGraphNode *N = CacheCallGraph->getNode(Cur))
+      for (CallGraphNode *Callee : *N)
+        if (const Decl *CalleeD = Callee->getDecl())
+          if (Seen.insert(CalleeD).second)
+            Worklist.push_back(CalleeD);
+  }
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Str;
+  llvm::MD5::stringifyResult(Result, Str);
+  Key.assign(Str.begin(), Str.end());
+  return Key;
+}
+
+bool AnalysisConsumer::isCachedAsBugFree(const Decl *D, AnalysisMode Mode,
+                                         ExprEngine::InliningModes IMode,
+                                         SetOfConstDecls *VisitedCallees) {
+  std::string Name = getFunctionName(D);
+  auto Entry = CacheableDecls.find(Name);
+  if (Entry == CacheableDecls.end() || !Entry->second)
+    return false;
+
+  const std::vector<std::string> *Callees =
+      Cache->lookup(Mode, IMode, Name, getCacheKey(D));
+  if (!Callees)
+    return false;
+
+  if (VisitedCallees) {
+    for (const std::string &Callee : *Callees) {
+      auto CalleeEntry = CacheableDecls.find(Callee);
+      if (CalleeEntry != CacheableDecls.end() && CalleeEntry->second)
+        VisitedCallees->insert(CalleeEntry->second);
+    }
+  }
+  return true;
 }
 
 //===----------------------------------------------------------------------===//
@@ -714,8 +1074,10 @@ void AnalysisConsumer::ActionExprEngine(Decl *D, bool ObjCGCEnabled,
   }
 
   // Execute the worklist algorithm.
+  if (ExplorationTimer) ExplorationTimer->startTimer();
   Eng.ExecuteWorkList(Mgr->getAnalysisDeclContextManager().getStackFrame(D),
                       Mgr->options.getMaxNodesPerTopLevelFunction());
+  if (ExplorationTimer) ExplorationTimer->stopTimer();
 
   // Release the auditor (if any) so that it doesn't monitor the graph
   // created BugReporter.
@@ -726,7 +1088,12 @@ void AnalysisConsumer::ActionExprEngine(Decl *D, bool ObjCGCEnabled,
     Eng.ViewGraph(Mgr->options.TrimGraph);
 
   // Display warnings.
-  Eng.getBugReporter().FlushReports();
+  if (BugReportTimer) BugReportTimer->startTimer();
+  BugReporter &BR = Eng.getBugReporter();
+  BR.FlushReports();
+  if (BR.EQClasses_begin() != BR.EQClasses_end())
+    FoundBugsInCurrentFunction = true;
+  if (BugReportTimer) BugReportTimer->stopTimer();
 }
 
 void AnalysisConsumer::RunPathSensitiveChecks(Decl *D,
@@ -18,8 +18,10 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ConvertUTF.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/StringSaver.h"
+#include "llvm/Support/raw_ostream.h"
 #include <system_error>
 
 namespace clang {
@@ -165,7 +167,8 @@ volatile int JSONAnchorSource = 0;
 std::unique_ptr<JSONCompilationDatabase>
 JSONCompilationDatabase::loadFromFile(StringRef FilePath,
                                       std::string &ErrorMessage,
-                                      JSONCommandLineSyntax Syntax) {
+                                      JSONCommandLineSyntax Syntax,
+                                      bool CacheIndex) {
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> DatabaseBuffer =
       llvm::MemoryBuffer::getFile(FilePath);
   if (std::error_code Result = DatabaseBuffer.getError()) {
@@ -174,6 +177,19 @@ JSONCompilationDatabase::loadFromFile(StringRef FilePath,
   }
   std::unique_ptr<JSONCompilationDatabase> Database(
       new JSONCompilationDatabase(std::move(*DatabaseBuffer), Syntax));
+
+  llvm::sys::fs::file_status Status;
+  if (CacheIndex && !llvm::sys::fs::status(FilePath, Status)) {
+    std::string CachePath = (FilePath + ".index").str();
+    if (Database->readIndexCache(CachePath, Status))
+      return Database;
+    if (Database->scan()) {
+      Database->writeIndexCache(CachePath, Status);
+      return Database;
+    }
+  } else if (Database->scan()) {
+    return Database;
+  }
   if (!Database->parse(ErrorMessage))
     return nullptr;
   return Database;
@@ -187,7 +203,7 @@ JSONCompilationDatabase::loadFromBuffer(StringRef DatabaseString,
       llvm::MemoryBuffer::getMemBuffer(DatabaseString));
   std::unique_ptr<JSONCompilationDatabase> Database(
       new JSONCompilationDatabase(std::move(DatabaseBuffer), Syntax));
-  if (!Database->parse(ErrorMessage))
+  if (!Database->scan() && !Database->parse(ErrorMessage))
     return nullptr;
   return Database;
 }
@@ -202,7 +218,7 @@ JSONCompilationDatabase::getCompileCommands(StringRef FilePath) const {
   StringRef Match = MatchTrie.findEquivalent(NativeFilePath, ES);
   if (Match.empty())
     return std::vector<CompileCommand>();
-  llvm::StringMap< std::vector<CompileCommandRef> >::const_iterator
+  llvm::StringMap< std::vector<unsigned> >::const_iterator
     CommandsRefI = IndexByFile.find(Match);
   if (CommandsRefI == IndexByFile.end())
     return std::vector<CompileCommand>();
@@ -215,9 +231,9 @@ std::vector<std::string>
 JSONCompilationDatabase::getAllFiles() const {
   std::vector<std::string> Result;
 
-  llvm::StringMap< std::vector<CompileCommandRef> >::const_iterator
+  llvm::StringMap< std::vector<unsigned> >::const_iterator
     CommandsRefI = IndexByFile.begin();
-  const llvm::StringMap< std::vector<CompileCommandRef> >::const_iterator
+  const llvm::StringMap< std::vector<unsigned> >::const_iterator
     CommandsRefEnd = IndexByFile.end();
   for (; CommandsRefI != CommandsRefEnd; ++CommandsRefI) {
     Result.push_back(CommandsRefI->first().str());
@@ -228,8 +244,11 @@ JSONCompilationDatabase::getAllFiles() const {
 
 std::vector<CompileCommand>
 JSONCompilationDatabase::getAllCompileCommands() const {
+  std::vector<unsigned> CommandIndices(AllCommands.size());
+  for (unsigned I = 0, E = AllCommands.size(); I != E; ++I)
+    CommandIndices[I] = I;
   std::vector<CompileCommand> Commands;
-  getCommands(AllCommands, Commands);
+  getCommands(CommandIndices, Commands);
   return Commands;
 }
 
@@ -247,22 +266,151 @@ nodeToCommandLine(JSONCommandLineSyntax Syntax,
   return Arguments;
 }
 
+/// \brief Finds the nodes of the fields of the compile command \p Object.
+///
+/// Returns whether \p Object is a valid compile command. Sets ErrorMessage if
+/// it is not.
+static bool parseCompileCommand(llvm::yaml::MappingNode *Object,
+                                llvm::yaml::ScalarNode *&Directory,
+                                llvm::yaml::ScalarNode *&File,
+                                std::vector<llvm::yaml::ScalarNode *> &CmdLine,
+                                llvm::yaml::ScalarNode *&Output,
+                                std::string &ErrorMessage) {
+  llvm::Optional<std::vector<llvm::yaml::ScalarNode *>> Command;
+  for (auto& NextKeyValue : *Object) {
+    llvm::yaml::ScalarNode *KeyString =
+        dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
+    if (!KeyString) {
+      ErrorMessage = "Expected strings as key.";
+      return false;
+    }
+    SmallString<10> KeyStorage;
+    StringRef KeyValue = KeyString->getValue(KeyStorage);
+    llvm::yaml::Node *Value = NextKeyValue.getValue();
+    if (!Value) {
+      ErrorMessage = "Expected value.";
+      return false;
+    }
+    llvm::yaml::ScalarNode *ValueString =
+        dyn_cast<llvm::yaml::ScalarNode>(Value);
+    llvm::yaml::SequenceNode *SequenceString =
+        dyn_cast<llvm::yaml::SequenceNode>(Value);
+    if (KeyValue == "arguments" && !SequenceString) {
+      ErrorMessage = "Expected sequence as value.";
+      return false;
+    } else if (KeyValue != "arguments" && !ValueString) {
+      ErrorMessage = "Expected string as value.";
+      return false;
+    }
+    if (KeyValue == "directory") {
+      Directory = ValueString;
+    } else if (KeyValue == "arguments") {
+      Command = std::vector<llvm::yaml::ScalarNode *>();
+      for (auto &Argument : *SequenceString) {
+        auto Scalar = dyn_cast<llvm::yaml::ScalarNode>(&Argument);
+        if (!Scalar) {
+          ErrorMessage = "Only strings are allowed in 'arguments'.";
+          return false;
+        }
+        Command->push_back(Scalar);
+      }
+    } else if (KeyValue == "command") {
+      if (!Command)
+        Command = std::vector<llvm::yaml::ScalarNode *>(1, ValueString);
+    } else if (KeyValue == "file") {
+      File = ValueString;
+    } else if (KeyValue == "output") {
+      Output = ValueString;
+    } else {
+      ErrorMessage = ("Unknown key: \"" +
+                      KeyString->getRawValue() + "\"").str();
+      return false;
+    }
+  }
+  if (!File) {
+    ErrorMessage = "Missing key: \"file\".";
+    return false;
+  }
+  if (!Command) {
+    ErrorMessage = "Missing key: \"command\" or \"arguments\".";
+    return false;
+  }
+  if (!Directory) {
+    ErrorMessage = "Missing key: \"directory\".";
+    return false;
+  }
+  CmdLine = std::move(*Command);
+  return true;
+}
+
+/// \brief Returns the path that indexes the compile commands for \p FileName
+/// compiled in \p Directory.
+static void getNativeFilePath(StringRef Directory, StringRef FileName,
+                              SmallVectorImpl<char> &NativeFilePath) {
+  if (llvm::sys::path::is_relative(FileName)) {
+    SmallString<128> AbsolutePath(Directory);
+    llvm::sys::path::append(AbsolutePath, FileName);
+    llvm::sys::path::native(AbsolutePath, NativeFilePath);
+  } else {
+    llvm::sys::path::native(FileName, NativeFilePath);
+  }
+}
+
 void JSONCompilationDatabase::getCommands(
-    ArrayRef<CompileCommandRef> CommandsRef,
+    ArrayRef<unsigned> CommandIndices,
     std::vector<CompileCommand> &Commands) const {
-  for (int I = 0, E = CommandsRef.size(); I != E; ++I) {
+  for (unsigned Index : CommandIndices) {
+    const CompileCommandRef &Ref = AllCommands[Index];
+    llvm::yaml::ScalarNode *Directory = Ref.Directory;
+    llvm::yaml::ScalarNode *File = Ref.File;
+    std::vector<llvm::yaml::ScalarNode *> CommandLine = Ref.CommandLine;
+    llvm::yaml::ScalarNode *Output = Ref.Output;
+
+    // Commands located by scan() are parsed now. scan() has validated them.
+    llvm::SourceMgr LocalSM;
+    std::unique_ptr<llvm::yaml::Stream> LocalStream;
+    if (!Ref.Text.empty()) {
+      LocalStream = llvm::make_unique<llvm::yaml::Stream>(Ref.Text, LocalSM);
+      llvm::yaml::document_iterator I = LocalStream->begin();
+      auto *Object = I == LocalStream->end()
+                         ? nullptr
+                         : dyn_cast_or_null<llvm::yaml::MappingNode>(
+                               I->getRoot());
+      std::string ErrorMessage = "Expected object.";
+      if (!Object || !parseCompileCommand(Object, Directory, File,
+                                          CommandLine, Output, ErrorMessage)) {
+        // A database with this command would have failed to load had it been
+        // parsed up front, so report the same error rather than dropping the
+        // command silently.
+        llvm::errs() << "Error while parsing compile command in JSON "
+                        "database: "
+                     << ErrorMessage << "\n";
+        continue;
+      }
+    }
+
     SmallString<8> DirectoryStorage;
     SmallString<32> FilenameStorage;
     SmallString<32> OutputStorage;
-    auto Output = std::get<3>(CommandsRef[I]);
     Commands.emplace_back(
-        std::get<0>(CommandsRef[I])->getValue(DirectoryStorage),
-        std::get<1>(CommandsRef[I])->getValue(FilenameStorage),
-        nodeToCommandLine(Syntax, std::get<2>(CommandsRef[I])),
+        Directory->getValue(DirectoryStorage),
+        File->getValue(FilenameStorage),
+        nodeToCommandLine(Syntax, CommandLine),
         Output ? Output->getValue(OutputStorage) : "");
   }
 }
 
+void JSONCompilationDatabase::addCommand(StringRef NativeFilePath,
+                                         CompileCommandRef Cmd) {
+  IndexByFile[NativeFilePath].push_back(AllCommands.size());
+  AllCommands.push_back(std::move(Cmd));
+}
+
+void JSONCompilationDatabase::buildMatchTrie() {
+  for (const auto &Entry : IndexByFile)
+    MatchTrie.insert(Entry.first());
+}
+
 bool JSONCompilationDatabase::parse(std::string &ErrorMessage) {
   llvm::yaml::document_iterator I = YAMLStream.begin();
   if (I == YAMLStream.end()) {
@@ -285,91 +433,333 @@ bool JSONCompilationDatabase::parse(std::string &ErrorMessage) {
       ErrorMessage = "Expected object.";
       return false;
     }
-    llvm::yaml::ScalarNode *Directory = nullptr;
-    llvm::Optional<std::vector<llvm::yaml::ScalarNode *>> Command;
-    llvm::yaml::ScalarNode *File = nullptr;
-    llvm::yaml::ScalarNode *Output = nullptr;
-    for (auto& NextKeyValue : *Object) {
-      llvm::yaml::ScalarNode *KeyString =
-          dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-      if (!KeyString) {
-        ErrorMessage = "Expected strings as key.";
-        return false;
-      }
-      SmallString<10> KeyStorage;
-      StringRef KeyValue = KeyString->getValue(KeyStorage);
-      llvm::yaml::Node *Value = NextKeyValue.getValue();
-      if (!Value) {
-        ErrorMessage = "Expected value.";
-        return false;
-      }
-      llvm::yaml::ScalarNode *ValueString =
-          dyn_cast<llvm::yaml::ScalarNode>(Value);
-      llvm::yaml::SequenceNode *SequenceString =
-          dyn_cast<llvm::yaml::SequenceNode>(Value);
-      if (KeyValue == "arguments" && !SequenceString) {
-        ErrorMessage = "Expected sequence as value.";
-        return false;
-      } else if (KeyValue != "arguments" && !ValueString) {
-        ErrorMessage = "Expected string as value.";
+    CompileCommandRef Cmd;
+    if (!parseCompileCommand(Object, Cmd.Directory, Cmd.File, Cmd.CommandLine,
+                             Cmd.Output, ErrorMessage))
+      return false;
+    SmallString<8> FileStorage;
+    SmallString<8> DirectoryStorage;
+    SmallString<128> NativeFilePath;
+    getNativeFilePath(Cmd.Directory->getValue(DirectoryStorage),
+                      Cmd.File->getValue(FileStorage), NativeFilePath);
+    addCommand(NativeFilePath, std::move(Cmd));
+  }
+  buildMatchTrie();
+  return true;
+}
+
+namespace {
+
+/// \brief A scanner for compilation databases in plain JSON.
+///
+/// It checks that the text is a valid database, but only decodes the
+/// 'directory' and 'file' values, which index the compile commands. This is
+/// much cheaper than building a YAML node tree for a large database.
+class JSONDatabaseScanner {
+public:
+  JSONDatabaseScanner(StringRef Text) : Text(Text) {}
+
+  /// \brief Scans the next compile command. Returns false at the end of the
+  /// database or on an error; see atEnd().
+  bool next(StringRef &Object, std::string &Directory, std::string &File);
+
+  /// \brief Whether the whole database was scanned successfully.
+  bool atEnd() const { return Done && Pos == Text.size(); }
+
+private:
+  void skipWhitespace() {
+    while (Pos < Text.size() && (Text[Pos] == ' ' || Text[Pos] == '\t' ||
+                                 Text[Pos] == '\n' || Text[Pos] == '\r'))
+      ++Pos;
+  }
+  bool consume(char C) {
+    skipWhitespace();
+    if (Pos == Text.size() || Text[Pos] != C)
+      return false;
+    ++Pos;
+    return true;
+  }
+  bool scanString(StringRef &Raw);
+  bool scanStringArray();
+
+  StringRef Text;
+  size_t Pos = 0;
+  bool Started = false;
+  bool Done = false;
+};
+
+} // end namespace
+
+bool JSONDatabaseScanner::scanString(StringRef &Raw) {
+  if (!consume('"'))
+    return false;
+  size_t Start = Pos;
+  while (Pos < Text.size()) {
+    char C = Text[Pos];
+    if (C == '"') {
+      Raw = Text.slice(Start, Pos++);
+      return true;
+    }
+    if (static_cast<unsigned char>(C) < 0x20)
+      return false;
+    Pos += C == '\\' ? 2 : 1;
+  }
+  return false;
+}
+
+bool JSONDatabaseScanner::scanStringArray() {
+  if (!consume('['))
+    return false;
+  if (consume(']'))
+    return true;
+  StringRef Raw;
+  do {
+    if (!scanString(Raw))
+      return false;
+  } while (consume(','));
+  return consume(']');
+}
+
+/// \brief Decodes the JSON string \p Raw, without its quotes, into \p Result.
+static bool decodeJSONString(StringRef Raw, std::string &Result) {
+  Result.clear();
+  Result.reserve(Raw.size());
+  for (size_t I = 0, E = Raw.size(); I != E; ++I) {
+    if (Raw[I] != '\\') {
+      Result.push_back(Raw[I]);
+      continue;
+    }
+    if (++I == E)
+      return false;
+    switch (Raw[I]) {
+    case '"': case '\\': case '/': Result.push_back(Raw[I]); break;
+    case 'b': Result.push_back('\b'); break;
+    case 'f': Result.push_back('\f'); break;
+    case 'n': Result.push_back('\n'); break;
+    case 'r': Result.push_back('\r'); break;
+    case 't': Result.push_back('\t'); break;
+    case 'u': {
+      unsigned CodePoint;
+      if (I + 4 >= E || Raw.substr(I + 1, 4).getAsInteger(16, CodePoint))
         return false;
+      I += 4;
+      // Combine a UTF-16 surrogate pair.
+      unsigned Low;
+      if (CodePoint >= 0xD800 && CodePoint < 0xDC00 && I + 6 < E &&
+          Raw[I + 1] == '\\' && Raw[I + 2] == 'u' &&
+          !Raw.substr(I + 3, 4).getAsInteger(16, Low) && Low >= 0xDC00 &&
+          Low < 0xE000) {
+        CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (Low - 0xDC00);
+        I += 6;
       }
-      if (KeyValue == "directory") {
-        Directory = ValueString;
-      } else if (KeyValue == "arguments") {
-        Command = std::vector<llvm::yaml::ScalarNode *>();
-        for (auto &Argument : *SequenceString) {
-          auto Scalar = dyn_cast<llvm::yaml::ScalarNode>(&Argument);
-          if (!Scalar) {
-            ErrorMessage = "Only strings are allowed in 'arguments'.";
-            return false;
-          }
-          Command->push_back(Scalar);
-        }
-      } else if (KeyValue == "command") {
-        if (!Command)
-          Command = std::vector<llvm::yaml::ScalarNode *>(1, ValueString);
-      } else if (KeyValue == "file") {
-        File = ValueString;
-      } else if (KeyValue == "output") {
-        Output = ValueString;
-      } else {
-        ErrorMessage = ("Unknown key: \"" +
-                        KeyString->getRawValue() + "\"").str();
+      char Buffer[UNI_MAX_UTF8_BYTES_PER_CODE_POINT];
+      char *End = Buffer;
+      if (!llvm::ConvertCodePointToUTF8(CodePoint, End))
         return false;
-      }
+      Result.append(Buffer, End);
+      break;
+    }
+    default:
+      return false;
     }
-    if (!File) {
-      ErrorMessage = "Missing key: \"file\".";
+  }
+  return true;
+}
+
+bool JSONDatabaseScanner::next(StringRef &Object, std::string &Directory,
+                               std::string &File) {
+  if (Done)
+    return false;
+  if (!Started) {
+    Started = true;
+    if (!consume('['))
+      return false;
+    if (consume(']')) {
+      Done = true;
+      skipWhitespace();
       return false;
     }
-    if (!Command) {
-      ErrorMessage = "Missing key: \"command\" or \"arguments\".";
+  } else if (!consume(',')) {
+    if (consume(']'))
+      Done = true;
+    skipWhitespace();
+    return false;
+  }
+
+  skipWhitespace();
+  size_t Start = Pos;
+  if (!consume('{'))
+    return false;
+  bool HasDirectory = false, HasFile = false, HasCommand = false;
+  do {
+    StringRef Key, Value;
+    std::string DecodedKey;
+    if (!scanString(Key))
       return false;
+    if (Key.find('\\') != StringRef::npos) {
+      if (!decodeJSONString(Key, DecodedKey))
+        return false;
+      Key = DecodedKey;
     }
-    if (!Directory) {
-      ErrorMessage = "Missing key: \"directory\".";
+    if (!consume(':'))
       return false;
+    if (Key == "arguments") {
+      if (!scanStringArray())
+        return false;
+      HasCommand = true;
+      continue;
     }
-    SmallString<8> FileStorage;
-    StringRef FileName = File->getValue(FileStorage);
-    SmallString<128> NativeFilePath;
-    if (llvm::sys::path::is_relative(FileName)) {
-      SmallString<8> DirectoryStorage;
-      SmallString<128> AbsolutePath(
-          Directory->getValue(DirectoryStorage));
-      llvm::sys::path::append(AbsolutePath, FileName);
-      llvm::sys::path::native(AbsolutePath, NativeFilePath);
-    } else {
-      llvm::sys::path::native(FileName, NativeFilePath);
+    if (!scanString(Value))
+      return false;
+    if (Key == "directory") {
+      if (!decodeJSONString(Value, Directory))
+        return false;
+      HasDirectory = true;
+    } else if (Key == "file") {
+      if (!decodeJSONString(Value, File))
+        return false;
+      HasFile = true;
+    } else if (Key == "command") {
+      HasCommand = true;
+    } else if (Key != "output") {
+      return false;
     }
-    auto Cmd = CompileCommandRef(Directory, File, *Command, Output);
-    IndexByFile[NativeFilePath].push_back(Cmd);
-    AllCommands.push_back(Cmd);
-    MatchTrie.insert(NativeFilePath);
+  } while (consume(','));
+  if (!consume('}') || !HasDirectory || !HasFile || !HasCommand)
+    return false;
+  Object = Text.slice(Start, Pos);
+  return true;
+}
+
+bool JSONCompilationDatabase::scan() {
+  JSONDatabaseScanner Scanner(Database->getBuffer());
+  StringRef Object;
+  std::string Directory, File;
+  SmallString<128> NativeFilePath;
+  while (Scanner.next(Object, Directory, File)) {
+    CompileCommandRef Cmd;
+    Cmd.Text = Object;
+    NativeFilePath.clear();
+    getNativeFilePath(Directory, File, NativeFilePath);
+    addCommand(NativeFilePath, std::move(Cmd));
+  }
+  if (Scanner.atEnd()) {
+    buildMatchTrie();
+    return true;
   }
+  IndexByFile.clear();
+  AllCommands.clear();
+  return false;
+}
+
+static const char IndexCacheMagic[] = "CLANG-JSON-CDB-INDEX 1";
+
+/// \brief Reads a line of \p Text that starts with \p Tag followed by
+/// unsigned integers separated by spaces into \p Numbers.
+static bool readIndexCacheLine(StringRef &Text, char Tag,
+                               MutableArrayRef<uint64_t> Numbers) {
+  if (!Text.consume_front(StringRef(&Tag, 1)))
+    return false;
+  for (uint64_t &N : Numbers)
+    if (!Text.consume_front(" ") || Text.consumeInteger(10, N))
+      return false;
   return true;
 }
 
+bool JSONCompilationDatabase::readIndexCache(
+    StringRef CachePath, const llvm::sys::fs::file_status &Status) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Cache =
+      llvm::MemoryBuffer::getFile(CachePath);
+  if (!Cache)
+    return false;
+
+  StringRef Text = (*Cache)->getBuffer();
+  StringRef DatabaseText = Database->getBuffer();
+  uint64_t Header[3];
+  if (!Text.consume_front(IndexCacheMagic) || !Text.consume_front("\n") ||
+      !readIndexCacheLine(Text, 'D', Header) || !Text.consume_front("\n") ||
+      Header[0] != Status.getSize() || Header[0] != DatabaseText.size() ||
+      Header[1] != static_cast<uint64_t>(
+                       Status.getLastModificationTime().time_since_epoch()
+                           .count()))
+    return false;
+
+  bool Valid = true;
+  uint64_t NumCommands = Header[2];
+  for (uint64_t I = 0; Valid && I != NumCommands; ++I) {
+    uint64_t Range[2];
+    Valid = readIndexCacheLine(Text, 'C', Range) && Text.consume_front("\n") &&
+            Range[0] < DatabaseText.size() &&
+            Range[1] <= DatabaseText.size() - Range[0] &&
+            DatabaseText[Range[0]] == '{';
+    if (Valid) {
+      CompileCommandRef Cmd;
+      Cmd.Text = DatabaseText.substr(Range[0], Range[1]);
+      AllCommands.push_back(std::move(Cmd));
+    }
+  }
+  while (Valid && !Text.empty()) {
+    uint64_t Counts[2];
+    Valid = readIndexCacheLine(Text, 'F', Counts) && Text.consume_front(" ") &&
+            Counts[0] <= Text.size();
+    if (!Valid)
+      break;
+    StringRef NativeFilePath = Text.substr(0, Counts[0]);
+    Text = Text.drop_front(Counts[0]);
+    std::vector<unsigned> &Indices = IndexByFile[NativeFilePath];
+    for (uint64_t J = 0; Valid && J != Counts[1]; ++J) {
+      uint64_t Index;
+      Valid = Text.consume_front(" ") && !Text.consumeInteger(10, Index) &&
+              Index < AllCommands.size();
+      Indices.push_back(Index);
+    }
+    Valid = Valid && Text.consume_front("\n");
+  }
+
+  if (Valid) {
+    buildMatchTrie();
+    return true;
+  }
+  IndexByFile.clear();
+  AllCommands.clear();
+  return false;
+}
+
+void JSONCompilationDatabase::writeIndexCache(
+    StringRef CachePath, const llvm::sys::fs::file_status &Status) const {
+  // Write to a temporary file first, so concurrent loads never see a partial
+  // cache. Failures are ignored; the cache is only an optimization.
+  int FD;
+  SmallString<128> TempPath;
+  if (llvm::sys::fs::createUniqueFile(CachePath + "-%%%%%%%%", FD, TempPath))
+    return;
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    StringRef DatabaseText = Database->getBuffer();
+    OS << IndexCacheMagic << '\n'
+       << "D " << Status.getSize() << ' '
+       << static_cast<uint64_t>(
+              Status.getLastModificationTime().time_since_epoch().count())
+       << ' ' << AllCommands.size() << '\n';
+    for (const CompileCommandRef &Cmd : AllCommands)
+      OS << "C " << (Cmd.Text.data() - DatabaseText.data()) << ' '
+         << Cmd.Text.size() << '\n';
+    for (const auto &Entry : IndexByFile) {
+      OS << "F " << Entry.first().size() << ' '
+         << Entry.second.size() << ' ' << Entry.first();
+      for (unsigned Index : Entry.second)
+        OS << ' ' << Index;
+      OS << '\n';
+    }
+    if (OS.has_error()) {
+      OS.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return;
+    }
+  }
+  if (llvm::sys::fs::rename(TempPath, CachePath))
+    llvm::sys::fs::remove(TempPath);
+}
+
 } // end namespace tooling
 } // end namespace clang
@@ -0,0 +1,72 @@
+// RUN: rm -rf %t
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-config analysis-cache-dir=%t -analyzer-display-progress -verify %s 2>&1 | FileCheck %s --check-prefix=FIRST
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-config analysis-cache-dir=%t -analyzer-display-progress -verify %s 2>&1 | FileCheck %s --check-prefix=UNCHANGED
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-config analysis-cache-dir=%t -analyzer-display-progress -verify -DCHANGE_HELPER %s 2>&1 | FileCheck %s --check-prefix=CHANGED
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-config analysis-cache-dir=%t -analyzer-config ipa=none -analyzer-display-progress -verify %s 2>&1 | FileCheck %s --check-prefix=FIRST
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-config analysis-cache-dir=%t -analyzer-config ipa=none -analyzer-display-progress -verify -DCHANGE_PARAM %s 2>&1 | FileCheck %s --check-prefix=PARAM
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-config analysis-cache-dir=%t -analyzer-config ipa=none -analyzer-display-progress -verify -DCHANGE_PARAM -DCHANGE_STRUCT %s 2>&1 | FileCheck %s --check-prefix=FIRST
+
+int helper(int X) {
+#ifdef CHANGE_HELPER
+  return X + 2;
+#else
+  return X + 1;
+#endif
+}
+
+int caller(int X) {
+  return helper(X) * 2;
+}
+
+#ifdef CHANGE_PARAM
+int unrelated(long X) {
+#else
+int unrelated(int X) {
+#endif
+  return X - 1;
+}
+
+struct S {
+  int A;
+#ifdef CHANGE_STRUCT
+  int B;
+#endif
+};
+
+int readS(struct S *P) {
+  return P->A;
+}
+
+int divide(int X) {
+  return X / 0; // expected-warning{{Division by zero}}
+}
+
+// On the first run, and whenever the configuration changes, every function
+// is analyzed.
+// FIRST-DAG: analysis-cache.c caller
+// FIRST-DAG: analysis-cache.c unrelated
+// FIRST-DAG: analysis-cache.c divide
+
+// Unchanged bug-free functions are skipped, along with the functions inlined
+// into them, while functions with bugs are analyzed again.
+// UNCHANGED-NOT: analysis-cache.c caller
+// UNCHANGED-NOT: analysis-cache.c helper
+// UNCHANGED-NOT: analysis-cache.c unrelated
+// UNCHANGED: analysis-cache.c divide
+// UNCHANGED-NOT: analysis-cache.c caller
+// UNCHANGED-NOT: analysis-cache.c helper
+// UNCHANGED-NOT: analysis-cache.c unrelated
+
+// A change to a callee invalidates its callers.
+// CHANGED-NOT: analysis-cache.c unrelated
+// CHANGED-DAG: analysis-cache.c caller
+// CHANGED-DAG: analysis-cache.c divide
+// CHANGED-NOT: analysis-cache.c unrelated
+
+// A change to the type of a parameter invalidates the function.
+// PARAM-NOT: analysis-cache.c caller
+// PARAM-DAG: analysis-cache.c unrelated
+// PARAM-DAG: analysis-cache.c divide
+// PARAM-NOT: analysis-cache.c caller
+
+// A change to the definition of a type invalidates every function.
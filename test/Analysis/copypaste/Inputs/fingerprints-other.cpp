@@ -0,0 +1,8 @@
+void log();
+
+int maxClone(int x, int y) {
+  log();
+  if (x > y)
+    return x;
+  return y;
+}
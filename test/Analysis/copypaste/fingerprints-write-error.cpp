@@ -0,0 +1,13 @@
+// RUN: rm -rf %t && touch %t
+// RUN: %clang_analyze_cc1 -analyzer-checker=alpha.clone.CloneChecker -analyzer-config alpha.clone.CloneChecker:FingerprintDir=%t/sub %s 2>&1 | FileCheck %s
+
+// This tests that a failure to write the fingerprints is reported as a
+// warning, and does not stop the analysis.
+
+// CHECK: warning: could not write clone fingerprints to '{{.*}}sub': {{.+}}
+
+int max(int a, int b) {
+  if (a > b)
+    return a;
+  return b;
+}
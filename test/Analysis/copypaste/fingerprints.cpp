@@ -0,0 +1,44 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang_analyze_cc1 -analyzer-checker=alpha.clone.CloneChecker -analyzer-config alpha.clone.CloneChecker:FingerprintDir=%t -verify %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=alpha.clone.CloneChecker -analyzer-config alpha.clone.CloneChecker:FingerprintDir=%t %S/Inputs/fingerprints-other.cpp
+// RUN: ls %t | grep clonefp | count 2
+// RUN: clang-clone-merge -print-stats %t 2> %t.stats | FileCheck %s
+// RUN: FileCheck -check-prefix=STATS %s < %t.stats
+// RUN: clang-clone-merge -print-stats %S/Inputs/fingerprints-collision.clonefp \
+// RUN:   2> %t.collision | FileCheck -check-prefix=COLLISION %s
+// RUN: FileCheck -check-prefix=COLLISION-STATS %s < %t.collision
+
+// This tests if clones in different translation units are found by merging
+// their fingerprints.
+
+// expected-no-diagnostics
+
+void log();
+
+int max(int a, int b) {
+  log();
+  if (a > b)
+    return a;
+  return b;
+}
+
+// Only the largest clones are reported, not their sub-sequences.
+// CHECK: clone group (2 clones):
+// CHECK-NEXT: {{.*}}Inputs{{/|\\}}fingerprints-other.cpp:3:
+// CHECK-NEXT: {{.*}}fingerprints.cpp:18:
+// CHECK-NOT: clone group
+
+// STATS: translation units: 2
+// STATS: lines: 52
+// STATS: hash collisions: 0
+// STATS: clone groups: 1
+
+// Fingerprints whose hashes are equal but whose profiles differ are not
+// clones.
+// COLLISION: clone group (2 clones):
+// COLLISION-NEXT: /src/a.cpp:5:1-7:1
+// COLLISION-NEXT: /src/b.cpp:5:1-7:1
+// COLLISION-NOT: clone group
+
+// COLLISION-STATS: hash collisions: 1
+// COLLISION-STATS: clone groups: 1
@@ -0,0 +1,22 @@
+// RUN: rm -fR %t
+// RUN: mkdir %t
+// RUN: %clang_analyze_cc1 -analyzer-output=html -analyzer-checker=core -o %t %s
+// RUN: ls %t | grep report | count 2
+// RUN: grep -l "<span class='expansion'>\*p = 0</span>" %t/report-*.html | count 2
+
+// The macro expansions are computed once for the file, and must still show
+// up in every report.
+
+#define DEREF(p) *p = 0
+
+void first(int *p) {
+  if (p)
+    return;
+  DEREF(p);
+}
+
+void second(int *p) {
+  if (p)
+    return;
+  DEREF(p);
+}
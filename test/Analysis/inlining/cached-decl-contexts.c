@@ -0,0 +1,31 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,deadcode.DeadStores,debug.ExprInspection -verify %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,deadcode.DeadStores,debug.ExprInspection -analyzer-config max-cached-decl-contexts=0 -verify %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,deadcode.DeadStores,debug.ExprInspection -analyzer-config max-cached-decl-contexts=1 -verify %s
+
+void clang_analyzer_eval(int);
+
+// The CFG and the liveness of 'helper' are computed when it is analyzed on its
+// own, and reused whenever it is inlined, however many contexts are kept.
+int helper(int X) {
+  int Unused = X; // expected-warning{{Value stored to 'Unused' during its initialization is never read}}
+  if (X > 10)
+    return X - 10;
+  return 0;
+}
+
+void firstCaller() {
+  clang_analyzer_eval(helper(15) == 5); // expected-warning{{TRUE}}
+}
+
+void secondCaller() {
+  clang_analyzer_eval(helper(3) == 0); // expected-warning{{TRUE}}
+}
+
+int divide(int V, int D) {
+  return V / D; // expected-warning{{Division by zero}}
+}
+
+void thirdCaller() {
+  clang_analyzer_eval(helper(20) == 10); // expected-warning{{TRUE}}
+  divide(1, 0);
+}
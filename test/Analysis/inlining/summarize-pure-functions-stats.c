@@ -0,0 +1,35 @@
+// REQUIRES: asserts
+
+// Compare the work done for the same repeated calls with and without
+// summaries.
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-stats %s > %t.off 2>&1
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-config summarize-pure-functions=true -analyzer-stats %s > %t.on 2>&1
+// RUN: cat %t.off %t.on | FileCheck %s
+
+int clamp(int V, int Lo, int Hi) {
+  if (V < Lo)
+    return Lo;
+  if (V > Hi)
+    return Hi;
+  return V;
+}
+
+void testRepeatedCalls() {
+  int A = clamp(20, 0, 10);
+  int B = clamp(20, 0, 10);
+  int C = clamp(20, 0, 10);
+}
+
+// Without summaries, every call is inlined.
+// CHECK: ... Statistics Collected ...
+// CHECK: {{^ *}}[[STEPS:[0-9]+]] CoreEngine - The # of steps executed.
+// CHECK: {{^ *}}3 ExprEngine - The # of times we inlined a call
+// CHECK-NOT: reused the result of an earlier inlined call
+
+// With summaries, only the first call is inlined, and the exploded graph
+// no longer contains the bodies of the other two.
+// CHECK: ... Statistics Collected ...
+// CHECK-NOT: {{^ *}}[[STEPS]] CoreEngine - The # of steps executed.
+// CHECK: CoreEngine - The # of steps executed.
+// CHECK: {{^ *}}1 ExprEngine - The # of times we inlined a call
+// CHECK: {{^ *}}2 ExprEngine - The # of times we reused the result of an earlier inlined call
@@ -0,0 +1,68 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection -verify %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection -analyzer-config summarize-pure-functions=true -verify %s
+
+void clang_analyzer_eval(int);
+
+int clamp(int V, int Lo, int Hi) {
+  if (V < Lo)
+    return Lo;
+  if (V > Hi)
+    return Hi;
+  return V;
+}
+
+int sumTo(int N) {
+  int Sum = 0;
+  for (int I = 1; I <= N; ++I)
+    Sum += I;
+  return Sum;
+}
+
+void testSameArguments() {
+  clang_analyzer_eval(clamp(20, 0, 10) == 10); // expected-warning{{TRUE}}
+  clang_analyzer_eval(clamp(20, 0, 10) == 10); // expected-warning{{TRUE}}
+  clang_analyzer_eval(clamp(-5, 0, 10) == 0); // expected-warning{{TRUE}}
+  clang_analyzer_eval(clamp(5, 0, 10) == 5); // expected-warning{{TRUE}}
+  clang_analyzer_eval(sumTo(3) == 6); // expected-warning{{TRUE}}
+  clang_analyzer_eval(sumTo(3) == 6); // expected-warning{{TRUE}}
+}
+
+void testOtherCaller() {
+  clang_analyzer_eval(clamp(20, 0, 10) == 10); // expected-warning{{TRUE}}
+  clang_analyzer_eval(sumTo(3) + sumTo(2) == 9); // expected-warning{{TRUE}}
+}
+
+void testSymbolicArguments(int X) {
+  clang_analyzer_eval(clamp(X, 0, 10) <= 10); // expected-warning{{TRUE}}
+  clang_analyzer_eval(clamp(X, 0, 10) >= 0); // expected-warning{{TRUE}}
+}
+
+// Functions that read anything but their arguments are never summarized.
+int Global;
+int addGlobal(int V) {
+  return V + Global;
+}
+
+int deref(int *P, int V) {
+  return *P + V;
+}
+
+void testImpureFunctions() {
+  Global = 1;
+  clang_analyzer_eval(addGlobal(1) == 2); // expected-warning{{TRUE}}
+  Global = 2;
+  clang_analyzer_eval(addGlobal(1) == 3); // expected-warning{{TRUE}}
+
+  int A = 1;
+  clang_analyzer_eval(deref(&A, 0) == 1); // expected-warning{{TRUE}}
+  A = 2;
+  clang_analyzer_eval(deref(&A, 0) == 2); // expected-warning{{TRUE}}
+}
+
+int divide(int V, int D) {
+  return V / D; // expected-warning{{Division by zero}}
+}
+
+void testBugInCallee() {
+  divide(1, 0);
+}
@@ -0,0 +1,56 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection -verify %s
+
+void clang_analyzer_eval(int);
+void clang_analyzer_warnIfReached();
+
+void splitRanges(int x) {
+  if (x == 0 || x == 10 || x == 20)
+    return;
+  clang_analyzer_eval(x != 10); // expected-warning{{TRUE}}
+  if (x > 5 && x < 15) {
+    clang_analyzer_eval(x == 10); // expected-warning{{FALSE}}
+    clang_analyzer_eval(x == 11); // expected-warning{{UNKNOWN}}
+    clang_analyzer_eval(x == 20); // expected-warning{{FALSE}}
+  }
+}
+
+void narrowToValue(unsigned char c) {
+  if (c > 250) {
+    clang_analyzer_eval(c == 255); // expected-warning{{UNKNOWN}}
+    clang_analyzer_eval(c < 251); // expected-warning{{FALSE}}
+    if (c != 251 && c != 252 && c != 253 && c != 254)
+      clang_analyzer_eval(c == 255); // expected-warning{{TRUE}}
+  }
+}
+
+void wrapAround(unsigned x) {
+  if (x + 1 == 0)
+    clang_analyzer_eval(x == 0xffffffffu); // expected-warning{{TRUE}}
+  if (x - 5 > 0xfffffff0u) {
+    clang_analyzer_eval(x == 4); // expected-warning{{UNKNOWN}}
+    clang_analyzer_eval(x == 5); // expected-warning{{FALSE}}
+    clang_analyzer_eval(x == 0xfffffff5u); // expected-warning{{FALSE}}
+    clang_analyzer_eval(x == 0xfffffff6u); // expected-warning{{UNKNOWN}}
+  }
+}
+
+void caseRanges(int x) {
+  switch (x) {
+  case 1 ... 5:
+  case 10 ... 15:
+    clang_analyzer_eval(x == 7); // expected-warning{{FALSE}}
+    break;
+  default:
+    clang_analyzer_eval(x == 3); // expected-warning{{FALSE}}
+    clang_analyzer_eval(x == 12); // expected-warning{{FALSE}}
+    clang_analyzer_eval(x == 7); // expected-warning{{UNKNOWN}}
+    clang_analyzer_eval(x == 0); // expected-warning{{UNKNOWN}}
+  }
+}
+
+void nonNull(int *p) {
+  if (p == 0)
+    return;
+  if (!p)
+    clang_analyzer_warnIfReached(); // no-warning
+}
@@ -0,0 +1,32 @@
+// RUN: %clang_analyze_cc1 %s -analyzer-checker=core -analyzer-output=text -verify
+
+// Reports of several classes in one function are generated from the same
+// exploded graph; each of them must still get the path to its own error node.
+
+int severalClasses(int k, int d) {
+  if (k == 0) {
+    // expected-note@-1 {{Assuming 'k' is equal to 0}}
+    // expected-note@-2 {{Taking true branch}}
+    // expected-note@-3 2 {{Assuming 'k' is not equal to 0}}
+    // expected-note@-4 2 {{Taking false branch}}
+    int *q = 0; // expected-note {{'q' initialized to a null pointer value}}
+    return *q; // expected-warning {{Dereference of null pointer (loaded from variable 'q')}}
+    // expected-note@-1 {{Dereference of null pointer (loaded from variable 'q')}}
+  }
+
+  if (k == 1) {
+    // expected-note@-1 {{Assuming 'k' is equal to 1}}
+    // expected-note@-2 {{Taking true branch}}
+    // expected-note@-3 {{Assuming 'k' is not equal to 1}}
+    // expected-note@-4 {{Taking false branch}}
+    if (d == 0) // expected-note {{Assuming 'd' is equal to 0}}
+                // expected-note@-1 {{Taking true branch}}
+      return 10 / d; // expected-warning {{Division by zero}}
+                     // expected-note@-1 {{Division by zero}}
+    return d;
+  }
+
+  int u; // expected-note {{'u' declared without an initial value}}
+  return u + 1; // expected-warning {{The left operand of '+' is a garbage value}}
+                // expected-note@-1 {{The left operand of '+' is a garbage value}}
+}
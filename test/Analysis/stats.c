@@ -1,9 +1,16 @@
 // REQUIRES: asserts
 // RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-stats %s 2>&1 | FileCheck %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-store=hashed-region -analyzer-stats %s 2>&1 | FileCheck %s
 
 void foo() {
   int x;
 }
+
+void bar() {
+  int y;
+  y = 1;
+}
 // CHECK: ... Statistics Collected ...
 // CHECK:100 AnalysisConsumer - The % of reachable basic blocks.
 // CHECK:The # of times RemoveDeadBindings is called
+// CHECK:RegionStore - The # of updates to the binding maps of stores
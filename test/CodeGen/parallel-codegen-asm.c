@@ -0,0 +1,25 @@
+// REQUIRES: x86-registered-target
+// RUN: rm -f %t.o %t.o.1
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -O1 -emit-obj -fparallel-codegen=2 %s -o %t.o
+// RUN: llvm-nm %t.o | FileCheck %s
+// RUN: llvm-nm %t.o.1 | FileCheck %s --check-prefix=EMPTY --allow-empty
+
+// Module-level inline assembly is emitted once, together with the static
+// function it refers to, rather than copied into every partition.
+
+// CHECK-DAG: T from_asm
+// CHECK-DAG: t helper
+// CHECK-DAG: T first
+// CHECK-DAG: T second
+
+// EMPTY-NOT: from_asm
+// EMPTY-NOT: helper
+
+asm(".globl from_asm\n"
+    "from_asm:\n"
+    "  jmp helper\n");
+
+__attribute__((used, noinline)) static int helper(void) { return 42; }
+
+int first(int x) { return x + 1; }
+int second(int x) { return x * 2; }
@@ -0,0 +1,36 @@
+// REQUIRES: x86-registered-target
+// RUN: rm -f %t.o %t.o.1 %t.o.2
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -O1 -emit-obj -fparallel-codegen=3 %s -o %t.o
+// RUN: llvm-nm %t.o %t.o.1 %t.o.2 | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -O1 -emit-obj -fparallel-codegen=3 %s -o %t.again.o
+// RUN: cmp %t.o %t.again.o
+// RUN: cmp %t.o.1 %t.again.o.1
+// RUN: cmp %t.o.2 %t.again.o.2
+// RUN: not %clang_cc1 -triple x86_64-linux-gnu -emit-obj -fparallel-codegen=0 %s -o %t.o 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=INVALID
+// RUN: not %clang_cc1 -triple x86_64-linux-gnu -emit-obj -fparallel-codegen=2 %s -o - 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=STDOUT
+
+// Every function is defined in exactly one of the partitions, and the static
+// function stays local to the partition of its caller.
+
+// CHECK-DAG: T first
+// CHECK-DAG: T second
+// CHECK-DAG: T third
+// CHECK-DAG: T fourth
+// CHECK-DAG: t helper
+// CHECK-DAG: D counter
+
+// INVALID: error: invalid integral value '0' in '-fparallel-codegen=0'
+// STDOUT: error: invalid argument '-fparallel-codegen=2' only allowed with '-o <file>'
+
+int counter;
+
+__attribute__((noinline)) static int helper(int x) {
+  return x * counter + 1;
+}
+
+int first(int x) { return helper(x) + 1; }
+int second(int x) { return x * 2; }
+int third(int x) { return x - counter; }
+int fourth(int x) { return second(x) + third(x); }
@@ -0,0 +1,44 @@
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -O2 -emit-llvm -o %t.serial.ll %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -O2 -emit-llvm -o %t.pipelined.ll %s \
+// RUN:   -fpipelined-codegen
+// RUN: diff %t.serial.ll %t.pipelined.ll
+// RUN: FileCheck %s < %t.pipelined.ll
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -O2 -emit-llvm -o %t.again.ll %s \
+// RUN:   -fpipelined-codegen
+// RUN: diff %t.pipelined.ll %t.again.ll
+// RUN: %clang -### -c %s -fpipelined-codegen 2>&1 | FileCheck %s --check-prefix=DRIVER
+// RUN: %clang -### -c %s -fpipelined-codegen -fno-pipelined-codegen 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=NO-DRIVER
+
+// The early passes run on each function as soon as its top-level declaration
+// has been emitted, or at the end of the translation unit for the functions
+// that are emitted there, and the result is the same as without the pipeline.
+
+struct pair { int first, second; };
+
+static int sum(struct pair p) { return p.first + p.second; }
+
+// CHECK-LABEL: define i32 @add(
+// CHECK-NOT: alloca
+// CHECK: ret i32
+int add(int a, int b) {
+  struct pair p = {a, b};
+  return sum(p);
+}
+
+int later(int);
+
+// CHECK-LABEL: define i32 @caller(
+// CHECK: call i32 @later(
+int caller(int x) { return later(x) + 1; }
+
+// CHECK-LABEL: define i32 @later(
+int later(int x) {
+  int y = x;
+  if (__builtin_expect(y > 0, 1))
+    return y * 2;
+  return -y;
+}
+
+// DRIVER: "-fpipelined-codegen"
+// NO-DRIVER-NOT: "-fpipelined-codegen"
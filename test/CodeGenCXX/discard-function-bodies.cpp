@@ -0,0 +1,96 @@
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -std=c++14 -emit-llvm -o - %s | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -std=c++14 -emit-llvm -o - %s \
+// RUN:   -fdiscard-function-bodies | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -std=c++14 -emit-llvm -o /dev/null %s \
+// RUN:   -fdiscard-function-bodies -print-stats 2>&1 | FileCheck %s --check-prefix=STATS
+// RUN: not %clang_cc1 -triple x86_64-linux-gnu -std=c++14 -emit-llvm-only %s \
+// RUN:   -fdiscard-function-bodies -add-plugin print-fns 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=PLUGIN
+// RUN: %clang -### -c %s -fdiscard-function-bodies 2>&1 | FileCheck %s --check-prefix=DRIVER
+// RUN: %clang -### -c %s -fdiscard-function-bodies -fno-discard-function-bodies 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=NO-DRIVER
+
+// The bodies of these functions are released once they have been emitted.
+
+// CHECK-LABEL: define i32 @_Z3addii(
+// CHECK: add nsw i32
+int add(int a, int b) { return a + b; }
+
+// CHECK-LABEL: define i32 @_Z4loopi(
+// CHECK: icmp slt i32
+int loop(int n) {
+  int sum = 0;
+  for (int i = 0; i < n; ++i)
+    sum += i % 3 ? add(sum, i) : -i;
+  return sum;
+}
+
+// CHECK-LABEL: define i32 @_Z7counterv(
+// CHECK: call i32 @_Z3addii(i32 1, i32 2)
+int counter() {
+  static int n = add(1, 2);
+  return ++n;
+}
+
+namespace ns {
+// CHECK-LABEL: define i32 @_ZN2ns6scaledEi(
+// CHECK: mul nsw i32 %{{.*}}, 7
+int scaled(int x) { return x * 7; }
+}
+
+// Labels lose their statements along with the body.
+// CHECK-LABEL: define i32 @_Z9countdowni(
+// CHECK: br label %again
+int countdown(int n) {
+again:
+  if (n > 0) {
+    --n;
+    goto again;
+  }
+  return n;
+}
+
+struct S {
+  int v;
+  int get() const;
+  int twice() const { return 2 * v; }
+};
+
+// CHECK-LABEL: define i32 @_ZNK1S3getEv(
+// CHECK: call i32 @_ZNK1S5twiceEv(
+int S::get() const { return twice(); }
+
+// These are kept: inline functions, templates and constexpr functions may
+// be needed again, and lambdas are emitted separately.
+
+template <typename T> T pick(T a, T b) { return a < b ? b : a; }
+constexpr int square(int x) { return x * x; }
+
+// CHECK-LABEL: define i32 @_Z10withLambdai(
+int withLambda(int x) {
+  auto l = [=] { return x + square(3); };
+  return l();
+}
+
+// Later functions use the functions whose bodies were released.
+
+// CHECK-LABEL: define i32 @_Z6callerv(
+// CHECK: call i32 @_Z4loopi(i32 10)
+// CHECK: call i32 @_Z4pickIiET_S0_S0_(
+int caller() {
+  S s{3};
+  static_assert(square(4) == 16, "");
+  return loop(10) + counter() + ns::scaled(2) + s.get() + countdown(3) +
+         pick(withLambda(1), add(2, 3));
+}
+
+// CHECK-LABEL: define linkonce_odr i32 @_ZNK1S5twiceEv(
+// CHECK: mul nsw i32 2,
+
+// STATS: 7 function bodies discarded after code generation, {{[1-9][0-9]*}}/{{[1-9][0-9]*}} bytes of their statements reused
+
+// PLUGIN: error: invalid argument '-fdiscard-function-bodies' not allowed with '-add-plugin print-fns'
+
+// DRIVER: "-cc1"
+// DRIVER-SAME: "-fdiscard-function-bodies"
+// NO-DRIVER-NOT: "-fdiscard-function-bodies"
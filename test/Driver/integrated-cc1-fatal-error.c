@@ -0,0 +1,13 @@
+// A fatal error in an in-process cc1 job must not exit the driver, which
+// still reports the failure and generates crash diagnostics.
+
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: not env TMPDIR=%t TEMP=%t TMP=%t \
+// RUN:   %clang -fintegrated-cc1 -fsyntax-only %s 2>&1 | FileCheck %s
+// REQUIRES: crash-recovery
+
+#pragma clang __debug llvm_fatal_error
+// CHECK: error: error in backend: #pragma clang __debug llvm_fatal_error
+// CHECK: clang frontend command failed with exit code 70
+// CHECK: Preprocessed source(s) and associated run script(s) are located at:
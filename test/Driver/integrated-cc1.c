@@ -0,0 +1,20 @@
+// RUN: %clang -### -fintegrated-cc1 -c %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHECK-INPROC %s
+// CHECK-INPROC: "-cc1"{{.*}} (in-process)
+// CHECK-INPROC-NOT: argument unused
+
+// RUN: %clang -### -fno-integrated-cc1 -c %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHECK-OUTPROC %s
+// RUN: %clang -### -c %s 2>&1 | FileCheck -check-prefix=CHECK-OUTPROC %s
+// CHECK-OUTPROC: "-cc1"
+// CHECK-OUTPROC-NOT: (in-process)
+
+// Only a lone job runs in process.
+// RUN: %clang -### -fintegrated-cc1 -c %s %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHECK-MULTI %s
+// CHECK-MULTI: "-cc1"
+// CHECK-MULTI-NOT: (in-process)
+
+// A successful in-process compile.
+// RUN: %clang -fintegrated-cc1 -fsyntax-only %s
+int x;
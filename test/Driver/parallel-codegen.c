@@ -0,0 +1,29 @@
+// RUN: %clang -### -target x86_64-linux-gnu -c %s -o %t.o -fparallel-codegen=3 2>&1 \
+// RUN:   | FileCheck %s
+// RUN: %clang -### -target x86_64-apple-darwin10 -c %s -o %t.o -fparallel-codegen=2 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=DARWIN
+// RUN: %clang -### -target x86_64-linux-gnu -c %s -o %t.o -fparallel-codegen=1 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=SERIAL
+// RUN: %clang -### -target x86_64-linux-gnu -S %s -o %t.s -fparallel-codegen=3 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=SERIAL
+// RUN: %clang -### -target x86_64-pc-windows-msvc -c %s -o %t.o -fparallel-codegen=3 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=UNSUPPORTED
+// RUN: %clang -### -target x86_64-linux-gnu -c %s -o %t.o -fparallel-codegen=x 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=INVALID
+
+// The backend writes the partitions next to a temporary object file, which
+// the linker then combines into the output.
+// CHECK: "-cc1"
+// CHECK-SAME: "-fparallel-codegen=3" "-o" "[[OBJ:[^"]+\.o]]"
+// CHECK: "-r" "[[OBJ]]" "[[OBJ]].1" "[[OBJ]].2" "-o" "{{[^"]+}}.o"
+
+// DARWIN: "-cc1"
+// DARWIN-SAME: "-fparallel-codegen=2" "-o" "[[OBJ:[^"]+\.o]]"
+// DARWIN: "-r" "[[OBJ]]" "[[OBJ]].1" "-o" "{{[^"]+}}.o"
+
+// SERIAL-NOT: "-fparallel-codegen
+// SERIAL-NOT: "-r"
+
+// UNSUPPORTED: error: unsupported option '-fparallel-codegen=3' for target 'x86_64-pc-windows-msvc{{.*}}'
+
+// INVALID: error: invalid integral value 'x' in '-fparallel-codegen=x'
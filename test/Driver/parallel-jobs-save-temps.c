@@ -0,0 +1,16 @@
+// REQUIRES: x86-registered-target
+// With -save-temps, every step reads the file that the step before it wrote,
+// so the steps have to run one after the other even with -fparallel-jobs.
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: %clang -target x86_64-unknown-linux-gnu -fparallel-jobs=4 \
+// RUN:   -save-temps=obj -c %s -o %t/parallel-jobs-save-temps.o
+// RUN: llvm-objdump -t %t/parallel-jobs-save-temps.o | FileCheck %s
+// RUN: ls %t | FileCheck -check-prefix=TEMPS %s
+
+// CHECK: parallel_jobs_function
+
+// TEMPS: parallel-jobs-save-temps.bc
+// TEMPS: parallel-jobs-save-temps.i
+// TEMPS: parallel-jobs-save-temps.s
+
+int parallel_jobs_function(void) { return 0; }
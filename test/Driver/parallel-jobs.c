@@ -0,0 +1,24 @@
+// RUN: %clang -### -fparallel-jobs=4 -c %s 2>&1 | FileCheck -check-prefix=CHECK-ARG %s
+// CHECK-ARG-NOT: argument unused
+// CHECK-ARG-NOT: "-fparallel-jobs
+
+// RUN: %clang -### -fparallel-jobs=0 -c %s 2>&1 | FileCheck -check-prefix=CHECK-ZERO %s
+// CHECK-ZERO: invalid integral value '0' in '-fparallel-jobs=0'
+
+// Output of parallel jobs appears in job order.
+// RUN: %clang -fsyntax-only -fparallel-jobs=2 %s %S/Inputs/parallel-jobs-b.c 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHECK-ORDER %s
+// CHECK-ORDER: parallel-jobs.c:{{.*}}: warning: first input
+// CHECK-ORDER: parallel-jobs-b.c:{{.*}}: warning: second input
+
+// Nothing after the first failing job is reported, as in a serial build.
+// RUN: not %clang -fsyntax-only -fparallel-jobs=2 -DFAIL %s \
+// RUN:   %S/Inputs/parallel-jobs-b.c 2>&1 | FileCheck -check-prefix=CHECK-FAIL %s
+// CHECK-FAIL: parallel-jobs.c:{{.*}}: error: first input failed
+// CHECK-FAIL-NOT: second input
+
+#ifdef FAIL
+#error first input failed
+#else
+#warning first input
+#endif
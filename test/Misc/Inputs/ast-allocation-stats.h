@@ -0,0 +1,5 @@
+struct HeaderStruct {
+  int x = 1;
+};
+
+const int header_value = 2;
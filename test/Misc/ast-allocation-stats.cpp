@@ -0,0 +1,24 @@
+// RUN: %clang_cc1 -fsyntax-only -print-stats -I %S/Inputs %s 2>&1 | FileCheck %s
+
+#include "ast-allocation-stats.h"
+
+int twice(int n) { return n + n; }
+
+int use() { return twice(header_value) + HeaderStruct().x; }
+
+// CHECK: *** AST Allocation Stats:
+// CHECK-NEXT: {
+// CHECK-NEXT:   "allocator": {"slabs": {{[1-9][0-9]*}}, "total_bytes": {{[0-9]+}}, "allocated_bytes": {{[0-9]+}}, "slack_bytes": {{[0-9]+}}, "untagged_bytes": {{[0-9]+}}},
+// CHECK-NEXT:   "decls": [
+// CHECK-DAG:     {"kind": "Function", "count": 2, "bytes": {{[1-9][0-9]*}}}
+// CHECK-DAG:     {"kind": "CXXRecord", "count": {{[1-9][0-9]*}}, "bytes": {{[1-9][0-9]*}}}
+// CHECK:   "stmts": [
+// CHECK-DAG:     {"kind": "ReturnStmt", "count": 2, "bytes": {{[1-9][0-9]*}}}
+// CHECK-DAG:     {"kind": "BinaryOperator", "count": 2, "bytes": {{[1-9][0-9]*}}}
+// CHECK:   "types": [
+// CHECK-DAG:     {"kind": "FunctionProto", "count": {{[1-9][0-9]*}}, "bytes": {{[1-9][0-9]*}}}
+// CHECK:   "files": [
+// CHECK-DAG:     {"file": "{{.*}}ast-allocation-stats.cpp", "count": {{[1-9][0-9]*}}, "bytes": {{[1-9][0-9]*}}}
+// CHECK-DAG:     {"file": "{{.*}}Inputs{{/|\\\\}}ast-allocation-stats.h", "count": {{[1-9][0-9]*}}, "bytes": {{[1-9][0-9]*}}}
+// CHECK:   ]
+// CHECK-NEXT: }
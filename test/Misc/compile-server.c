@@ -0,0 +1,34 @@
+// REQUIRES: shell
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: (echo "%t -fsyntax-only -I %S/Inputs/compile-server %s"; \
+// RUN:  echo "%t -fsyntax-only -I %S/Inputs/compile-server -DERR %s"; \
+// RUN:  echo "%t -fsyntax-only -mllvm -debug-pass=Structure %s"; \
+// RUN:  echo "%t -emit-llvm -I %S/Inputs/compile-server %s -o out.ll") \
+// RUN:   | clang-compile-server -stdio -print-stats \
+// RUN:       -immutable-dir %S/Inputs/compile-server 2> %t/stats \
+// RUN:   | FileCheck %s
+// RUN: FileCheck -check-prefix=CHECK-STATS %s < %t/stats
+// RUN: FileCheck -check-prefix=CHECK-IR %s < %t/out.ll
+
+// CHECK: {{^}}0 0{{$}}
+// CHECK-NEXT: {{^}}1 {{[0-9]+$}}
+// CHECK-NEXT: compile-server.c:{{[0-9]+}}:{{[0-9]+}}: error: unknown type name 'err'
+// CHECK: {{^}}1 {{[0-9]+$}}
+// CHECK-NEXT: error: -mllvm is not supported by the compile server
+// CHECK-NEXT: {{^}}0 0{{$}}
+
+// The header lives in an immutable directory, so only the first request
+// reads it from disk.
+// CHECK-STATS: requests: 4
+// CHECK-STATS: buffer cache hits: 2
+// CHECK-STATS: buffer cache misses: 1
+
+// CHECK-IR: define i32 @use_header()
+
+#include "compile-server.h"
+
+#ifdef ERR
+err x;
+#endif
+
+int use_header(void) { return from_header(); }
@@ -0,0 +1,79 @@
+// Test instantiating templates while building a PCH.
+
+// The instantiations used by the header are performed while building the PCH,
+// and only those whose template is defined later are left to the TU.
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -std=c++11 -x c++-header -emit-pch -fpch-instantiate-templates -o %t.pch %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -std=c++11 -include-pch %t.pch -emit-llvm -o - %s | FileCheck %s
+
+// The PCH itself holds the instantiated bodies, which it does not without
+// -fpch-instantiate-templates.
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -std=c++11 -x ast -ast-dump-all %t.pch \
+// RUN:   | FileCheck %s --check-prefix=PCH-AST
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -std=c++11 -x c++-header -emit-pch -o %t.noinst.pch %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -std=c++11 -x ast -ast-dump-all %t.noinst.pch \
+// RUN:   | FileCheck %s --check-prefix=NOPCH-AST
+
+// Instantiation errors are diagnosed while building the PCH.
+// RUN: not %clang_cc1 -std=c++11 -x c++-header -emit-pch -fpch-instantiate-templates -DERROR -o %t.err.pch %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=ERROR
+
+// Without -fpch-instantiate-templates, they are diagnosed by the TU.
+// RUN: %clang_cc1 -std=c++11 -x c++-header -emit-pch -DERROR -o %t.err.pch %s
+// RUN: not %clang_cc1 -std=c++11 -include-pch %t.err.pch -fsyntax-only %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=ERROR
+
+// RUN: %clang -### -fpch-instantiate-templates -c %s 2>&1 | FileCheck %s --check-prefix=DRIVER
+// RUN: %clang -### -fpch-instantiate-templates -fno-pch-instantiate-templates -c %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=NODRIVER
+
+#ifndef HEADER
+#define HEADER
+
+template <typename T> struct Box {
+  T value;
+  T get() const;
+#ifdef ERROR
+  void bad() { T::error; }
+#endif
+};
+template <typename T> T Box<T>::get() const { return value; }
+
+template <typename T> T twice(T t) { return t + t; }
+
+inline int useBox() { return Box<int>{21}.get(); }
+inline int useTwice() { return twice(21); }
+
+#ifdef ERROR
+inline void useBad() { Box<int>().bad(); }
+#endif
+
+template <typename T> T later(T t);
+inline int useLater() { return later(1); }
+
+#else
+
+template <typename T> T later(T t) { return t; }
+
+int main() { return useBox() + useTwice() + useLater(); }
+
+#endif
+
+// CHECK-DAG: define linkonce_odr i32 @_ZNK3BoxIiE3getEv(
+// CHECK-DAG: define linkonce_odr i32 @_Z5twiceIiET_S0_(
+// CHECK-DAG: define linkonce_odr i32 @_Z5laterIiET_S0_(
+
+// PCH-AST: FunctionDecl {{.*}} twice 'int (int)'
+// PCH-AST-NEXT: TemplateArgument type 'int'
+// PCH-AST-NEXT: ParmVarDecl {{.*}} t 'int
+// PCH-AST-NEXT: CompoundStmt
+// PCH-AST: FunctionDecl {{.*}} useBox
+
+// NOPCH-AST: FunctionDecl {{.*}} twice 'int (int)'
+// NOPCH-AST-NOT: CompoundStmt
+// NOPCH-AST: FunctionDecl {{.*}} useBox
+
+// ERROR: error: type 'int' cannot be used prior to '::' because it has no members
+// ERROR-NOT: error:
+
+// DRIVER: "-fpch-instantiate-templates"
+// NODRIVER-NOT: "-fpch-instantiate-templates"
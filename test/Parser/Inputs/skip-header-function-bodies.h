@@ -0,0 +1,8 @@
+inline int header_inline() { return 1; }
+
+struct HeaderClass {
+  int method() { return 2; }
+  constexpr int cmethod() const { return 3; }
+};
+
+template <typename T> T header_template(T t) { return t + 1; }
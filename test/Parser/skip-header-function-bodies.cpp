@@ -0,0 +1,33 @@
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -skip-header-function-bodies -I %S/Inputs -ast-dump %s | FileCheck %s
+// RUN: env CINDEXTEST_SKIP_HEADER_FUNCTION_BODIES=1 c-index-test -test-load-source all -std=c++11 -I %S/Inputs %s | FileCheck -check-prefix=CHECK-INDEX %s
+
+#include "skip-header-function-bodies.h"
+
+int main_file() { return header_inline() + header_template(4); }
+
+// Bodies outside the main file are skipped...
+// CHECK: FunctionDecl {{.*}} header_inline 'int ()'
+// CHECK-NOT: CompoundStmt
+// CHECK: CXXRecordDecl {{.*}} struct HeaderClass definition
+// CHECK: CXXMethodDecl {{.*}} method 'int ()'
+// CHECK-NOT: CompoundStmt
+
+// ...unless they may be needed to parse the rest of the file...
+// CHECK: CXXMethodDecl {{.*}} cmethod 'int () const'
+// CHECK-NEXT: CompoundStmt
+
+// ...or a template gets instantiated.
+// CHECK: FunctionTemplateDecl {{.*}} header_template
+// CHECK: FunctionDecl {{.*}} used header_template 'int (int)'
+// CHECK-NEXT: TemplateArgument type 'int'
+// CHECK-NEXT: ParmVarDecl
+// CHECK-NEXT: CompoundStmt
+
+// CHECK: FunctionDecl {{.*}} main_file 'int ()'
+// CHECK-NEXT: CompoundStmt
+
+// Cursor visitation parses skipped bodies on demand.
+// CHECK-INDEX: skip-header-function-bodies.h:1:12: FunctionDecl=header_inline:1:12 (Definition)
+// CHECK-INDEX-NEXT: skip-header-function-bodies.h:1:28: CompoundStmt=
+// CHECK-INDEX: skip-header-function-bodies.h:4:7: CXXMethod=method:4:7 (Definition)
+// CHECK-INDEX-NEXT: skip-header-function-bodies.h:4:16: CompoundStmt=
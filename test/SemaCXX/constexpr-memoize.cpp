@@ -0,0 +1,36 @@
+// RUN: %clang_cc1 -std=c++1y -fsyntax-only -verify %s -fconstexpr-steps 150
+// RUN: %clang_cc1 -std=c++1y -fsyntax-only -print-stats %s -DSTATS 2>&1 \
+// RUN:   | FileCheck %s
+
+// Calls whose arguments are literal values reuse memoized results, but are
+// still charged the steps and depth their evaluation took.
+
+// This takes n + 4 steps; see constexpr-steps.cpp.
+constexpr int sum(int n) {
+  int s = 0;
+  for (int k = 0; k != n; ++k)
+    s += k; // expected-note {{step limit}}
+  return s;
+}
+
+constexpr int a = sum(100);
+static_assert(a == 4950, "");
+static_assert(sum(100) == 4950, "");
+#ifndef STATS
+constexpr int b = sum(100) + sum(100); // expected-error {{constant expression}} expected-note {{in call to 'sum(100)'}}
+#endif
+
+constexpr int fib(int n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }
+static_assert(fib(6) == 8, "");
+
+struct Pair { int a, b; };
+constexpr Pair swap(Pair p) { return {p.b, p.a}; }
+static_assert(swap({1, 2}).a == 2 && swap({1, 2}).b == 1, "");
+static_assert(swap({3, 4}).a == 4, "");
+
+// Calls with lvalue arguments are not memoized.
+constexpr int deref(const int *p) { return *p; }
+constexpr int x = 1, y = 2;
+static_assert(deref(&x) == 1 && deref(&y) == 2, "");
+
+// CHECK: {{[1-9][0-9]*}} hits, {{[1-9][0-9]*}} misses in the {{[1-9][0-9]*}} memoized constexpr calls, saving {{[1-9][0-9]*}} evaluation steps
@@ -0,0 +1,54 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only %s -print-stats 2>&1 | FileCheck %s
+
+// Declarations in a namespace with a very large lookup table are only added
+// to it when their name is looked up. Check that lookup still finds them.
+
+#define DECL1(p) int p##0, p##1, p##2, p##3, p##4, p##5, p##6, p##7, p##8, p##9;
+#define DECL2(p) DECL1(p##0) DECL1(p##1) DECL1(p##2) DECL1(p##3) DECL1(p##4) \
+                 DECL1(p##5) DECL1(p##6) DECL1(p##7) DECL1(p##8) DECL1(p##9)
+#define DECL3(p) DECL2(p##0) DECL2(p##1) DECL2(p##2) DECL2(p##3) DECL2(p##4) \
+                 DECL2(p##5) DECL2(p##6) DECL2(p##7) DECL2(p##8) DECL2(p##9)
+
+namespace big {
+  void f(int);
+  struct S {};
+  DECL3(a)
+  DECL3(b)
+  DECL3(c)
+  DECL3(d)
+  DECL3(e)
+
+  void f(double);
+  void g(int);
+  struct S;
+  struct T {};
+  void g(double);
+  extern int e999;
+
+  int h(int); // expected-note {{previous declaration is here}}
+  long h(int); // expected-error {{functions that differ only in their return type cannot be overloaded}}
+}
+
+namespace big {
+  int x = a0 + e999;
+  void use() {
+    f(1);
+    f(1.0);
+    g(1);
+    g(1.0);
+    S s;
+    T t;
+  }
+}
+
+int y = big::d123 + big::b0;
+void (*pf)(double) = big::f;
+void (*pg)(int) = big::g;
+big::S *ps;
+using big::e998;
+int z = e998;
+
+int w = big::nope; // expected-error {{no member named 'nope' in namespace 'big'}}
+
+// CHECK: declarations in 1 large lookup tables added on demand, {{saving up to|costing}} {{[0-9]+}} bytes net of {{[1-9][0-9]*}} bytes of pending declarations
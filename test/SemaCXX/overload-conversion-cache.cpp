@@ -0,0 +1,79 @@
+// RUN: %clang_cc1 -fsyntax-only -verify -std=c++11 %s
+
+// Overload resolution reuses the conversion sequences it formed for arguments
+// of class type, and skips candidates that such an argument obviously cannot
+// be passed to. Check that the same candidates are still picked, and that
+// the same diagnostics are still produced.
+
+struct Stream {};
+struct NoConversions {};
+struct ToInt { operator int() const; };
+struct Base {};
+struct Derived : Base {};
+
+int &operator<<(Stream &, int); // expected-note {{candidate function not viable: no known conversion from 'NoConversions' to 'int' for 2nd argument}}
+float &operator<<(Stream &, double); // expected-note {{candidate function not viable: no known conversion from 'NoConversions' to 'double' for 2nd argument}}
+char &operator<<(Stream &, const char *); // expected-note {{candidate function not viable: no known conversion from 'NoConversions' to 'const char *' for 2nd argument}}
+long &operator<<(Stream &, const Base &); // expected-note {{candidate function not viable: no known conversion from 'NoConversions' to}}
+
+void repeated(Stream &S, ToInt T, const Derived &D) {
+  int &I1 = S << T;
+  int &I2 = S << T;
+  int &I3 = S << ToInt();
+  long &L1 = S << D;
+  long &L2 = S << Derived();
+  long &L3 = S << D;
+}
+
+void noConversions(Stream &S, NoConversions N) {
+  S << N; // expected-error {{invalid operands to binary expression ('Stream' and 'NoConversions')}}
+}
+
+// A class that is incomplete when a conversion is first attempted can gain
+// conversion functions later.
+struct Later;
+Later &later();
+void takesInt(int); // expected-note {{candidate function not viable: cannot convert argument of incomplete type 'Later' to 'int' for 1st argument}}
+void takesInt(double); // expected-note {{candidate function not viable: cannot convert argument of incomplete type 'Later' to 'double' for 1st argument}}
+
+void useIncomplete() {
+  takesInt(later()); // expected-error {{no matching function for call to 'takesInt'}}
+}
+
+struct Later { operator int() const; };
+
+void useComplete() {
+  takesInt(later());
+  takesInt(later());
+}
+
+// Conversions to a class type consider its converting constructors.
+struct FromInt { FromInt(int); };
+struct FromToInt { FromToInt(ToInt); };
+int &convert(FromInt);
+float &convert(FromToInt);
+
+void constructors(ToInt T) {
+  float &F1 = convert(T);
+  float &F2 = convert(T);
+  int &I1 = convert(1);
+}
+
+// A conversion function can return a pointer to a class that only becomes
+// derived from the target class once it is defined.
+struct LaterDerived;
+struct LaterBase {};
+struct ToLaterDerived { operator LaterDerived *(); };
+void takesLaterBase(LaterBase *); // expected-note {{candidate function not viable: no known conversion from 'ToLaterDerived' to 'LaterBase *' for 1st argument}}
+void takesLaterBase(int); // expected-note {{candidate function not viable: no known conversion from 'ToLaterDerived' to 'int' for 1st argument}}
+
+void useBeforeDerived(ToLaterDerived A) {
+  takesLaterBase(A); // expected-error {{no matching function for call to 'takesLaterBase'}}
+}
+
+struct LaterDerived : LaterBase {};
+
+void useAfterDerived(ToLaterDerived A) {
+  takesLaterBase(A);
+  takesLaterBase(A);
+}
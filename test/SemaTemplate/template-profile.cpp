@@ -0,0 +1,31 @@
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -ftemplate-profile=%t %s
+// RUN: FileCheck %s < %t
+// RUN: %clang -### -ftemplate-profile=%t -c %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=DRIVER
+
+template <typename T> struct Box {
+  T value;
+  T get() const { return value; }
+};
+
+template <typename T> T twice(T t) { return t + t; }
+
+namespace ns {
+template <typename T> struct Pair { T first, second; };
+}
+
+int use() {
+  ns::Pair<Box<int>> p = {{1}, {2}};
+  return p.first.get() + twice(1) + twice(2L) + twice(3);
+}
+
+// One line per activity and template: the activity, its count, time in
+// microseconds, bytes allocated in the ASTContext, and the template name.
+// CHECK-DAG: {{^}}class 1 {{[0-9]+}} {{[0-9]+}} Box{{$}}
+// CHECK-DAG: {{^}}class 1 {{[0-9]+}} {{[0-9]+}} ns::Pair{{$}}
+// CHECK-DAG: {{^}}function 1 {{[0-9]+}} {{[0-9]+}} Box::get{{$}}
+// CHECK-DAG: {{^}}function 2 {{[0-9]+}} {{[0-9]+}} twice{{$}}
+// CHECK-DAG: {{^}}deduction 3 {{[0-9]+}} {{[0-9]+}} twice{{$}}
+// CHECK-DAG: {{^}}subst-type {{[0-9]+}} {{[0-9]+}} {{[0-9]+}} ns::Pair{{$}}
+
+// DRIVER: "-ftemplate-profile={{[^"]+}}"
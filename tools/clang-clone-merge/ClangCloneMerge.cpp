@@ -0,0 +1,309 @@
+//===- ClangCloneMerge.cpp - Find clones across translation units ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This tool merges the clone fingerprints that the alpha.clone.CloneChecker
+// writes for each translation unit when its FingerprintDir option is set, and
+// prints the groups of type II clones found across all of them.
+//
+// The fingerprints are sorted by hash, so that each group of clones is a run
+// of equal hashes. Fingerprints with the same hash but different profiles
+// come from a hash collision and are put in separate groups. Like the
+// OnlyLargestCloneConstraint, groups whose clones are all part of the clones
+// of another group are not printed.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Analysis/CloneDetection.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <tuple>
+
+using namespace llvm;
+using namespace clang;
+
+static cl::list<std::string>
+    Inputs(cl::Positional, cl::OneOrMore,
+           cl::desc("<fingerprint files or directories>"));
+
+static cl::opt<unsigned>
+    MinGroupSize("min-group-size", cl::init(2),
+                 cl::desc("The minimum number of clones in a group"));
+
+static cl::opt<bool>
+    PrintStats("print-stats",
+               cl::desc("Print statistics and throughput to stderr"));
+
+/// Reads a fingerprint file into the set.
+static bool readFile(StringRef Path, CloneFingerprintSet &Set) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer = MemoryBuffer::getFile(Path);
+  if (!Buffer) {
+    errs() << "error: could not read '" << Path
+           << "': " << Buffer.getError().message() << '\n';
+    return false;
+  }
+  if (!Set.read((*Buffer)->getBuffer())) {
+    errs() << "error: '" << Path << "' is not a clone fingerprint file\n";
+    return false;
+  }
+  return true;
+}
+
+/// Reads a fingerprint file, or all the fingerprint files in a directory and
+/// its subdirectories, into the set.
+static bool readInput(StringRef Path, CloneFingerprintSet &Set) {
+  if (!sys::fs::is_directory(Path))
+    return readFile(Path, Set);
+
+  // Read the files in a deterministic order.
+  std::vector<std::string> Files;
+  std::error_code EC;
+  for (sys::fs::recursive_directory_iterator I(Path, EC), E; I != E && !EC;
+       I.increment(EC))
+    if (sys::path::extension(I->path()) == ".clonefp")
+      Files.push_back(I->path());
+  if (EC) {
+    errs() << "error: could not read directory '" << Path
+           << "': " << EC.message() << '\n';
+    return false;
+  }
+
+  std::sort(Files.begin(), Files.end());
+  for (const std::string &File : Files)
+    if (!readFile(File, Set))
+      return false;
+  return true;
+}
+
+namespace {
+/// A group of clones, as a range of the sorted fingerprints.
+struct CloneGroup {
+  unsigned Begin, End;
+  unsigned size() const { return End - Begin; }
+};
+} // end anonymous namespace
+
+static std::tuple<unsigned, unsigned, unsigned>
+getBegin(const CloneFingerprint &FP) {
+  return std::make_tuple(FP.File, FP.BeginLine, FP.BeginColumn);
+}
+
+static std::tuple<unsigned, unsigned, unsigned>
+getEnd(const CloneFingerprint &FP) {
+  return std::make_tuple(FP.File, FP.EndLine, FP.EndColumn);
+}
+
+/// Returns true if the range of \p Outer contains the range of \p Inner.
+static bool contains(const CloneFingerprint &Outer,
+                     const CloneFingerprint &Inner) {
+  return Outer.File == Inner.File && getBegin(Outer) <= getBegin(Inner) &&
+         getEnd(Inner) <= getEnd(Outer);
+}
+
+/// Removes the groups whose clones are each contained in a clone of another
+/// group.
+static void keepOnlyLargestClones(ArrayRef<CloneFingerprint> Fingerprints,
+                                  std::vector<CloneGroup> &Groups) {
+  // Sort the clones of all groups by their start and, for the same start, by
+  // decreasing end, so that the clones that contain a clone come before it.
+  struct Member {
+    unsigned Group;
+    const CloneFingerprint *FP;
+  };
+  std::vector<Member> Members;
+  for (unsigned G = 0; G < Groups.size(); ++G)
+    for (unsigned I = Groups[G].Begin; I != Groups[G].End; ++I)
+      Members.push_back({G, &Fingerprints[I]});
+  std::sort(Members.begin(), Members.end(),
+            [](const Member &L, const Member &R) {
+              return std::make_tuple(getBegin(*L.FP), getEnd(*R.FP)) <
+                     std::make_tuple(getBegin(*R.FP), getEnd(*L.FP));
+            });
+
+  // The largest end of the clones up to each position, which ends the search
+  // for the clones that contain a clone.
+  std::vector<std::tuple<unsigned, unsigned, unsigned>> MaxEnd;
+  MaxEnd.reserve(Members.size());
+  for (unsigned I = 0; I < Members.size(); ++I) {
+    auto End = getEnd(*Members[I].FP);
+    MaxEnd.push_back(I && std::get<0>(MaxEnd[I - 1]) == std::get<0>(End)
+                         ? std::max(MaxEnd[I - 1], End)
+                         : End);
+  }
+
+  // The position of the first clone of each group.
+  std::vector<unsigned> FirstMember(Groups.size(), Members.size());
+  for (unsigned I = 0; I < Members.size(); ++I)
+    FirstMember[Members[I].Group] = std::min(FirstMember[Members[I].Group], I);
+
+  auto ContainsGroup = [&](unsigned Outer, unsigned Inner) {
+    if (Groups[Outer].size() < Groups[Inner].size())
+      return false;
+    for (unsigned I = Groups[Inner].Begin; I != Groups[Inner].End; ++I) {
+      bool Contained = false;
+      for (unsigned J = Groups[Outer].Begin; J != Groups[Outer].End; ++J)
+        if (contains(Fingerprints[J], Fingerprints[I])) {
+          Contained = true;
+          break;
+        }
+      if (!Contained)
+        return false;
+    }
+    return true;
+  };
+
+  // A group is dropped if another group contains it, unless both contain each
+  // other, as their clones have the same ranges; then the first one is kept.
+  auto Covers = [&](unsigned Outer, unsigned Inner) {
+    return ContainsGroup(Outer, Inner) &&
+           !(Inner < Outer && ContainsGroup(Inner, Outer));
+  };
+
+  std::vector<bool> Remove(Groups.size());
+  for (unsigned G = 0; G < Groups.size(); ++G) {
+    unsigned Pos = FirstMember[G];
+    const CloneFingerprint &First = *Members[Pos].FP;
+    auto FirstEnd = getEnd(First);
+
+    // The clones with the same range come right after it.
+    for (unsigned I = Pos + 1; I < Members.size(); ++I) {
+      const CloneFingerprint &Other = *Members[I].FP;
+      if (getBegin(Other) != getBegin(First) || getEnd(Other) != FirstEnd)
+        break;
+      if (Members[I].Group != G && Covers(Members[I].Group, G)) {
+        Remove[G] = true;
+        break;
+      }
+    }
+
+    // The other clones that contain it come before it.
+    for (unsigned I = Pos; I-- > 0 && !Remove[G];) {
+      if (std::get<0>(MaxEnd[I]) != First.File || MaxEnd[I] < FirstEnd)
+        break;
+      if (Members[I].Group != G && contains(*Members[I].FP, First) &&
+          Covers(Members[I].Group, G))
+        Remove[G] = true;
+    }
+  }
+
+  unsigned Kept = 0;
+  for (unsigned G = 0; G < Groups.size(); ++G)
+    if (!Remove[G])
+      Groups[Kept++] = Groups[G];
+  Groups.resize(Kept);
+}
+
+int main(int argc, const char **argv) {
+  sys::PrintStackTraceOnErrorSignal(argv[0]);
+  cl::ParseCommandLineOptions(
+      argc, argv, "Finds type II clones across translation units.\n");
+
+  TimeRecord Start = TimeRecord::getCurrentTime();
+
+  CloneFingerprintSet Set;
+  for (const std::string &Input : Inputs)
+    if (!readInput(Input, Set))
+      return 1;
+
+  TimeRecord Read = TimeRecord::getCurrentTime();
+
+  // Sort the fingerprints by hash, and drop the duplicates that come from a
+  // header included in several translation units. The set gives each path
+  // a single index, so the indexes can be compared instead of the paths.
+  std::vector<CloneFingerprint> &Fingerprints = Set.Fingerprints;
+  auto Key = [](const CloneFingerprint &FP) {
+    return std::make_tuple(FP.Hash, FP.Profile, FP.File, FP.BeginLine,
+                           FP.BeginColumn, FP.EndLine, FP.EndColumn);
+  };
+  std::sort(Fingerprints.begin(), Fingerprints.end(),
+            [&Key](const CloneFingerprint &L, const CloneFingerprint &R) {
+              return Key(L) < Key(R);
+            });
+  Fingerprints.erase(
+      std::unique(Fingerprints.begin(), Fingerprints.end(),
+                  [&Key](const CloneFingerprint &L, const CloneFingerprint &R) {
+                    return Key(L) == Key(R);
+                  }),
+      Fingerprints.end());
+
+  // The clones of a group must have the same profile as well as the same
+  // hash; otherwise their hashes collided.
+  std::vector<CloneGroup> Groups;
+  unsigned NumCollisions = 0;
+  for (unsigned I = 0; I < Fingerprints.size();) {
+    unsigned End = I + 1;
+    while (End < Fingerprints.size() &&
+           Fingerprints[End].Hash == Fingerprints[I].Hash &&
+           Fingerprints[End].Profile == Fingerprints[I].Profile)
+      ++End;
+    if (End - I >= MinGroupSize)
+      Groups.push_back({I, End});
+    if (I && Fingerprints[I - 1].Hash == Fingerprints[I].Hash)
+      ++NumCollisions;
+    I = End;
+  }
+  unsigned NumCandidateGroups = Groups.size();
+
+  keepOnlyLargestClones(Fingerprints, Groups);
+
+  TimeRecord Grouped = TimeRecord::getCurrentTime();
+
+  // Print the clones of each group, and the groups, in the order of their
+  // file names and positions.
+  auto Location = [&Set](const CloneFingerprint &FP) {
+    return std::make_tuple(StringRef(Set.Files[FP.File]), FP.BeginLine,
+                           FP.BeginColumn, FP.EndLine, FP.EndColumn);
+  };
+  for (const CloneGroup &Group : Groups)
+    std::sort(Fingerprints.begin() + Group.Begin,
+              Fingerprints.begin() + Group.End,
+              [&](const CloneFingerprint &L, const CloneFingerprint &R) {
+                return Location(L) < Location(R);
+              });
+  std::sort(Groups.begin(), Groups.end(),
+            [&](const CloneGroup &L, const CloneGroup &R) {
+              return Location(Fingerprints[L.Begin]) <
+                     Location(Fingerprints[R.Begin]);
+            });
+  for (const CloneGroup &Group : Groups) {
+    outs() << "clone group (" << Group.size() << " clones):\n";
+    for (unsigned I = Group.Begin; I != Group.End; ++I) {
+      const CloneFingerprint &FP = Fingerprints[I];
+      outs() << "  " << Set.Files[FP.File] << ':' << FP.BeginLine << ':'
+             << FP.BeginColumn << '-' << FP.EndLine << ':' << FP.EndColumn
+             << '\n';
+    }
+  }
+
+  if (PrintStats) {
+    double ReadTime = Read.getWallTime() - Start.getWallTime();
+    double GroupTime = Grouped.getWallTime() - Read.getWallTime();
+    double TotalTime = ReadTime + GroupTime;
+    errs() << "translation units: " << Set.NumTranslationUnits << '\n'
+           << "lines: " << Set.NumLines << '\n'
+           << "fingerprints: " << Fingerprints.size() << '\n'
+           << "hash collisions: " << NumCollisions << '\n'
+           << "candidate groups: " << NumCandidateGroups << '\n'
+           << "clone groups: " << Groups.size() << '\n';
+    errs() << "read time: " << format("%.3f", ReadTime) << " s\n"
+           << "group time: " << format("%.3f", GroupTime) << " s\n";
+    if (TotalTime > 0)
+      errs() << "throughput: "
+             << format("%.0f", Set.NumLines / TotalTime) << " lines/s, "
+             << format("%.0f", Fingerprints.size() / TotalTime)
+             << " fingerprints/s\n";
+  }
+
+  return 0;
+}
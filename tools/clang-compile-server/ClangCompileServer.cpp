@@ -0,0 +1,602 @@
+//===-- ClangCompileServer.cpp - Long-lived server for cc1 invocations ----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// A local compile server that runs -cc1 invocations submitted over a Unix
+// socket (or, for testing, on stdin). Every request gets a CompilerInstance,
+// and therefore an ASTContext, of its own. What is kept warm between requests
+// is read-only file system state: the status and contents of files in
+// directories that do not change while the server runs (the builtin headers,
+// and any directory passed with -immutable-dir), and the contents of
+// precompiled files, which are revalidated against a fresh stat first.
+//
+// Requests are handled one at a time. A request is a single line holding the
+// working directory followed by the -cc1 arguments (without "-cc1"), quoted
+// like a GNU response file. The response is a "<status> <length>" line
+// followed by <length> bytes of diagnostics.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/DiagnosticOptions.h"
+#include "clang/Basic/VirtualFileSystem.h"
+#include "clang/CodeGen/ObjectFilePCHContainerOperations.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/PCHContainerOperations.h"
+#include "clang/Frontend/TextDiagnosticBuffer.h"
+#include "clang/Frontend/TextDiagnosticPrinter.h"
+#include "clang/FrontendTool/Utils.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/StringSaver.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+
+#ifdef LLVM_ON_UNIX
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace clang;
+
+static llvm::cl::opt<std::string>
+    Listen("listen",
+           llvm::cl::desc("Serve requests on this Unix socket, which only "
+                          "the current user can connect to"),
+           llvm::cl::value_desc("path"));
+
+static llvm::cl::opt<std::string>
+    Connect("connect",
+            llvm::cl::desc("Submit the positional arguments as a -cc1 "
+                           "invocation to the server on this Unix socket"),
+            llvm::cl::value_desc("path"));
+
+static llvm::cl::opt<bool>
+    Shutdown("shutdown", llvm::cl::desc("With -connect, stop the server"));
+
+static llvm::cl::opt<bool>
+    Stdio("stdio", llvm::cl::desc("Serve requests read from stdin"));
+
+static llvm::cl::list<std::string> ImmutableDirs(
+    "immutable-dir", llvm::cl::ZeroOrMore,
+    llvm::cl::desc("Directory whose contents do not change while the server "
+                   "runs (the builtin headers are always assumed to be)"));
+
+static llvm::cl::opt<bool>
+    PrintStats("print-stats",
+               llvm::cl::desc("Print cache statistics on exit"));
+
+static llvm::cl::list<std::string>
+    CC1Args(llvm::cl::Positional, llvm::cl::ZeroOrMore,
+            llvm::cl::desc("<cc1 arguments>"));
+
+static const char ShutdownRequest[] = "!shutdown";
+
+namespace {
+
+/// A file system that remembers the status of files in immutable directories,
+/// and keeps the contents of those files and of precompiled files in memory.
+/// Cached contents are reused only while the size, modification time and
+/// identity of the file on disk stay the same.
+class CachingFileSystem : public vfs::FileSystem {
+  struct CachedBuffer {
+    vfs::Status Status;
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  };
+
+  IntrusiveRefCntPtr<vfs::FileSystem> Base;
+  std::vector<std::string> ImmutableDirs;
+  llvm::StringMap<llvm::ErrorOr<vfs::Status>> StatusCache;
+  llvm::StringMap<CachedBuffer> Buffers;
+
+  /// Buffers replaced during the current request. Files opened earlier in the
+  /// request may still refer to them.
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> RetiredBuffers;
+
+  class CachingFile;
+
+  std::string getKey(const Twine &Path) const;
+  bool isImmutable(StringRef Key) const;
+  bool isCacheable(StringRef Key) const;
+
+public:
+  unsigned NumStatusHits = 0;
+  unsigned NumStatusMisses = 0;
+  unsigned NumBufferHits = 0;
+  unsigned NumBufferMisses = 0;
+
+  CachingFileSystem(IntrusiveRefCntPtr<vfs::FileSystem> Base,
+                    ArrayRef<std::string> Dirs);
+
+  /// Drops state that was only kept alive for the request that just ended.
+  void endRequest() { RetiredBuffers.clear(); }
+
+  llvm::ErrorOr<vfs::Status> status(const Twine &Path) override;
+  llvm::ErrorOr<std::unique_ptr<vfs::File>>
+  openFileForRead(const Twine &Path) override;
+  vfs::directory_iterator dir_begin(const Twine &Dir,
+                                    std::error_code &EC) override {
+    return Base->dir_begin(Dir, EC);
+  }
+  std::error_code setCurrentWorkingDirectory(const Twine &Path) override {
+    return Base->setCurrentWorkingDirectory(Path);
+  }
+  llvm::ErrorOr<std::string> getCurrentWorkingDirectory() const override {
+    return Base->getCurrentWorkingDirectory();
+  }
+};
+
+/// A file opened through the CachingFileSystem. Its contents either come from
+/// the cache, or are read from the underlying file and added to the cache.
+class CachingFileSystem::CachingFile : public vfs::File {
+  CachingFileSystem &FS;
+  std::string Key;
+  vfs::Status Status;
+  std::unique_ptr<vfs::File> Underlying;
+  const llvm::MemoryBuffer *Cached;
+
+public:
+  CachingFile(CachingFileSystem &FS, StringRef Key, vfs::Status Status,
+              std::unique_ptr<vfs::File> Underlying,
+              const llvm::MemoryBuffer *Cached)
+      : FS(FS), Key(Key), Status(std::move(Status)),
+        Underlying(std::move(Underlying)), Cached(Cached) {}
+  ~CachingFile() override { close(); }
+
+  llvm::ErrorOr<vfs::Status> status() override { return Status; }
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+  getBuffer(const Twine &Name, int64_t FileSize, bool RequiresNullTerminator,
+            bool IsVolatile) override {
+    if (!Cached) {
+      if (!Underlying)
+        return std::make_error_code(std::errc::bad_file_descriptor);
+      if (IsVolatile)
+        return Underlying->getBuffer(Name, FileSize, RequiresNullTerminator,
+                                     IsVolatile);
+
+      // Always ask for a null terminator, so the cached buffer can be handed
+      // out to any later reader.
+      auto Buffer = Underlying->getBuffer(Name, FileSize,
+                                          /*RequiresNullTerminator=*/true,
+                                          /*IsVolatile=*/false);
+      if (!Buffer)
+        return Buffer.getError();
+      CachedBuffer &Entry = FS.Buffers[Key];
+      if (Entry.Buffer)
+        FS.RetiredBuffers.push_back(std::move(Entry.Buffer));
+      Entry.Status = Status;
+      Entry.Buffer = std::move(*Buffer);
+      Cached = Entry.Buffer.get();
+    }
+    return llvm::MemoryBuffer::getMemBuffer(Cached->getBuffer(), Name.str(),
+                                            RequiresNullTerminator);
+  }
+
+  std::error_code close() override {
+    if (Underlying)
+      return Underlying->close();
+    return std::error_code();
+  }
+};
+
+} // end anonymous namespace
+
+CachingFileSystem::CachingFileSystem(IntrusiveRefCntPtr<vfs::FileSystem> Base,
+                                     ArrayRef<std::string> Dirs)
+    : Base(std::move(Base)) {
+  for (const std::string &Dir : Dirs) {
+    std::string Key = getKey(Dir);
+    if (!Key.empty() && !llvm::sys::path::is_separator(Key.back()))
+      Key += llvm::sys::path::get_separator();
+    ImmutableDirs.push_back(std::move(Key));
+  }
+}
+
+std::string CachingFileSystem::getKey(const Twine &Path) const {
+  SmallString<256> Key;
+  Path.toVector(Key);
+  // Requests run in different working directories, so cache by absolute path.
+  if (makeAbsolute(Key))
+    return std::string();
+  llvm::sys::path::remove_dots(Key, /*remove_dot_dot=*/true);
+  return Key.str();
+}
+
+bool CachingFileSystem::isImmutable(StringRef Key) const {
+  for (const std::string &Dir : ImmutableDirs)
+    if (Key.startswith(Dir))
+      return true;
+  return false;
+}
+
+bool CachingFileSystem::isCacheable(StringRef Key) const {
+  StringRef Ext = llvm::sys::path::extension(Key);
+  return isImmutable(Key) || Ext == ".pcm" || Ext == ".pch" || Ext == ".gch";
+}
+
+llvm::ErrorOr<vfs::Status> CachingFileSystem::status(const Twine &Path) {
+  std::string Key = getKey(Path);
+  if (Key.empty() || !isImmutable(Key))
+    return Base->status(Path);
+
+  auto It = StatusCache.find(Key);
+  if (It == StatusCache.end()) {
+    ++NumStatusMisses;
+    It = StatusCache.insert(std::make_pair(Key, Base->status(Key))).first;
+  } else {
+    ++NumStatusHits;
+  }
+  if (!It->second)
+    return It->second.getError();
+  return vfs::Status::copyWithNewName(*It->second, Path.str());
+}
+
+llvm::ErrorOr<std::unique_ptr<vfs::File>>
+CachingFileSystem::openFileForRead(const Twine &Path) {
+  std::string Key = getKey(Path);
+  if (Key.empty() || !isCacheable(Key))
+    return Base->openFileForRead(Path);
+
+  // Files outside of immutable directories are revalidated on every open.
+  llvm::ErrorOr<vfs::Status> Status = isImmutable(Key) ? status(Key)
+                                                       : Base->status(Key);
+  if (!Status)
+    return Status.getError();
+  Status = vfs::Status::copyWithNewName(*Status, Path.str());
+
+  auto It = Buffers.find(Key);
+  if (It != Buffers.end() && It->second.Buffer &&
+      It->second.Status.getUniqueID() == Status->getUniqueID() &&
+      It->second.Status.getSize() == Status->getSize() &&
+      It->second.Status.getLastModificationTime() ==
+          Status->getLastModificationTime()) {
+    ++NumBufferHits;
+    return std::unique_ptr<vfs::File>(llvm::make_unique<CachingFile>(
+        *this, Key, std::move(*Status), nullptr, It->second.Buffer.get()));
+  }
+
+  ++NumBufferMisses;
+  auto File = Base->openFileForRead(Path);
+  if (!File)
+    return File.getError();
+  return std::unique_ptr<vfs::File>(llvm::make_unique<CachingFile>(
+      *this, Key, std::move(*Status), std::move(*File), nullptr));
+}
+
+namespace {
+
+/// The state that outlives individual requests.
+class CompileServer {
+  const char *Argv0;
+  std::shared_ptr<PCHContainerOperations> PCHOps;
+  IntrusiveRefCntPtr<CachingFileSystem> FS;
+  unsigned NumRequests = 0;
+
+public:
+  CompileServer(const char *Argv0, ArrayRef<std::string> Dirs);
+
+  /// Runs the -cc1 invocation \p Args in \p WorkingDir, printing diagnostics
+  /// to \p OS. Returns the exit status cc1 would have returned.
+  int compile(StringRef WorkingDir, ArrayRef<const char *> Args,
+              raw_ostream &OS);
+
+  /// Parses and runs a request line, and writes the response to \p OS.
+  void handleRequest(StringRef Line, raw_ostream &OS);
+
+  void printStats(raw_ostream &OS) const;
+};
+
+} // end anonymous namespace
+
+CompileServer::CompileServer(const char *Argv0, ArrayRef<std::string> Dirs)
+    : Argv0(Argv0), PCHOps(std::make_shared<PCHContainerOperations>()) {
+  PCHOps->registerWriter(llvm::make_unique<ObjectFilePCHContainerWriter>());
+  PCHOps->registerReader(llvm::make_unique<ObjectFilePCHContainerReader>());
+
+  std::vector<std::string> AllDirs(Dirs.begin(), Dirs.end());
+  AllDirs.push_back(CompilerInvocation::GetResourcesPath(
+      Argv0, (void *)(intptr_t)&PrintStats));
+  FS = new CachingFileSystem(vfs::getRealFileSystem(), AllDirs);
+}
+
+int CompileServer::compile(StringRef WorkingDir, ArrayRef<const char *> Args,
+                           raw_ostream &OS) {
+  ++NumRequests;
+  if (std::error_code EC = FS->setCurrentWorkingDirectory(WorkingDir)) {
+    OS << "error: cannot change to directory '" << WorkingDir
+       << "': " << EC.message() << '\n';
+    return 1;
+  }
+
+  auto Clang = llvm::make_unique<CompilerInstance>(PCHOps);
+
+  IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
+  IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
+  TextDiagnosticBuffer *DiagsBuffer = new TextDiagnosticBuffer;
+  DiagnosticsEngine Diags(DiagID, &*DiagOpts, DiagsBuffer);
+  bool Success = CompilerInvocation::CreateFromArgs(
+      Clang->getInvocation(), Args.begin(), Args.end(), Diags);
+
+  if (Clang->getHeaderSearchOpts().UseBuiltinIncludes &&
+      Clang->getHeaderSearchOpts().ResourceDir.empty())
+    Clang->getHeaderSearchOpts().ResourceDir =
+        CompilerInvocation::GetResourcesPath(Argv0,
+                                             (void *)(intptr_t)&PrintStats);
+
+  Clang->createDiagnostics(
+      new TextDiagnosticPrinter(OS, &Clang->getDiagnosticOpts()));
+  DiagsBuffer->FlushDiagnostics(Clang->getDiagnostics());
+  if (!Success)
+    return 1;
+
+  // -mllvm options would outlive the request, so they are not supported.
+  if (!Clang->getFrontendOpts().LLVMArgs.empty()) {
+    OS << "error: -mllvm is not supported by the compile server\n";
+    return 1;
+  }
+
+  // The server lives on, so everything has to be freed.
+  Clang->getFrontendOpts().DisableFree = false;
+
+  // Layer -ivfsoverlay files on top of the shared caching file system.
+  Clang->setVirtualFileSystem(createVFSFromCompilerInvocation(
+      Clang->getInvocation(), Clang->getDiagnostics(), FS));
+
+  Success = ExecuteCompilerInvocation(Clang.get());
+  Clang.reset();
+  FS->endRequest();
+  return !Success;
+}
+
+void CompileServer::handleRequest(StringRef Line, raw_ostream &OS) {
+  llvm::BumpPtrAllocator Alloc;
+  llvm::StringSaver Saver(Alloc);
+  SmallVector<const char *, 128> Args;
+  llvm::cl::TokenizeGNUCommandLine(Line, Saver, Args);
+
+  std::string Diagnostics;
+  int Status = 1;
+  {
+    llvm::raw_string_ostream DiagOS(Diagnostics);
+    if (Args.empty())
+      DiagOS << "error: empty request\n";
+    else
+      Status = compile(Args[0], makeArrayRef(Args).drop_front(), DiagOS);
+  }
+  OS << Status << ' ' << Diagnostics.size() << '\n' << Diagnostics;
+  OS.flush();
+}
+
+void CompileServer::printStats(raw_ostream &OS) const {
+  OS << "*** Compile server statistics\n"
+     << "  requests: " << NumRequests << '\n'
+     << "  status cache hits: " << FS->NumStatusHits << '\n'
+     << "  status cache misses: " << FS->NumStatusMisses << '\n'
+     << "  buffer cache hits: " << FS->NumBufferHits << '\n'
+     << "  buffer cache misses: " << FS->NumBufferMisses << '\n';
+}
+
+/// Quotes \p Arg so that TokenizeGNUCommandLine reads it back unchanged.
+static void quoteArg(StringRef Arg, raw_ostream &OS) {
+  OS << '"';
+  for (char C : Arg) {
+    if (C == '"' || C == '\\')
+      OS << '\\';
+    OS << C;
+  }
+  OS << '"';
+}
+
+static int serveStdio(CompileServer &Server) {
+  std::string Line;
+  while (std::getline(std::cin, Line)) {
+    if (Line == ShutdownRequest)
+      break;
+    Server.handleRequest(Line, llvm::outs());
+  }
+  return 0;
+}
+
+#ifdef LLVM_ON_UNIX
+static bool readLine(int FD, std::string &Buffer, std::string &Line) {
+  for (;;) {
+    size_t Pos = Buffer.find('\n');
+    if (Pos != std::string::npos) {
+      Line = Buffer.substr(0, Pos);
+      Buffer.erase(0, Pos + 1);
+      return true;
+    }
+    char Chunk[4096];
+    ssize_t N = ::read(FD, Chunk, sizeof(Chunk));
+    if (N < 0 && errno == EINTR)
+      continue;
+    if (N <= 0)
+      return false;
+    Buffer.append(Chunk, N);
+  }
+}
+
+static bool readBytes(int FD, std::string &Buffer, size_t Size,
+                      std::string &Bytes) {
+  while (Buffer.size() < Size) {
+    char Chunk[4096];
+    ssize_t N = ::read(FD, Chunk, sizeof(Chunk));
+    if (N < 0 && errno == EINTR)
+      continue;
+    if (N <= 0)
+      return false;
+    Buffer.append(Chunk, N);
+  }
+  Bytes = Buffer.substr(0, Size);
+  Buffer.erase(0, Size);
+  return true;
+}
+
+static int openSocket(StringRef Path, sockaddr_un &Addr) {
+  if (Path.size() >= sizeof(Addr.sun_path)) {
+    llvm::errs() << "error: socket path too long: " << Path << '\n';
+    return -1;
+  }
+  memset(&Addr, 0, sizeof(Addr));
+  Addr.sun_family = AF_UNIX;
+  memcpy(Addr.sun_path, Path.data(), Path.size());
+  int FD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (FD < 0)
+    llvm::errs() << "error: cannot create socket: " << strerror(errno) << '\n';
+  return FD;
+}
+
+static int serveSocket(CompileServer &Server, StringRef Path) {
+  sockaddr_un Addr;
+  int ListenFD = openSocket(Path, Addr);
+  if (ListenFD < 0)
+    return 1;
+  llvm::sys::fs::remove(Path);
+  // Requests run arbitrary compilations as this user, so only this user may
+  // connect. The socket is created with mode 0600 rather than changed after
+  // bind(), which would leave a window in which others could open it.
+  mode_t OldMask = ::umask(0177);
+  int BindResult = ::bind(ListenFD, (sockaddr *)&Addr, sizeof(Addr));
+  ::umask(OldMask);
+  if (BindResult < 0 || ::listen(ListenFD, 16) < 0) {
+    llvm::errs() << "error: cannot listen on '" << Path
+                 << "': " << strerror(errno) << '\n';
+    ::close(ListenFD);
+    return 1;
+  }
+  llvm::sys::RemoveFileOnSignal(Path);
+
+  bool Done = false;
+  while (!Done) {
+    int FD = ::accept(ListenFD, nullptr, nullptr);
+    if (FD < 0) {
+      if (errno == EINTR)
+        continue;
+      llvm::errs() << "error: accept failed: " << strerror(errno) << '\n';
+      break;
+    }
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/false, /*unbuffered=*/false);
+    std::string Buffer, Line;
+    while (readLine(FD, Buffer, Line)) {
+      if (Line == ShutdownRequest) {
+        Done = true;
+        break;
+      }
+      Server.handleRequest(Line, OS);
+    }
+    OS.flush();
+    ::close(FD);
+  }
+
+  ::close(ListenFD);
+  llvm::sys::fs::remove(Path);
+  llvm::sys::DontRemoveFileOnSignal(Path);
+  return 0;
+}
+
+static int runClient(StringRef Path) {
+  sockaddr_un Addr;
+  int FD = openSocket(Path, Addr);
+  if (FD < 0)
+    return 1;
+  if (::connect(FD, (sockaddr *)&Addr, sizeof(Addr)) < 0) {
+    llvm::errs() << "error: cannot connect to '" << Path
+                 << "': " << strerror(errno) << '\n';
+    ::close(FD);
+    return 1;
+  }
+
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/false, /*unbuffered=*/false);
+    if (Shutdown) {
+      OS << ShutdownRequest << '\n';
+      OS.flush();
+      ::close(FD);
+      return 0;
+    }
+    SmallString<256> CWD;
+    llvm::sys::fs::current_path(CWD);
+    quoteArg(CWD, OS);
+    for (const std::string &Arg : CC1Args) {
+      OS << ' ';
+      quoteArg(Arg, OS);
+    }
+    OS << '\n';
+  }
+  ::shutdown(FD, SHUT_WR);
+
+  std::string Buffer, Header, Diagnostics;
+  int Status = 1;
+  size_t Size = 0;
+  if (!readLine(FD, Buffer, Header) ||
+      sscanf(Header.c_str(), "%d %zu", &Status, &Size) != 2 ||
+      !readBytes(FD, Buffer, Size, Diagnostics)) {
+    llvm::errs() << "error: the compile server did not respond\n";
+    ::close(FD);
+    return 1;
+  }
+  ::close(FD);
+  llvm::errs() << Diagnostics;
+  return Status;
+}
+#endif
+
+int main(int argc, const char **argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+  llvm::cl::ParseCommandLineOptions(argc, argv, "clang compile server\n");
+
+  if (Connect.getNumOccurrences() + Listen.getNumOccurrences() +
+          Stdio.getNumOccurrences() != 1) {
+    llvm::errs() << "error: exactly one of -listen, -connect and -stdio is "
+                    "required\n";
+    return 1;
+  }
+
+#ifdef LLVM_ON_UNIX
+  if (!Connect.empty())
+    return runClient(Connect);
+#else
+  if (!Stdio) {
+    llvm::errs() << "error: sockets are not supported on this platform\n";
+    return 1;
+  }
+#endif
+
+  llvm::InitializeAllTargets();
+  llvm::InitializeAllTargetMCs();
+  llvm::InitializeAllAsmPrinters();
+  llvm::InitializeAllAsmParsers();
+
+  CompileServer Server(argv[0], ImmutableDirs);
+  int Res = 0;
+#ifdef LLVM_ON_UNIX
+  if (!Listen.empty())
+    Res = serveSocket(Server, Listen);
+  else
+#endif
+    Res = serveStdio(Server);
+
+  if (PrintStats)
+    Server.printStats(llvm::errs());
+  return Res;
+}
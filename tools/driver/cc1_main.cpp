@@ -17,6 +17,7 @@
 #include "clang/CodeGen/ObjectFilePCHContainerOperations.h"
 #include "clang/Config/config.h"
 #include "clang/Driver/DriverDiagnostic.h"
+#include "clang/Driver/Job.h"
 #include "clang/Driver/Options.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/CompilerInvocation.h"
@@ -62,7 +63,14 @@ static void LLVMErrorHandler(void *UserData, const std::string &Message,
   // We cannot recover from llvm errors.  When reporting a fatal error, exit
   // with status 70 to generate crash diagnostics.  For BSD systems this is
   // defined as an internal software error.  Otherwise, exit with status 1.
-  exit(GenCrashDiag ? 70 : 1);
+  int ExitStatus = GenCrashDiag ? 70 : 1;
+
+  // When cc1 runs in the driver process, return the status to the driver
+  // instead, which then cleans up and generates crash diagnostics as it does
+  // for a cc1 process.
+  llvm::remove_fatal_error_handler();
+  driver::CC1Command::exitInProcessJob(ExitStatus);
+  exit(ExitStatus);
 }
 
 #ifdef LINK_POLLY_INTO_TOOLS
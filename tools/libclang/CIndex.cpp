@@ -37,6 +37,7 @@
 #include "clang/Lex/Lexer.h"
 #include "clang/Lex/PreprocessingRecord.h"
 #include "clang/Lex/Preprocessor.h"
+#include "clang/Sema/Sema.h"
 #include "clang/Serialization/SerializationDiagnostic.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
@@ -829,6 +830,10 @@ bool CursorVisitor::VisitFunctionDecl(FunctionDecl *ND) {
     // FIXME: Attributes?
   }
   
+  // Bodies that were skipped outside the main file are parsed on demand.
+  if (ND->isLateTemplateParsed() && AU->hasSema())
+    AU->getSema().LateParseFunctionBody(ND);
+
   if (ND->doesThisDeclarationHaveABody() && !ND->isLateTemplateParsed()) {
     if (CXXConstructorDecl *Constructor = dyn_cast<CXXConstructorDecl>(ND)) {
       // Find the initializers that were written in the source.
@@ -3414,6 +3419,11 @@ clang_parseTranslationUnit_Impl(CXIndex CIdx, const char *source_filename,
     Args->push_back("-detailed-preprocessing-record");
   }
 
+  if (options & CXTranslationUnit_SkipHeaderFunctionBodies) {
+    Args->push_back("-Xclang");
+    Args->push_back("-skip-header-function-bodies");
+  }
+
   // Suppress any editor placeholder diagnostics.
   Args->push_back("-fallow-editor-placeholders");
 
@@ -264,11 +264,12 @@ def create_analyze_parser(from_build_command):
         '-store',
         metavar='<model>',
         dest='store_model',
-        choices=['region', 'basic'],
+        choices=['region', 'hashed-region', 'basic'],
         help="""Specify the store model used by the analyzer. 'region'
-        specifies a field- sensitive store model. 'basic' which is far less
-        precise but can more quickly analyze code. 'basic' was the default
-        store model for checker-0.221 and earlier.""")
+        specifies a field- sensitive store model. 'hashed-region' is the
+        same model, with its bindings kept in hash array mapped tries.
+        'basic' which is far less precise but can more quickly analyze code.
+        'basic' was the default store model for checker-0.221 and earlier.""")
     advanced.add_argument(
         '--constraints',
         '-constraints',
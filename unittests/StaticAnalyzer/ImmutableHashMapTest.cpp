@@ -0,0 +1,161 @@
+//===- unittest/StaticAnalyzer/ImmutableHashMapTest.cpp -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "../../lib/StaticAnalyzer/Core/ImmutableHashMap.h"
+#include "llvm/ADT/DenseMap.h"
+#include "gtest/gtest.h"
+#include <vector>
+
+namespace clang {
+namespace ento {
+namespace {
+
+typedef ImmutableHashMap<unsigned, unsigned> MapTy;
+
+/// Compute the hash the map uses for \p K.
+unsigned getKeyHash(unsigned K) {
+  llvm::FoldingSetNodeID ID;
+  llvm::ImutProfileInfo<unsigned>::Profile(ID, K);
+  return ID.ComputeHash();
+}
+
+/// Find two keys whose full 32-bit hashes are equal.
+bool findCollidingKeys(unsigned &K1, unsigned &K2) {
+  llvm::DenseMap<unsigned, unsigned> KeyByHash;
+  for (unsigned K = 0; K != 1u << 24; ++K) {
+    auto Inserted = KeyByHash.insert(std::make_pair(getKeyHash(K), K));
+    if (!Inserted.second) {
+      K1 = Inserted.first->second;
+      K2 = K;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<std::pair<unsigned, unsigned>> getEntries(MapTy M) {
+  std::vector<std::pair<unsigned, unsigned>> Entries;
+  for (MapTy::iterator I = M.begin(), E = M.end(); I != E; ++I)
+    Entries.push_back(std::make_pair(I.getKey(), I.getData()));
+  return Entries;
+}
+
+void getProfile(MapTy M, llvm::FoldingSetNodeID &ID) { M.Profile(ID); }
+
+TEST(ImmutableHashMap, FullHashCollisions) {
+  unsigned K1, K2;
+  ASSERT_TRUE(findCollidingKeys(K1, K2));
+  ASSERT_EQ(getKeyHash(K1), getKeyHash(K2));
+
+  llvm::BumpPtrAllocator Alloc;
+  MapTy::Factory F(Alloc);
+  MapTy Empty = F.getEmptyMap();
+  MapTy Both = F.add(F.add(Empty, K1, 1), K2, 2);
+  EXPECT_EQ(Both, F.add(F.add(Empty, K2, 2), K1, 1));
+  ASSERT_TRUE(Both.lookup(K1));
+  EXPECT_EQ(1u, *Both.lookup(K1));
+  ASSERT_TRUE(Both.lookup(K2));
+  EXPECT_EQ(2u, *Both.lookup(K2));
+  EXPECT_EQ(2u, getEntries(Both).size());
+
+  // Replacing a colliding entry keeps the other one.
+  MapTy Replaced = F.add(Both, K2, 3);
+  EXPECT_EQ(1u, *Replaced.lookup(K1));
+  EXPECT_EQ(3u, *Replaced.lookup(K2));
+
+  // A key with a different hash does not match the colliding ones.
+  unsigned Other = K1 + 1;
+  while (Other == K2 || getKeyHash(Other) == getKeyHash(K1))
+    ++Other;
+  EXPECT_FALSE(Both.lookup(Other));
+  EXPECT_EQ(Both, F.remove(Both, Other));
+
+  // Removing one of the colliding keys folds the trie back into the map that
+  // only ever held the other one.
+  EXPECT_EQ(F.add(Empty, K2, 2), F.remove(Both, K1));
+  EXPECT_EQ(F.add(Empty, K1, 1), F.remove(Both, K2));
+  EXPECT_EQ(Empty, F.remove(F.remove(Both, K1), K2));
+}
+
+TEST(ImmutableHashMap, CanonicalAfterRemove) {
+  llvm::BumpPtrAllocator Alloc;
+  MapTy::Factory F(Alloc);
+  MapTy Small = F.getEmptyMap();
+  for (unsigned K = 0; K != 500; ++K)
+    Small = F.add(Small, K, K * 2);
+
+  // Adding keys and removing them again gives back the same root.
+  MapTy Large = Small;
+  for (unsigned K = 500; K != 1000; ++K)
+    Large = F.add(Large, K, K * 2);
+  MapTy Removed = Large;
+  for (unsigned K = 999; K >= 500; --K)
+    Removed = F.remove(Removed, K);
+  EXPECT_EQ(Small.getRoot(), Removed.getRoot());
+
+  llvm::FoldingSetNodeID SmallID, RemovedID;
+  getProfile(Small, SmallID);
+  getProfile(Removed, RemovedID);
+  EXPECT_EQ(SmallID, RemovedID);
+  llvm::FoldingSetNodeID SmallNodeID, RemovedNodeID;
+  Small.getRoot()->Profile(SmallNodeID);
+  Removed.getRoot()->Profile(RemovedNodeID);
+  EXPECT_EQ(SmallNodeID, RemovedNodeID);
+
+  // The order of the updates does not matter either.
+  MapTy Reversed = F.getEmptyMap();
+  for (unsigned K = 1000; K != 0; --K)
+    Reversed = F.add(Reversed, K - 1, (K - 1) * 2);
+  EXPECT_EQ(Large.getRoot(), Reversed.getRoot());
+
+  // Removing every key gives the empty map.
+  for (unsigned K = 0; K != 1000; ++K)
+    Reversed = F.remove(Reversed, K);
+  EXPECT_TRUE(Reversed.isEmpty());
+  EXPECT_EQ(F.getEmptyMap(), Reversed);
+}
+
+TEST(ImmutableHashMap, Iteration) {
+  unsigned K1, K2;
+  ASSERT_TRUE(findCollidingKeys(K1, K2));
+
+  llvm::BumpPtrAllocator Alloc;
+  MapTy::Factory F(Alloc);
+  EXPECT_TRUE(getEntries(F.getEmptyMap()).empty());
+
+  MapTy M = F.getEmptyMap();
+  std::vector<unsigned> Keys;
+  for (unsigned K = 0; K != 1000; ++K)
+    Keys.push_back(K);
+  Keys.push_back(K1);
+  Keys.push_back(K2);
+  for (unsigned K : Keys)
+    M = F.add(M, K, K + 1);
+
+  // Every entry is visited exactly once.
+  std::vector<std::pair<unsigned, unsigned>> Entries = getEntries(M);
+  ASSERT_EQ(Keys.size(), Entries.size());
+  llvm::DenseMap<unsigned, unsigned> Seen;
+  for (const auto &E : Entries) {
+    EXPECT_EQ(E.first + 1, E.second);
+    EXPECT_TRUE(Seen.insert(E).second);
+  }
+  for (unsigned K : Keys)
+    EXPECT_EQ(1u, Seen.count(K));
+
+  // The order only depends on the keys, not on the order of the updates.
+  MapTy Reversed = F.getEmptyMap();
+  for (auto I = Keys.rbegin(), E = Keys.rend(); I != E; ++I)
+    Reversed = F.add(Reversed, *I, *I + 1);
+  EXPECT_EQ(Entries, getEntries(Reversed));
+}
+
+} // end anonymous namespace
+} // end namespace ento
+} // end namespace clang
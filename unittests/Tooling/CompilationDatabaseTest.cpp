@@ -13,7 +13,9 @@
 #include "clang/Tooling/FileMatchTrie.h"
 #include "clang/Tooling/JSONCompilationDatabase.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 namespace clang {
@@ -195,6 +197,76 @@ TEST(JSONCompilationDatabase, ArgumentsPreferredOverCommand) {
    EXPECT_EQ(Arguments, FoundCommand.CommandLine[0]) << ErrorMessage;
 }
 
+TEST(JSONCompilationDatabase, DecodesEscapedFileNames) {
+  std::string ErrorMessage;
+  CompileCommand FoundCommand = findCompileArgsInJsonDatabase(
+      "//net/dir/f\xc3\xa9\xf0\x9f\x98\x80.cc",
+      "[{\"directory\":\"\\/\\/net\\/dir\","
+      "\"command\":\"command\","
+      "\"file\":\"f\\u00e9\\ud83d\\ude00.cc\"}]",
+      ErrorMessage);
+  EXPECT_EQ("//net/dir", FoundCommand.Directory) << ErrorMessage;
+  ASSERT_EQ(1u, FoundCommand.CommandLine.size()) << ErrorMessage;
+  EXPECT_EQ("command", FoundCommand.CommandLine[0]) << ErrorMessage;
+}
+
+TEST(JSONCompilationDatabase, ReadsYAMLDatabase) {
+  std::string ErrorMessage;
+  CompileCommand FoundCommand = findCompileArgsInJsonDatabase(
+      "//net/dir/file",
+      "- directory: //net/dir\n"
+      "  arguments: [clang, -c, file]\n"
+      "  file: file\n",
+      ErrorMessage);
+  EXPECT_EQ("//net/dir", FoundCommand.Directory) << ErrorMessage;
+  ASSERT_EQ(3u, FoundCommand.CommandLine.size()) << ErrorMessage;
+  EXPECT_EQ("-c", FoundCommand.CommandLine[1]) << ErrorMessage;
+}
+
+TEST(JSONCompilationDatabase, CachesIndex) {
+  SmallString<128> Dir;
+  ASSERT_FALSE(
+      llvm::sys::fs::createUniqueDirectory("json-compilation-database", Dir));
+  SmallString<128> DatabasePath(Dir);
+  llvm::sys::path::append(DatabasePath, "compile_commands.json");
+  std::string IndexPath = (DatabasePath + ".index").str();
+
+  auto WriteDatabase = [&](StringRef Command) {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(DatabasePath, EC, llvm::sys::fs::F_Text);
+    ASSERT_FALSE(EC);
+    OS << "[{\"directory\":\"//net/dir\",\"command\":\"" << Command
+       << "\",\"file\":\"file\"}]";
+  };
+  auto GetCommand = [&]() -> std::string {
+    std::string ErrorMessage;
+    std::unique_ptr<JSONCompilationDatabase> Database =
+        JSONCompilationDatabase::loadFromFile(DatabasePath, ErrorMessage,
+                                              JSONCommandLineSyntax::Gnu,
+                                              /*CacheIndex=*/true);
+    if (!Database)
+      return ErrorMessage;
+    std::vector<CompileCommand> Commands =
+        Database->getCompileCommands("//net/dir/file");
+    if (Commands.size() != 1 || Commands[0].CommandLine.empty())
+      return "<no command>";
+    return Commands[0].CommandLine[0];
+  };
+
+  WriteDatabase("first");
+  EXPECT_EQ("first", GetCommand());
+  EXPECT_TRUE(llvm::sys::fs::exists(IndexPath));
+  EXPECT_EQ("first", GetCommand());
+
+  // A database of a different size invalidates the cache.
+  WriteDatabase("second-command");
+  EXPECT_EQ("second-command", GetCommand());
+
+  llvm::sys::fs::remove(IndexPath);
+  llvm::sys::fs::remove(DatabasePath);
+  llvm::sys::fs::remove(Dir);
+}
+
 struct FakeComparator : public PathComparator {
   ~FakeComparator() override {}
   bool equivalent(StringRef FileA, StringRef FileB) const override {
@@ -0,0 +1,41 @@
+#!/usr/bin/env python
+
+"""
+Merge the template instantiation profiles written by -ftemplate-profile for
+several translation units into a single profile, most expensive first.
+
+Usage: merge-template-profiles.py <profile>... > merged-profile
+"""
+
+from __future__ import print_function
+
+import collections
+import sys
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__.strip(), file=sys.stderr)
+        return 1
+
+    totals = collections.defaultdict(lambda: [0, 0, 0])
+    for path in sys.argv[1:]:
+        with open(path) as f:
+            for line in f:
+                fields = line.rstrip('\n').split('\t', 4)
+                if len(fields) != 5:
+                    continue
+                activity, count, usecs, nbytes, name = fields
+                total = totals[(activity, name)]
+                total[0] += int(count)
+                total[1] += int(usecs)
+                total[2] += int(nbytes)
+
+    for (activity, name), (count, usecs, nbytes) in sorted(
+            totals.items(), key=lambda item: (-item[1][1], -item[1][2])):
+        print('\t'.join([activity, str(count), str(usecs), str(nbytes), name]))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())